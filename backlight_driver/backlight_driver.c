@@ -315,3 +315,8 @@ void BACKLIGHT_SetIntensity(uint8_t intensity)
     OCR_GREEN = green;
     OCR_BLUE = blue;
 }
+
+uint8_t BACKLIGHT_GetIntensity(void)
+{
+    return BACKLIGHT_intensity;
+}
@@ -72,6 +72,7 @@ void BACKLIGHT_SetGreen(uint8_t green);  //!< Set the intensity level for green
 void BACKLIGHT_SetBlue(uint8_t blue);  //!< Set the intensity level for blue LED.
 void BACKLIGHT_SetRGB(uint8_t red, uint8_t green , uint8_t blue);  //!< Set the intensity level for all RGB LED's.
 void BACKLIGHT_SetIntensity(uint8_t intensity);  //!< Dim all RGB LED's with value given to the function.
+uint8_t BACKLIGHT_GetIntensity(void);  //!< Return intensity last given to BACKLIGHT_SetIntensity.
 
 
 
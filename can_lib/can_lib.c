@@ -0,0 +1,495 @@
+// This file has been prepared for Doxygen automatic documentation generation.
+/*! \file *********************************************************************
+ *
+ * \brief  CAN frame dispatch source file
+ *
+ *         Route numbers below the exact route count are exact routes, the
+ *         ones above are range routes. Route numbers are only valid for the
+ *         table they were found in.
+ *
+ *         For the acceptance filter, each route is a cube: the ID bits it
+ *         fixes and the bits it does not care about. An exact route fixes
+ *         all 11 bits. Merging cubes marks the bits they disagree on as
+ *         don't care, so a group of routes is covered by one cube and the
+ *         IDs let through are 2 to the number of don't care bits. Routes
+ *         are read from flash for every split tried, so the search needs
+ *         no SRAM per route.
+ *
+ *****************************************************************************/
+
+#include "can_lib.h"
+#include <stddef.h>
+
+
+
+/********************************
+ * Private constants and defines
+ ********************************/
+
+#define CAN_ID_BITS 11  //!< Bits in an 11-bit ID.
+#define CAN_FILTER_DONT_CARE_LOW 0x1F  //!< Filter half bits below the ID: RTR and data nibble, not compared.
+
+//! Ways of splitting routes into two filter groups.
+enum CAN_split_enum
+{
+	CAN_SPLIT_SUBSET,  //!< Route n goes to second group if bit n of parameter is set.
+	CAN_SPLIT_BIT,  //!< Routes with given ID bit set go to second group.
+	CAN_SPLIT_INDEX  //!< Routes from given index on go to second group.
+};
+
+
+
+/*********************
+ * Types and typedefs
+ *********************/
+
+//! Set of 11-bit IDs given by fixed bits and don't care bits.
+typedef struct CAN_cube_struct
+{
+	uint16_t code;  //!< Value of fixed bits, don't care bits cleared.
+	uint16_t dontCare;  //!< Bits that may have any value.
+	bool used;  //!< False for the empty set.
+} CAN_cube_t;
+
+
+
+/********************
+ * Private variables
+ ********************/
+
+static CAN_route_t const CAL_PGM(* CAN_routes);  //!< Exact routes of selected table.
+static uint8_t CAN_routeCount;  //!< Number of exact routes.
+static CAN_maskRoute_t const CAL_PGM(* CAN_maskRoutes);  //!< Range routes of selected table.
+static uint8_t CAN_maskRouteCount;  //!< Number of range routes.
+
+
+
+/*******************************
+ * Internal function prototypes
+ *******************************/
+
+//! Get IDs of a route as a cube. Returns false if the route needs 29-bit IDs.
+static bool CAN_GetCube( uint8_t route, CAN_cube_t * cube );
+//! Add a cube to the smallest cube covering a group.
+static void CAN_MergeCube( CAN_cube_t * group, CAN_cube_t const * cube );
+//! Get number of IDs in a cube.
+static uint16_t CAN_CubeSize( CAN_cube_t const * cube );
+//! Get number of IDs in either of two cubes.
+static uint16_t CAN_UnionSize( CAN_cube_t const * first, CAN_cube_t const * second );
+//! Split routes into two groups and get the cube covering each.
+static void CAN_Split( uint8_t kind, uint16_t parameter, CAN_cube_t * first, CAN_cube_t * second );
+//! Try splits with parameters 0 to last in given steps, keeping the best one.
+static void CAN_TrySplits( uint8_t kind, uint8_t step, uint16_t last, CAN_cube_t best[2], uint16_t * accepted );
+//! Get filter register half for a cube.
+static uint16_t CAN_FilterCode( CAN_cube_t const * cube );
+//! Get filter mask register half for a cube.
+static uint16_t CAN_FilterMask( CAN_cube_t const * cube );
+
+
+
+/***************************
+ * Function implementations
+ ***************************/
+
+/*!
+ *  The table pointers are copied to SRAM so lookups do not read them from
+ *  flash every time. The sort order is checked once here, since a wrong
+ *  order would make the binary search miss routes silently.
+ *
+ * \param  table  Dispatch table, or NULL for none
+ *
+ * \return  True if table is usable
+ */
+bool CAN_SetDispatchTable( CAN_dispatch_t const CAL_PGM(* table) )
+{
+	CAN_routeCount = 0;
+	CAN_maskRouteCount = 0;
+	if (table == NULL) {
+		return true;
+	}
+
+	CAN_route_t const CAL_PGM(* routes) = (CAN_route_t const CAL_PGM(*)) CAL_pgm_read_pvoid( &table->routes );
+	uint8_t const routeCount = CAL_pgm_read_byte( &table->routeCount );
+	for (uint8_t index = 1; index < routeCount; ++index) {
+		if (CAL_pgm_read_dword( &routes[index - 1].key ) >= CAL_pgm_read_dword( &routes[index].key )) {
+			return false;
+		}
+	}
+
+	CAN_routes = routes;
+	CAN_routeCount = routeCount;
+	CAN_maskRoutes = (CAN_maskRoute_t const CAL_PGM(*)) CAL_pgm_read_pvoid( &table->maskRoutes );
+	CAN_maskRouteCount = CAL_pgm_read_byte( &table->maskRouteCount );
+	return true;
+}
+
+
+/*!
+ *  Takes at most log2 of the exact route count key compares, plus one
+ *  compare per range route when no exact route matches.
+ *
+ * \param  id     11 or 29-bit identifier
+ * \param  flags  Frame flags, only CAN_FLAG_EXTENDED is used
+ */
+uint8_t CAN_FindRoute( uint32_t id, uint8_t flags )
+{
+	uint32_t const key = ((flags & CAN_FLAG_EXTENDED) != 0x00) ? CAN_EXT( id ) : CAN_STD( id );
+
+	uint8_t low = 0;
+	uint8_t high = CAN_routeCount;
+	while (low < high) {
+		uint8_t const middle = (low + high) / 2;
+		uint32_t const routeKey = CAL_pgm_read_dword( &CAN_routes[middle].key );
+		if (routeKey == key) {
+			return middle;
+		} else if (routeKey < key) {
+			low = middle + 1;
+		} else {
+			high = middle;
+		}
+	}
+
+	for (uint8_t index = 0; index < CAN_maskRouteCount; ++index) {
+		uint32_t const mask = CAL_pgm_read_dword( &CAN_maskRoutes[index].mask );
+		if ((key & mask) == CAL_pgm_read_dword( &CAN_maskRoutes[index].key )) {
+			return CAN_routeCount + index;
+		}
+	}
+
+	return CAN_NO_ROUTE;
+}
+
+
+/*!
+ *  Remote requests carry no data and are not passed to handlers.
+ *
+ * \param  route  Route number from CAN_FindRoute, CAN_NO_ROUTE is ignored
+ * \param  frame  Received frame
+ */
+void CAN_Dispatch( uint8_t route, CAN_frame_t const * frame )
+{
+	if ((frame->flags & CAN_FLAG_RTR) != 0x00) {
+		return;
+	}
+
+	CAN_Handler_t handler;
+	if (route < CAN_routeCount) {
+		handler = (CAN_Handler_t) CAL_pgm_read_pvoid( &CAN_routes[route].handler );
+	} else if ((route != CAN_NO_ROUTE) && (route - CAN_routeCount < CAN_maskRouteCount)) {
+		handler = (CAN_Handler_t) CAL_pgm_read_pvoid( &CAN_maskRoutes[route - CAN_routeCount].handler );
+	} else {
+		return;
+	}
+
+	if (handler != NULL) {
+		handler( frame );
+	}
+}
+
+
+void CAN_DispatchFrame( CAN_frame_t const * frame )
+{
+	CAN_Dispatch( CAN_FindRoute( frame->id, frame->flags ), frame );
+}
+
+
+uint8_t CAN_GetRouteCount( void )
+{
+	return CAN_routeCount + CAN_maskRouteCount;
+}
+
+
+/*!
+ *  Exact routes compare every key bit, so their mask has all bits set.
+ *
+ * \param  route  Route number as returned by CAN_FindRoute
+ * \param  key    Set to CAN_STD or CAN_EXT key of route
+ * \param  mask   Set to key bits compared
+ */
+bool CAN_GetRouteKey( uint8_t route, uint32_t * key, uint32_t * mask )
+{
+	if (route < CAN_routeCount) {
+		*key = CAL_pgm_read_dword( &CAN_routes[route].key );
+		*mask = 0xFFFFFFFFUL;
+	} else if ((route != CAN_NO_ROUTE) && (route - CAN_routeCount < CAN_maskRouteCount)) {
+		*key = CAL_pgm_read_dword( &CAN_maskRoutes[route - CAN_routeCount].key );
+		*mask = CAL_pgm_read_dword( &CAN_maskRoutes[route - CAN_routeCount].mask );
+	} else {
+		return false;
+	}
+	return true;
+}
+
+
+/*!
+ *  With up to CAN_FILTER_EXHAUSTIVE routes every split is tried, giving
+ *  the best filter there is. With more routes the candidates are a split
+ *  on each ID bit and a split at each position in key order, since routes
+ *  close in ID tend to share high bits.
+ *
+ *  A table with routes for 29-bit IDs gets a filter accepting everything,
+ *  since in dual filter mode the same registers would be compared with
+ *  the top 16 bits of 29-bit IDs. So does a table without routes.
+ *  Overlapping routes are counted twice in CAN_filter_t::needed.
+ *
+ * \param  filter  Where to save the filter
+ */
+void CAN_ComputeFilter( CAN_filter_t * filter )
+{
+	uint8_t const count = CAN_routeCount + CAN_maskRouteCount;
+	filter->code = 0x00000000;
+	filter->mask = CAN_FILTER_ACCEPT_ALL;
+	filter->accepted = CAN_MAX_STD_ID + 1;
+	filter->needed = 0;
+
+	CAN_cube_t cube;
+	for (uint8_t route = 0; route < count; ++route) {
+		if (CAN_GetCube( route, &cube ) == false) {
+			filter->needed = CAN_MAX_STD_ID + 1;
+			return;
+		}
+		filter->needed += CAN_CubeSize( &cube );
+	}
+	if (count == 0) {
+		return;
+	}
+
+	CAN_cube_t best[2];
+	uint16_t accepted = UINT16_MAX;
+	if (count <= CAN_FILTER_EXHAUSTIVE) {
+		// Route 0 always in first group, the others either way.
+		CAN_TrySplits( CAN_SPLIT_SUBSET, 2, (1 << count) - 2, best, &accepted );
+	} else {
+		CAN_TrySplits( CAN_SPLIT_BIT, 1, CAN_ID_BITS - 1, best, &accepted );
+		CAN_TrySplits( CAN_SPLIT_INDEX, 1, count - 1, best, &accepted );
+	}
+
+	// An empty group gets the same filter as the other one.
+	if (best[0].used == false) {
+		best[0] = best[1];
+	} else if (best[1].used == false) {
+		best[1] = best[0];
+	}
+	filter->code = ((uint32_t) CAN_FilterCode( &best[0] ) << 16) | CAN_FilterCode( &best[1] );
+	filter->mask = ((uint32_t) CAN_FilterMask( &best[0] ) << 16) | CAN_FilterMask( &best[1] );
+	filter->accepted = accepted;
+}
+
+
+/*!
+ *  Timestamps wrap at CAN_TIMESTAMP_WRAP, so this is only correct for
+ *  timestamps less than one wrap apart.
+ *
+ * \param  newer  Later timestamp
+ * \param  older  Earlier timestamp
+ */
+uint16_t CAN_TimestampDelta( uint16_t newer, uint16_t older )
+{
+	return (newer >= older) ? (newer - older) : (uint16_t) (newer + CAN_TIMESTAMP_WRAP - older);
+}
+
+
+void CAN_InitTiming( CAN_timing_t * timing )
+{
+	timing->interval = 0;
+	timing->latency = 0;
+	timing->count = 0;
+}
+
+
+/*!
+ *  The interval is a running average, so a frame lost now and then only
+ *  nudges the rate. Latency is the arrival minus timestamp offset of this
+ *  frame compared to the lowest offset of the previous window, starting a
+ *  new window every CAN_TIMING_WINDOW frames lets the baseline follow the
+ *  drift between the adapter clock and the local clock.
+ *
+ * \param  timing   Timing of the message
+ * \param  frame    Received frame
+ * \param  arrival  Local time of arrival in ms, any 32-bit count
+ */
+void CAN_UpdateTiming( CAN_timing_t * timing, CAN_frame_t const * frame, uint32_t arrival )
+{
+	if ((frame->flags & CAN_FLAG_TIMESTAMP) == 0x00) {
+		return;
+	}
+
+	uint16_t const stamp = frame->timestamp;
+	uint16_t const offset = CAN_TimestampDelta( arrival % CAN_TIMESTAMP_WRAP, stamp );
+
+	if (timing->count == 0) {
+		timing->baseOffset = offset;
+		timing->windowOffset = offset;
+		timing->count = 1;
+	} else {
+		uint16_t delta = CAN_TimestampDelta( stamp, timing->lastStamp );
+		if (delta > CAN_TIMING_MAX_INTERVAL) {
+			delta = CAN_TIMING_MAX_INTERVAL;
+		}
+		if (timing->interval == 0) {
+			timing->interval = delta << CAN_TIMING_AVERAGE_SHIFT;
+		} else {
+			timing->interval = timing->interval - (timing->interval >> CAN_TIMING_AVERAGE_SHIFT) + delta;
+		}
+
+		// Offsets are modulo the wrap, more than half a wrap ahead means behind.
+		if (CAN_TimestampDelta( offset, timing->windowOffset ) > CAN_TIMESTAMP_WRAP / 2) {
+			timing->windowOffset = offset;
+		}
+		if (++timing->count > CAN_TIMING_WINDOW) {
+			timing->baseOffset = timing->windowOffset;
+			timing->windowOffset = offset;
+			timing->count = 1;
+		}
+	}
+
+	uint16_t const latency = CAN_TimestampDelta( offset, timing->baseOffset );
+	timing->latency = (latency > CAN_TIMESTAMP_WRAP / 2) ? 0 : latency;
+	timing->lastStamp = stamp;
+}
+
+
+uint16_t CAN_GetRate( CAN_timing_t const * timing )
+{
+	if (timing->interval == 0) {
+		return 0;
+	}
+	return (uint16_t) ((10000UL << CAN_TIMING_AVERAGE_SHIFT) / timing->interval);
+}
+
+
+/*!
+ *  Route numbers are as returned by CAN_FindRoute, exact routes first.
+ *  Range routes that do not compare the CAN_KEY_EXTENDED bit match 29-bit
+ *  IDs too.
+ */
+static bool CAN_GetCube( uint8_t route, CAN_cube_t * cube )
+{
+	uint32_t key;
+	uint32_t mask = CAN_KEY_EXTENDED | CAN_MAX_EXT_ID;
+	if (route < CAN_routeCount) {
+		key = CAL_pgm_read_dword( &CAN_routes[route].key );
+	} else {
+		route -= CAN_routeCount;
+		key = CAL_pgm_read_dword( &CAN_maskRoutes[route].key );
+		mask = CAL_pgm_read_dword( &CAN_maskRoutes[route].mask );
+	}
+
+	if (((key & CAN_KEY_EXTENDED) != 0x00) || ((mask & CAN_KEY_EXTENDED) == 0x00)) {
+		return false;
+	}
+	cube->dontCare = (uint16_t) ~mask & CAN_MAX_STD_ID;
+	cube->code = (uint16_t) key & CAN_MAX_STD_ID & ~cube->dontCare;
+	cube->used = true;
+	return true;
+}
+
+
+static void CAN_MergeCube( CAN_cube_t * group, CAN_cube_t const * cube )
+{
+	if (group->used == false) {
+		*group = *cube;
+		return;
+	}
+	group->dontCare |= cube->dontCare | (group->code ^ cube->code);
+	group->code &= ~group->dontCare;
+}
+
+
+static uint16_t CAN_CubeSize( CAN_cube_t const * cube )
+{
+	if (cube->used == false) {
+		return 0;
+	}
+	uint16_t size = 1;
+	for (uint16_t bits = cube->dontCare; bits != 0; bits >>= 1) {
+		if ((bits & 0x01) != 0x00) {
+			size <<= 1;
+		}
+	}
+	return size;
+}
+
+
+/*!
+ *  Two cubes overlap unless a bit fixed in both has different values. The
+ *  overlap is then the cube with the don't care bits they have in common.
+ */
+static uint16_t CAN_UnionSize( CAN_cube_t const * first, CAN_cube_t const * second )
+{
+	uint16_t size = CAN_CubeSize( first ) + CAN_CubeSize( second );
+	if (first->used && second->used) {
+		uint16_t const conflict = (first->code ^ second->code) & ~first->dontCare & ~second->dontCare;
+		if (conflict == 0) {
+			CAN_cube_t const overlap = { first->code | second->code, first->dontCare & second->dontCare, true };
+			size -= CAN_CubeSize( &overlap );
+		}
+	}
+	return size;
+}
+
+
+static void CAN_Split( uint8_t kind, uint16_t parameter, CAN_cube_t * first, CAN_cube_t * second )
+{
+	first->used = false;
+	second->used = false;
+
+	uint8_t const count = CAN_routeCount + CAN_maskRouteCount;
+	CAN_cube_t cube;
+	for (uint8_t route = 0; route < count; ++route) {
+		CAN_GetCube( route, &cube );
+		bool toSecond;
+		switch (kind) {
+			case CAN_SPLIT_SUBSET:
+				toSecond = ((parameter >> route) & 0x01) != 0x00;
+				break;
+
+			case CAN_SPLIT_BIT:
+				toSecond = ((cube.code >> parameter) & 0x01) != 0x00;
+				break;
+
+			default:
+				toSecond = (route >= parameter);
+				break;
+		}
+		CAN_MergeCube( toSecond ? second : first, &cube );
+	}
+}
+
+
+/*!
+ *  Ties keep the split found first.
+ */
+static void CAN_TrySplits( uint8_t kind, uint8_t step, uint16_t last, CAN_cube_t best[2], uint16_t * accepted )
+{
+	CAN_cube_t first;
+	CAN_cube_t second;
+	for (uint16_t parameter = 0; parameter <= last; parameter += step) {
+		CAN_Split( kind, parameter, &first, &second );
+		uint16_t const size = CAN_UnionSize( &first, &second );
+		if (size < *accepted) {
+			*accepted = size;
+			best[0] = first;
+			best[1] = second;
+		}
+	}
+}
+
+
+/*!
+ *  In dual filter mode each filter half holds ID bits 10 to 0 in its bits
+ *  15 to 5, then the RTR bit and a data nibble, which are not compared.
+ */
+static uint16_t CAN_FilterCode( CAN_cube_t const * cube )
+{
+	return cube->code << CAN_FILTER_ID_SHIFT;
+}
+
+
+static uint16_t CAN_FilterMask( CAN_cube_t const * cube )
+{
+	return (cube->dontCare << CAN_FILTER_ID_SHIFT) | CAN_FILTER_DONT_CARE_LOW;
+}
+
+
+// end of file
@@ -0,0 +1,166 @@
+// This file has been prepared for Doxygen automatic documentation generation.
+/*! \file *********************************************************************
+ *
+ * \brief  CAN frame definitions and ID dispatch header file
+ *
+ *         Binary CAN frame as passed from the serial ingest to the frame
+ *         handlers, independent of how it was received.
+ *
+ *         Frames are routed to handlers through a dispatch table in flash.
+ *         Exact IDs are kept sorted by key, the ID with CAN_KEY_EXTENDED set
+ *         for 29-bit IDs, and found by binary search. ID ranges given by a
+ *         mask are kept in a second, short list that is searched in order
+ *         when no exact route matches.
+ *
+ *         Routes are looked up as soon as the ID is known. The route number
+ *         found is then used to call the handler without a second search,
+ *         and frames with no route can be dropped before their data is
+ *         even received.
+ *
+ *         Adapter timestamps give message rates free of the delays in the
+ *         serial link and the main loop. CAN_UpdateTiming averages the
+ *         interval between timestamps of one message, and compares them to
+ *         the local arrival time to estimate latency. Since the two clocks
+ *         are not synchronized, latency is relative to the fastest frame of
+ *         the previous CAN_TIMING_WINDOW frames.
+ *
+ *         CAN_ComputeFilter derives an acceptance filter for an SJA1000
+ *         based adapter from the dispatch table, so frames nobody handles
+ *         are dropped before they reach the serial link. The adapter runs
+ *         the SJA1000 in dual filter mode, where each of two filters gives
+ *         a code and a don't care mask for the 11-bit ID. The routes are
+ *         split in two groups, each covered by one filter, choosing the
+ *         split that lets the fewest IDs through.
+ *
+ *****************************************************************************/
+#ifndef CAN_LIB_H
+#define CAN_LIB_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <cal.h>
+
+
+
+/************************
+ * Constants and defines
+ ************************/
+
+#define CAN_MAX_DLC 8  //!< Max data bytes in a frame.
+#define CAN_MAX_STD_ID 0x7FFUL  //!< Highest 11-bit identifier.
+#define CAN_MAX_EXT_ID 0x1FFFFFFFUL  //!< Highest 29-bit identifier.
+
+#define CAN_FLAG_EXTENDED (1<<0)  //!< Frame has a 29-bit identifier.
+#define CAN_FLAG_RTR      (1<<1)  //!< Remote transmission request, no data.
+#define CAN_FLAG_TIMESTAMP (1<<2)  //!< Timestamp field is valid.
+
+#define CAN_KEY_EXTENDED 0x80000000UL  //!< Dispatch key bit for 29-bit IDs.
+#define CAN_STD(id) ((uint32_t) (id))  //!< Dispatch key of an 11-bit ID.
+#define CAN_EXT(id) ((uint32_t) (id) | CAN_KEY_EXTENDED)  //!< Dispatch key of a 29-bit ID.
+
+#define CAN_NO_ROUTE 0xFF  //!< Route number for IDs without a handler.
+
+#define CAN_TIMESTAMP_WRAP 60000U  //!< Adapter timestamps count ms from 0 to this minus one.
+#define CAN_TIMING_AVERAGE_SHIFT 3  //!< Interval average weight is 1 / 2^shift.
+#define CAN_TIMING_MAX_INTERVAL 8191U  //!< Longer intervals are averaged as this, ms.
+#define CAN_TIMING_WINDOW 64  //!< Frames per latency baseline window.
+
+#define CAN_FILTER_EXHAUSTIVE 10  //!< Up to this many routes, every split into two filters is tried.
+#define CAN_FILTER_ID_SHIFT 5  //!< Position of the 11-bit ID in each 16-bit filter half.
+#define CAN_FILTER_ACCEPT_ALL 0xFFFFFFFFUL  //!< Filter mask comparing no bits.
+
+
+
+/*********************
+ * Types and typedefs
+ *********************/
+
+//! One CAN frame.
+typedef struct CAN_frame_struct
+{
+	uint32_t id;  //!< 11 or 29-bit identifier.
+	uint8_t flags;  //!< Combination of CAN_FLAG_* flags.
+	uint8_t dlc;  //!< Data length code, 0 to CAN_MAX_DLC.
+	uint16_t timestamp;  //!< Adapter timestamp in ms, if CAN_FLAG_TIMESTAMP is set.
+	uint8_t data[CAN_MAX_DLC];  //!< Data bytes, dlc of them valid.
+} CAN_frame_t;
+
+typedef void (* CAN_Handler_t)( CAN_frame_t const * frame );  //!< Frame handler callback.
+
+//! Route for one exact ID, stored in flash.
+typedef struct CAN_route_struct
+{
+	uint32_t key;  //!< CAN_STD or CAN_EXT key.
+	CAN_Handler_t handler;  //!< Handler for frames with this ID.
+} CAN_route_t;
+
+//! Route for a range of IDs, stored in flash.
+typedef struct CAN_maskRoute_struct
+{
+	uint32_t key;  //!< CAN_STD or CAN_EXT key, bits outside mask cleared.
+	uint32_t mask;  //!< Key bits that must match, include CAN_KEY_EXTENDED.
+	CAN_Handler_t handler;  //!< Handler for frames with matching ID.
+} CAN_maskRoute_t;
+
+//! Timing of one message, from adapter timestamps. Initialize with CAN_InitTiming.
+typedef struct CAN_timing_struct
+{
+	uint16_t lastStamp;  //!< Timestamp of previous frame.
+	uint16_t interval;  //!< Averaged interval between frames in ms, times 2^CAN_TIMING_AVERAGE_SHIFT.
+	uint16_t latency;  //!< Delay of last frame beyond the baseline, ms.
+	uint16_t baseOffset;  //!< Baseline arrival minus timestamp, from previous window.
+	uint16_t windowOffset;  //!< Lowest arrival minus timestamp in current window.
+	uint8_t count;  //!< Frames in current window, 0 before first frame.
+} CAN_timing_t;
+
+//! SJA1000 dual acceptance filter, as set with the SLCAN M and m commands.
+typedef struct CAN_filter_struct
+{
+	uint32_t code;  //!< Acceptance code ACR0 to ACR3, ACR0 in the top byte.
+	uint32_t mask;  //!< Acceptance mask AMR0 to AMR3, set bits are not compared.
+	uint16_t accepted;  //!< 11-bit IDs let through.
+	uint16_t needed;  //!< 11-bit IDs with a route.
+} CAN_filter_t;
+
+//! Dispatch table, stored in flash.
+typedef struct CAN_dispatch_struct
+{
+	CAN_route_t const CAL_PGM(* routes);  //!< Exact routes, sorted by key.
+	uint8_t routeCount;  //!< Number of exact routes.
+	CAN_maskRoute_t const CAL_PGM(* maskRoutes);  //!< Range routes, first match wins, or NULL.
+	uint8_t maskRouteCount;  //!< Number of range routes.
+} CAN_dispatch_t;
+
+
+
+/**********************
+ * Function prototypes
+ **********************/
+
+//! Select dispatch table. Returns false and selects none if exact routes are not sorted.
+bool CAN_SetDispatchTable( CAN_dispatch_t const CAL_PGM(* table) );
+//! Find route number for an ID, or CAN_NO_ROUTE.
+uint8_t CAN_FindRoute( uint32_t id, uint8_t flags );
+//! Call handler of a route found with CAN_FindRoute.
+void CAN_Dispatch( uint8_t route, CAN_frame_t const * frame );
+//! Find route for a frame and call its handler.
+void CAN_DispatchFrame( CAN_frame_t const * frame );
+//! Get number of routes in selected table, exact and range routes together.
+uint8_t CAN_GetRouteCount( void );
+//! Get key and mask of a route. Returns false if there is no such route.
+bool CAN_GetRouteKey( uint8_t route, uint32_t * key, uint32_t * mask );
+//! Compute the tightest dual acceptance filter letting through all IDs of the selected table.
+void CAN_ComputeFilter( CAN_filter_t * filter );
+
+//! Get time from older to newer adapter timestamp, in ms.
+uint16_t CAN_TimestampDelta( uint16_t newer, uint16_t older );
+//! Reset message timing.
+void CAN_InitTiming( CAN_timing_t * timing );
+//! Update message timing with a received frame. Frames without timestamp are ignored.
+void CAN_UpdateTiming( CAN_timing_t * timing, CAN_frame_t const * frame, uint32_t arrival );
+//! Get message rate in 0.1 frames per second, 0 until two frames have been received.
+uint16_t CAN_GetRate( CAN_timing_t const * timing );
+
+
+#endif
+// end of file
@@ -0,0 +1,247 @@
+// This file has been prepared for Doxygen automatic documentation generation.
+/*! \file *********************************************************************
+ *
+ * \brief  Streaming binary CAN record parser source file
+ *
+ *         COBS decoding and record parsing are done in one pass. Each code
+ *         byte tells how many bytes follow before the next zero, so decoded
+ *         bytes are passed on as they arrive, and the implied zero is only
+ *         passed on when the next code byte shows the record continues.
+ *
+ *         The CRC is updated with every decoded byte including the received
+ *         CRC, which leaves it 0 for an intact record.
+ *
+ *****************************************************************************/
+
+#include "canbin_lib.h"
+#include <stdbool.h>
+#include <stddef.h>
+
+
+
+/********************************
+ * Private constants and defines
+ ********************************/
+
+#define CANBIN_COBS_FULL_BLOCK 0xFF  //!< Code of a block with no zero after it.
+#define CANBIN_CRC_INIT 0x00  //!< CRC-8 start value.
+#define CANBIN_CRC_POLYNOMIAL 0x07  //!< CRC-8 polynomial, x^8 + x^2 + x + 1.
+
+#define CANBIN_STD_ID_SIZE 2  //!< Bytes in an 11-bit ID.
+#define CANBIN_EXT_ID_SIZE 4  //!< Bytes in a 29-bit ID.
+#define CANBIN_TIMESTAMP_SIZE 2  //!< Bytes in a timestamp.
+
+//! Parser states.
+enum CANBIN_state_enum
+{
+	CANBIN_STATE_SYNC,  //!< Skipping to the first delimiter after CANBIN_Init.
+	CANBIN_STATE_RECORD,  //!< Receiving a record.
+	CANBIN_STATE_SKIP,  //!< Skipping to end of a malformed record.
+	CANBIN_STATE_FILTERED  //!< Skipping to end of a record without route.
+};
+
+
+
+/*******************************
+ * Internal function prototypes
+ *******************************/
+
+//! Add one byte to a CRC-8.
+static uint8_t CANBIN_UpdateCrc( uint8_t crc, uint8_t data );
+//! Get ready for the next record.
+static void CANBIN_StartRecord( CANBIN_parser_t * parser );
+//! Check a record at its delimiter.
+static CANBIN_result_t CANBIN_EndRecord( CANBIN_parser_t const * parser );
+//! Merge one decoded record byte into the frame.
+static void CANBIN_StoreByte( CANBIN_parser_t * parser, uint8_t data );
+//! Check the complete ID and look up its route.
+static void CANBIN_EndId( CANBIN_parser_t * parser );
+
+
+
+/***************************
+ * Function implementations
+ ***************************/
+
+/*!
+ *  Bytes before the first delimiter may be the end of an SLCAN answer or
+ *  of a partial record, so they are dropped.
+ */
+void CANBIN_Init( CANBIN_parser_t * parser )
+{
+	CANBIN_StartRecord( parser );
+	parser->state = CANBIN_STATE_SYNC;
+	parser->FindRoute = NULL;
+	parser->route = CAN_NO_ROUTE;
+}
+
+
+void CANBIN_SetRouteFinder( CANBIN_parser_t * parser, CANBIN_RouteFinder_t FindRoute )
+{
+	parser->FindRoute = FindRoute;
+}
+
+
+/*!
+ *  Empty records, e.g. a delimiter sent ahead of a record to end any partial
+ *  one, are ignored.
+ *
+ * \param  parser  Parser state
+ * \param  data    Received byte
+ *
+ * \return  CANBIN_PENDING until a record is complete, then what it was
+ */
+CANBIN_result_t CANBIN_ProcessByte( CANBIN_parser_t * parser, uint8_t data )
+{
+	if (data == CANBIN_DELIMITER) {
+		CANBIN_result_t const result = CANBIN_EndRecord( parser );
+		CANBIN_StartRecord( parser );
+		return result;
+	}
+
+	if (parser->state != CANBIN_STATE_RECORD) {
+		return CANBIN_PENDING;
+	}
+
+	if (parser->codeLeft == 0) {
+		// The previous block ended with a zero, unless it was full.
+		if ((parser->code != 0) && (parser->code != CANBIN_COBS_FULL_BLOCK)) {
+			CANBIN_StoreByte( parser, 0x00 );
+		}
+		parser->code = data;
+		parser->codeLeft = data - 1;
+		return CANBIN_PENDING;
+	}
+
+	--parser->codeLeft;
+	CANBIN_StoreByte( parser, data );
+	return CANBIN_PENDING;
+}
+
+
+static uint8_t CANBIN_UpdateCrc( uint8_t crc, uint8_t data )
+{
+	crc ^= data;
+	for (uint8_t bit = 0; bit < 8; ++bit) {
+		crc = ((crc & 0x80) != 0x00) ? (uint8_t) ((crc << 1) ^ CANBIN_CRC_POLYNOMIAL) : (uint8_t) (crc << 1);
+	}
+	return crc;
+}
+
+
+static void CANBIN_StartRecord( CANBIN_parser_t * parser )
+{
+	parser->state = CANBIN_STATE_RECORD;
+	parser->codeLeft = 0;
+	parser->code = 0;
+	parser->index = 0;
+	parser->length = 0;
+	parser->crc = CANBIN_CRC_INIT;
+}
+
+
+static CANBIN_result_t CANBIN_EndRecord( CANBIN_parser_t const * parser )
+{
+	switch (parser->state) {
+		case CANBIN_STATE_SYNC:
+			return CANBIN_PENDING;
+
+		case CANBIN_STATE_SKIP:
+			return CANBIN_ERROR;
+
+		case CANBIN_STATE_FILTERED:
+			return CANBIN_FILTERED;
+
+		default:
+			break;
+	}
+
+	if (parser->code == 0) {
+		return CANBIN_PENDING;
+	}
+	if ((parser->codeLeft != 0) || (parser->length == 0) || (parser->index != parser->length) || (parser->crc != 0x00)) {
+		return CANBIN_ERROR;
+	}
+	return CANBIN_FRAME;
+}
+
+
+/*!
+ *  The header gives the record length, so bytes beyond it and headers with
+ *  an invalid DLC make the parser skip the rest of the record.
+ */
+static void CANBIN_StoreByte( CANBIN_parser_t * parser, uint8_t data )
+{
+	CAN_frame_t * frame = &parser->frame;
+	uint8_t const index = parser->index;
+
+	if ((index >= CANBIN_MAX_RECORD_SIZE) || ((index != 0) && (index >= parser->length))) {
+		parser->state = CANBIN_STATE_SKIP;
+		return;
+	}
+	parser->crc = CANBIN_UpdateCrc( parser->crc, data );
+	++parser->index;
+
+	if (index == 0) {
+		uint8_t const dlc = data & CANBIN_HEADER_DLC;
+		if ((dlc > CAN_MAX_DLC) || ((data & 0x80) != 0x00)) {
+			parser->state = CANBIN_STATE_SKIP;
+			return;
+		}
+		frame->flags = data >> CANBIN_HEADER_FLAG_SHIFT;
+		frame->dlc = dlc;
+		frame->id = 0;
+		frame->timestamp = 0;
+
+		parser->length = 1 + 1;  // Header and CRC.
+		parser->length += ((frame->flags & CAN_FLAG_EXTENDED) != 0x00) ? CANBIN_EXT_ID_SIZE : CANBIN_STD_ID_SIZE;
+		if ((frame->flags & CAN_FLAG_RTR) == 0x00) {
+			parser->length += dlc;
+		}
+		if ((frame->flags & CAN_FLAG_TIMESTAMP) != 0x00) {
+			parser->length += CANBIN_TIMESTAMP_SIZE;
+		}
+		return;
+	}
+
+	uint8_t const idEnd = 1 + (((frame->flags & CAN_FLAG_EXTENDED) != 0x00) ? CANBIN_EXT_ID_SIZE : CANBIN_STD_ID_SIZE);
+	if (index < idEnd) {
+		frame->id = (frame->id << 8) | data;
+		if (index == idEnd - 1) {
+			CANBIN_EndId( parser );
+		}
+		return;
+	}
+
+	uint8_t const dataEnd = idEnd + (((frame->flags & CAN_FLAG_RTR) != 0x00) ? 0 : frame->dlc);
+	if (index < dataEnd) {
+		frame->data[index - idEnd] = data;
+	} else if (index < parser->length - 1) {
+		frame->timestamp = (frame->timestamp << 8) | data;
+	}
+	// Last byte is the CRC, checked at the delimiter.
+}
+
+
+/*!
+ *  Out of range IDs make the parser skip the rest of the record.
+ */
+static void CANBIN_EndId( CANBIN_parser_t * parser )
+{
+	CAN_frame_t const * frame = &parser->frame;
+	uint32_t const maxId = ((frame->flags & CAN_FLAG_EXTENDED) != 0x00) ? CAN_MAX_EXT_ID : CAN_MAX_STD_ID;
+
+	if (frame->id > maxId) {
+		parser->state = CANBIN_STATE_SKIP;
+		return;
+	}
+	if (parser->FindRoute != NULL) {
+		parser->route = parser->FindRoute( frame->id, frame->flags );
+		if (parser->route == CAN_NO_ROUTE) {
+			parser->state = CANBIN_STATE_FILTERED;
+		}
+	}
+}
+
+
+// end of file
@@ -0,0 +1,102 @@
+// This file has been prepared for Doxygen automatic documentation generation.
+/*! \file *********************************************************************
+ *
+ * \brief  Streaming binary CAN record parser header file
+ *
+ *         Binary alternative to SLCAN for the serial link to the CAN
+ *         adapter bridge. Each frame is sent as one record, COBS encoded so
+ *         it contains no zero bytes, and terminated by a zero byte. Like
+ *         the SLCAN parser, records are decoded one byte at a time straight
+ *         into a CAN_frame_t, and a lost byte costs one frame only.
+ *
+ *         Record layout before COBS encoding:
+ *
+ *         - Header byte: DLC in bits 0-3, CANBIN_HEADER_* flags above, bit 7 0.
+ *         - ID: 2 bytes for 11-bit IDs, 4 bytes for 29-bit IDs, MSB first.
+ *         - Data: DLC bytes, none for remote frames.
+ *         - Timestamp: 2 bytes in ms, MSB first, if flagged in the header.
+ *         - CRC-8 of all bytes above, polynomial 0x07, start value 0.
+ *
+ *         An 8-byte frame with 11-bit ID takes 14 bytes on the wire, where
+ *         the SLCAN line takes 22 characters.
+ *
+ *         The link starts in SLCAN. The display sends CANBIN_REQUEST, and
+ *         a bridge that supports records answers with two CRs, the first
+ *         one ending any partial line, then a delimiter, and sends records
+ *         from then on. The parser drops everything up to the first
+ *         delimiter after CANBIN_Init, so whichever CR the display switches
+ *         on, the rest of the answer is not taken as a record. A plain SLCAN
+ *         adapter answers BELL and the link stays in SLCAN.
+ *
+ *****************************************************************************/
+#ifndef CANBIN_LIB_H
+#define CANBIN_LIB_H
+
+#include <stdint.h>
+#include <can_lib.h>
+
+
+
+/************************
+ * Constants and defines
+ ************************/
+
+#define CANBIN_REQUEST "B1\r"  //!< SLCAN command asking the bridge to switch to records.
+#define CANBIN_DELIMITER 0x00  //!< Record terminator.
+
+#define CANBIN_HEADER_DLC        0x0F  //!< Header bits holding the DLC.
+#define CANBIN_HEADER_FLAG_SHIFT 4  //!< Header bits above the DLC hold CAN_FLAG_* flags.
+#define CANBIN_HEADER_EXTENDED   (CAN_FLAG_EXTENDED << CANBIN_HEADER_FLAG_SHIFT)  //!< Header flag for 29-bit IDs.
+#define CANBIN_HEADER_RTR        (CAN_FLAG_RTR << CANBIN_HEADER_FLAG_SHIFT)  //!< Header flag for remote frames.
+#define CANBIN_HEADER_TIMESTAMP  (CAN_FLAG_TIMESTAMP << CANBIN_HEADER_FLAG_SHIFT)  //!< Header flag for records with timestamp.
+
+#define CANBIN_MAX_RECORD_SIZE 16  //!< Longest record before COBS encoding.
+
+//! Results of CANBIN_ProcessByte.
+enum CANBIN_result_enum
+{
+	CANBIN_PENDING,  //!< Record not complete yet.
+	CANBIN_FRAME,  //!< Valid frame received, see CANBIN_parser_t::frame.
+	CANBIN_ERROR,  //!< Malformed record or CRC mismatch, dropped.
+	CANBIN_FILTERED  //!< Record with an ID that has no route, dropped.
+};
+
+
+
+/*********************
+ * Types and typedefs
+ *********************/
+
+typedef uint8_t CANBIN_result_t;  //!< One of CANBIN_* results.
+typedef uint8_t (* CANBIN_RouteFinder_t)( uint32_t id, uint8_t flags );  //!< Returns route number or CAN_NO_ROUTE.
+
+//! Parser state. Initialize with CANBIN_Init, do not modify directly.
+typedef struct CANBIN_parser_struct
+{
+	uint8_t state;  //!< Internal parser state.
+	uint8_t codeLeft;  //!< Bytes left in current COBS block, 0 when a code byte is next.
+	uint8_t code;  //!< Code byte of current COBS block, 0 at start of record.
+	uint8_t index;  //!< Index of next decoded record byte.
+	uint8_t length;  //!< Record length from header, 0 before header.
+	uint8_t crc;  //!< CRC-8 of decoded bytes so far.
+	CANBIN_RouteFinder_t FindRoute;  //!< Route finder, or NULL to accept all IDs.
+	uint8_t route;  //!< Route number of frame, CAN_NO_ROUTE without route finder.
+	CAN_frame_t frame;  //!< Frame being received, valid after CANBIN_FRAME until next byte.
+} CANBIN_parser_t;
+
+
+
+/**********************
+ * Function prototypes
+ **********************/
+
+//! Reset parser to wait for the first delimiter.
+void CANBIN_Init( CANBIN_parser_t * parser );
+//! Set route finder called with each ID, or NULL to accept all IDs.
+void CANBIN_SetRouteFinder( CANBIN_parser_t * parser, CANBIN_RouteFinder_t FindRoute );
+//! Feed one received byte to the parser.
+CANBIN_result_t CANBIN_ProcessByte( CANBIN_parser_t * parser, uint8_t data );
+
+
+#endif
+// end of file
@@ -0,0 +1,117 @@
+// This file has been prepared for Doxygen automatic documentation generation.
+/*! \file *********************************************************************
+ *
+ * \brief  Table-driven CAN signal decoder source file
+ *
+ *         Signals are copied from flash to the stack one at a time before
+ *         use, as layout items are.
+ *
+ *****************************************************************************/
+
+#include "cansig_lib.h"
+
+
+
+/*******************************
+ * Internal function prototypes
+ *******************************/
+
+//! Copy one signal from flash.
+static void CANSIG_ReadSignal( CANSIG_signal_t const CAL_PGM(* source), CANSIG_signal_t * signal );
+
+
+
+/***************************
+ * Function implementations
+ ***************************/
+
+/*!
+ *  Frames shorter than the message's minimum DLC, and remote requests,
+ *  are ignored, so a short frame never produces values from stale bytes.
+ *
+ * \param  message  Signals of the message
+ * \param  frame    Received frame
+ * \param  Sink     Called with target ID and value of each signal
+ */
+void CANSIG_Decode( CANSIG_message_t const CAL_PGM(* message), CAN_frame_t const * frame, CANSIG_Sink_t Sink )
+{
+	if ((frame->dlc < CAL_pgm_read_byte( &message->minDlc )) || ((frame->flags & CAN_FLAG_RTR) != 0x00)) {
+		return;
+	}
+
+	CANSIG_signal_t const CAL_PGM(* signals) = (CANSIG_signal_t const CAL_PGM(*)) CAL_pgm_read_pvoid( &message->signals );
+	uint8_t const signalCount = CAL_pgm_read_byte( &message->signalCount );
+
+	CANSIG_signal_t signal;
+	int32_t mux = 0;
+	for (uint8_t index = 0; index < signalCount; ++index) {
+		CANSIG_ReadSignal( &signals[index], &signal );
+		if (((signal.flags & CANSIG_MUXED) != 0x00) && (signal.muxValue != mux)) {
+			continue;
+		}
+
+		int32_t const raw = CANSIG_GetRaw( &signal, frame->data );
+		if ((signal.flags & CANSIG_MUX) != 0x00) {
+			mux = raw;
+		}
+		if (signal.target != CANSIG_NO_TARGET) {
+			Sink( signal.target, CANSIG_Scale( &signal, raw ) );
+		}
+	}
+}
+
+
+/*!
+ *  The LSB byte is shifted down first, and each following byte, towards
+ *  higher data indexes for Intel and lower for Motorola signals, is put
+ *  above it. Bits above the signal are then masked away.
+ */
+int32_t CANSIG_GetRaw( CANSIG_signal_t const * signal, uint8_t const * data )
+{
+	uint8_t const * pData = &data[signal->lsbByte];
+	uint32_t raw = *pData >> signal->shift;
+	uint8_t bitPosition = 8 - signal->shift;
+
+	for (uint8_t count = signal->byteCount; count > 1; --count) {
+		if ((signal->flags & CANSIG_BIG_ENDIAN) != 0x00) {
+			--pData;
+		} else {
+			++pData;
+		}
+		raw |= (uint32_t) *pData << bitPosition;
+		bitPosition += 8;
+	}
+	raw &= signal->mask;
+
+	// Fill bits above a negative value with ones.
+	if (((signal->flags & CANSIG_SIGNED) != 0x00) && ((raw & ~(signal->mask >> 1)) != 0x00)) {
+		raw |= ~signal->mask;
+	}
+
+	return (int32_t) raw;
+}
+
+
+int16_t CANSIG_Scale( CANSIG_signal_t const * signal, int32_t raw )
+{
+	int32_t value = ((raw * signal->multiplier) >> signal->scaleShift) + signal->offset;
+	if (value < signal->min) {
+		value = signal->min;
+	} else if (value > signal->max) {
+		value = signal->max;
+	}
+	return (int16_t) value;
+}
+
+
+static void CANSIG_ReadSignal( CANSIG_signal_t const CAL_PGM(* source), CANSIG_signal_t * signal )
+{
+	uint8_t const CAL_PGM(* pSource) = (uint8_t const CAL_PGM(*)) source;
+	uint8_t * destination = (uint8_t *) signal;
+	for (uint8_t count = sizeof(CANSIG_signal_t); count != 0; --count) {
+		*destination++ = CAL_pgm_read_byte( pSource++ );
+	}
+}
+
+
+// end of file
@@ -0,0 +1,123 @@
+// This file has been prepared for Doxygen automatic documentation generation.
+/*! \file *********************************************************************
+ *
+ * \brief  Table-driven CAN signal decoder header file
+ *
+ *         Signals are described as in a DBC file, by start bit, length,
+ *         byte order, signedness, scale, offset and range, in flash tables.
+ *         Bit positions are turned into a byte index, byte count, shift and
+ *         mask when the table is built, by the CANSIG_INTEL and
+ *         CANSIG_MOTOROLA macros or the host DBC compiler, so decoding a
+ *         signal is a few byte loads, shifts and one multiply.
+ *
+ *         Scaling is done in integers: the raw value is multiplied by
+ *         "multiplier", shifted right by "scaleShift" and "offset" is
+ *         added, so a DBC factor of 0.5 is multiplier 1, shift 1. The
+ *         result is clamped to min and max and passed to a sink function
+ *         together with the target ID of the signal, e.g. DASHBOARD_Update.
+ *
+ *         Raw values of up to 32 bits are supported. Raw value times
+ *         multiplier must fit in 32 bits.
+ *
+ *         Multiplexed messages have their multiplexor signal, flagged
+ *         CANSIG_MUX, first in the signal list. Signals flagged CANSIG_MUXED
+ *         are then only decoded when the multiplexor raw value equals their
+ *         muxValue.
+ *
+ *****************************************************************************/
+#ifndef CANSIG_LIB_H
+#define CANSIG_LIB_H
+
+#include <stdint.h>
+#include <cal.h>
+#include <can_lib.h>
+
+
+
+/************************
+ * Constants and defines
+ ************************/
+
+#define CANSIG_SIGNED     (1<<0)  //!< Raw value is two's complement.
+#define CANSIG_BIG_ENDIAN (1<<1)  //!< Motorola byte order, set by CANSIG_MOTOROLA.
+#define CANSIG_MUX        (1<<2)  //!< Multiplexor signal, must be first in message.
+#define CANSIG_MUXED      (1<<3)  //!< Only present when multiplexor equals muxValue.
+#define CANSIG_NO_TARGET  0xFF  //!< Target ID of signals not passed to sink, e.g. a multiplexor.
+
+//! Mask for a raw value of the given bit length.
+#define CANSIG_MASK(length) (((length) >= 32) ? 0xFFFFFFFFUL : ((1UL << (length)) - 1))
+
+/*!
+ *  Bit layout fields of an Intel (little endian) signal: lsbByte, byteCount,
+ *  shift, flags and mask. The start bit is the LSB, as in DBC files.
+ */
+#define CANSIG_INTEL(startBit, length, flags) \
+	(startBit) / 8, \
+	((startBit) % 8 + (length) + 7) / 8, \
+	(startBit) % 8, \
+	(flags), \
+	CANSIG_MASK( length )
+
+//! Bits of a Motorola signal in the byte holding its MSB.
+#define CANSIG_MSB_BITS(startBit) ((startBit) % 8 + 1)
+
+/*!
+ *  Bit layout fields of a Motorola (big endian) signal: lsbByte, byteCount,
+ *  shift, flags and mask. The start bit is the MSB, as in DBC files.
+ */
+#define CANSIG_MOTOROLA(startBit, length, flags) \
+	(startBit) / 8 + (((length) <= CANSIG_MSB_BITS( startBit )) ? 0 : ((length) - CANSIG_MSB_BITS( startBit ) + 7) / 8), \
+	((length) <= CANSIG_MSB_BITS( startBit )) ? 1 : 1 + ((length) - CANSIG_MSB_BITS( startBit ) + 7) / 8, \
+	((length) <= CANSIG_MSB_BITS( startBit )) ? CANSIG_MSB_BITS( startBit ) - (length) : (8 - ((length) - CANSIG_MSB_BITS( startBit )) % 8) % 8, \
+	(flags) | CANSIG_BIG_ENDIAN, \
+	CANSIG_MASK( length )
+
+
+
+/*********************
+ * Types and typedefs
+ *********************/
+
+typedef void (* CANSIG_Sink_t)( uint8_t target, int16_t value );  //!< Receiver of decoded values.
+
+//! One signal, stored in flash. Start with CANSIG_INTEL or CANSIG_MOTOROLA.
+typedef struct CANSIG_signal_struct
+{
+	uint8_t lsbByte;  //!< Data byte holding the LSB.
+	uint8_t byteCount;  //!< Number of data bytes the signal touches.
+	uint8_t shift;  //!< Bit position of the LSB in lsbByte.
+	uint8_t flags;  //!< Combination of CANSIG_* flags.
+	uint32_t mask;  //!< Mask for raw value, CANSIG_MASK of length.
+	int16_t multiplier;  //!< Scale multiplier.
+	uint8_t scaleShift;  //!< Right shift after multiplying.
+	int16_t offset;  //!< Added after scaling.
+	int16_t min;  //!< Lowest value passed to sink.
+	int16_t max;  //!< Highest value passed to sink.
+	uint8_t target;  //!< Target ID passed to sink, or CANSIG_NO_TARGET.
+	uint8_t muxValue;  //!< Multiplexor value for CANSIG_MUXED signals.
+} CANSIG_signal_t;
+
+//! Signals of one message, stored in flash.
+typedef struct CANSIG_message_struct
+{
+	CANSIG_signal_t const CAL_PGM(* signals);  //!< Signals to decode.
+	uint8_t signalCount;  //!< Number of signals.
+	uint8_t minDlc;  //!< Frames shorter than this are ignored.
+} CANSIG_message_t;
+
+
+
+/**********************
+ * Function prototypes
+ **********************/
+
+//! Decode all signals of a message from a frame and pass them to a sink.
+void CANSIG_Decode( CANSIG_message_t const CAL_PGM(* message), CAN_frame_t const * frame, CANSIG_Sink_t Sink );
+//! Extract raw value of one signal, sign extended if signed.
+int32_t CANSIG_GetRaw( CANSIG_signal_t const * signal, uint8_t const * data );
+//! Scale and clamp a raw value.
+int16_t CANSIG_Scale( CANSIG_signal_t const * signal, int32_t raw );
+
+
+#endif
+// end of file
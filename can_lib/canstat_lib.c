@@ -0,0 +1,237 @@
+// This file has been prepared for Doxygen automatic documentation generation.
+/*! \file *********************************************************************
+ *
+ * \brief  CAN traffic statistics source file
+ *
+ *         All counting is done in the main loop, from the results of the
+ *         SLCAN and binary record parsers, so no locking is needed.
+ *
+ *****************************************************************************/
+
+#include "canstat_lib.h"
+#include <string.h>
+
+
+
+/********************
+ * Private variables
+ ********************/
+
+static CANSTAT_route_t CANSTAT_routes[CANSTAT_MAX_ROUTES];  //!< Statistics per route number.
+static CANSTAT_totals_t CANSTAT_totals;  //!< Totals of all traffic.
+static uint16_t CANSTAT_kbitPerSecond;  //!< Bus bit rate, for the load.
+static uint32_t CANSTAT_windowStart;  //!< Start of current bus load window, ms.
+static uint32_t CANSTAT_windowBits;  //!< Bits seen in current bus load window.
+
+
+
+/*******************************
+ * Internal function prototypes
+ *******************************/
+
+//! Work out the bus load if the current window has ended, and start a new one.
+static void CANSTAT_CloseWindow( uint32_t now );
+//! Add bits of a frame to the bus load window, closing it first if it has ended.
+static void CANSTAT_AddLoad( uint8_t flags, uint8_t dlc, uint32_t now );
+//! Add one to a statistics counter without wrapping.
+static void CANSTAT_Count( uint16_t * counter );
+
+
+
+/***************************
+ * Function implementations
+ ***************************/
+
+/*!
+ * \param  kbitPerSecond  Bus bit rate in kbit/s, 0 to skip the bus load
+ * \param  now            Current time in ms
+ */
+void CANSTAT_Init( uint16_t kbitPerSecond, uint32_t now )
+{
+	memset( CANSTAT_routes, 0x00, sizeof(CANSTAT_routes) );
+	for (uint8_t route = 0; route < CANSTAT_MAX_ROUTES; ++route) {
+		CAN_InitTiming( &CANSTAT_routes[route].timing );
+	}
+	memset( &CANSTAT_totals, 0x00, sizeof(CANSTAT_totals) );
+	CANSTAT_kbitPerSecond = kbitPerSecond;
+	CANSTAT_windowStart = now;
+	CANSTAT_windowBits = 0;
+}
+
+
+/*!
+ *  Takes the same time for every frame, whatever the route number.
+ *
+ * \param  route  Route number from CAN_FindRoute
+ * \param  frame  Received frame
+ * \param  now    Arrival time in ms
+ */
+void CANSTAT_Frame( uint8_t route, CAN_frame_t const * frame, uint32_t now )
+{
+	++CANSTAT_totals.lines;
+	++CANSTAT_totals.frames;
+	CANSTAT_AddLoad( frame->flags, frame->dlc, now );
+
+	if (route >= CANSTAT_MAX_ROUTES) {
+		return;
+	}
+	CANSTAT_route_t * stats = &CANSTAT_routes[route];
+	bool const stamped = (frame->flags & CAN_FLAG_TIMESTAMP) != 0x00;
+
+	if ((stats->flags & CANSTAT_FLAG_SEEN) == 0x00) {
+		stats->dlc = frame->dlc;
+		stats->minInterval = CANSTAT_NO_INTERVAL;
+		stats->maxInterval = CANSTAT_NO_INTERVAL;
+	} else {
+		uint32_t delta;
+		if (stamped && ((stats->flags & CANSTAT_FLAG_STAMPED) != 0x00)) {
+			delta = CAN_TimestampDelta( frame->timestamp, stats->timing.lastStamp );
+		} else {
+			delta = now - stats->lastSeen;
+		}
+		// Keep CANSTAT_NO_INTERVAL free to mean no interval yet.
+		if (delta >= CANSTAT_NO_INTERVAL) {
+			delta = CANSTAT_NO_INTERVAL - 1;
+		}
+		if ((stats->minInterval == CANSTAT_NO_INTERVAL) || (delta < stats->minInterval)) {
+			stats->minInterval = (uint16_t) delta;
+		}
+		if ((stats->maxInterval == CANSTAT_NO_INTERVAL) || (delta > stats->maxInterval)) {
+			stats->maxInterval = (uint16_t) delta;
+		}
+
+		if (frame->dlc != stats->dlc) {
+			CANSTAT_Count( &stats->dlcErrors );
+		}
+	}
+
+	// After the interval above, since this replaces the last timestamp.
+	CAN_UpdateTiming( &stats->timing, frame, now );
+
+	++stats->count;
+	stats->lastSeen = now;
+	stats->flags = CANSTAT_FLAG_SEEN | (stamped ? CANSTAT_FLAG_STAMPED : 0x00);
+}
+
+
+/*!
+ *  Frames are dropped as soon as their ID is known, so only the flags of
+ *  the frame are valid and the data is taken to be CAN_MAX_DLC bytes.
+ *
+ * \param  frame  Frame being received
+ * \param  now    Arrival time in ms
+ */
+void CANSTAT_Unknown( CAN_frame_t const * frame, uint32_t now )
+{
+	++CANSTAT_totals.lines;
+	CANSTAT_Count( &CANSTAT_totals.unknownIds );
+	CANSTAT_AddLoad( frame->flags, CAN_MAX_DLC, now );
+}
+
+
+void CANSTAT_ParseError( void )
+{
+	++CANSTAT_totals.lines;
+	CANSTAT_Count( &CANSTAT_totals.parseErrors );
+}
+
+
+void CANSTAT_Response( void )
+{
+	++CANSTAT_totals.lines;
+}
+
+
+void CANSTAT_GetTotals( CANSTAT_totals_t * totals, uint32_t now )
+{
+	CANSTAT_CloseWindow( now );
+	*totals = CANSTAT_totals;
+}
+
+
+bool CANSTAT_GetRoute( uint8_t route, CANSTAT_route_t * stats )
+{
+	if (route >= CANSTAT_MAX_ROUTES) {
+		return false;
+	}
+	*stats = CANSTAT_routes[route];
+	return true;
+}
+
+
+uint16_t CANSTAT_GetInterval( CANSTAT_route_t const * stats )
+{
+	uint16_t const interval = stats->timing.interval;
+	if (interval == 0) {
+		return CANSTAT_NO_INTERVAL;
+	}
+	return (interval + (1 << (CAN_TIMING_AVERAGE_SHIFT - 1))) >> CAN_TIMING_AVERAGE_SHIFT;
+}
+
+
+uint16_t CANSTAT_GetLatency( CANSTAT_route_t const * stats )
+{
+	if (stats->timing.count == 0) {
+		return CANSTAT_NO_INTERVAL;
+	}
+	return stats->timing.latency;
+}
+
+
+/*!
+ *  The load of a window is only known once it has ended, and a window
+ *  during which nothing arrived ends with the next frame or call to
+ *  CANSTAT_GetTotals, so windows may be longer than CANSTAT_LOAD_WINDOW.
+ *
+ * \param  now  Current time in ms
+ */
+static void CANSTAT_CloseWindow( uint32_t now )
+{
+	uint32_t const elapsed = now - CANSTAT_windowStart;
+	if ((elapsed >= CANSTAT_LOAD_WINDOW) && (CANSTAT_kbitPerSecond != 0)) {
+		// kbit/s times ms gives bits.
+		uint32_t const capacity = (uint32_t) CANSTAT_kbitPerSecond * elapsed;
+		uint32_t load;
+		if (CANSTAT_windowBits >= capacity) {
+			load = 1000;
+		} else if (CANSTAT_windowBits < 0x400000UL) {
+			load = CANSTAT_windowBits * 1000 / capacity;
+		} else {
+			load = CANSTAT_windowBits / (capacity / 1000);
+		}
+		CANSTAT_totals.load = (uint16_t) load;
+		CANSTAT_windowStart = now;
+		CANSTAT_windowBits = 0;
+	}
+}
+
+
+/*!
+ *  Frame bits are the CAN 2.0 frame without stuffing, intermission
+ *  included.
+ *
+ * \param  flags  CAN_FLAG_* flags of frame
+ * \param  dlc    Data length code of frame
+ * \param  now    Arrival time in ms
+ */
+static void CANSTAT_AddLoad( uint8_t flags, uint8_t dlc, uint32_t now )
+{
+	CANSTAT_CloseWindow( now );
+
+	uint8_t bits = ((flags & CAN_FLAG_EXTENDED) != 0x00) ? CANSTAT_EXT_FRAME_BITS : CANSTAT_STD_FRAME_BITS;
+	if ((flags & CAN_FLAG_RTR) == 0x00) {
+		bits += 8 * dlc;
+	}
+	CANSTAT_windowBits += bits;
+}
+
+
+static void CANSTAT_Count( uint16_t * counter )
+{
+	if (*counter != 0xFFFF) {
+		++(*counter);
+	}
+}
+
+
+// end of file
@@ -0,0 +1,109 @@
+// This file has been prepared for Doxygen automatic documentation generation.
+/*! \file *********************************************************************
+ *
+ * \brief  CAN traffic statistics header file
+ *
+ *         Counts what arrives from the adapter, to see in the car whether
+ *         frames come in, how often, and whether lines are malformed. Frames
+ *         are counted per route of the CAN dispatch table, in a fixed table
+ *         indexed by route number, so each frame costs a few additions and
+ *         no search. Only the first CANSTAT_MAX_ROUTES routes have a table
+ *         entry, frames of other routes are counted in the totals only.
+ *
+ *         Shortest and longest intervals between frames of one route are
+ *         taken from adapter timestamps when both frames have one, and from
+ *         arrival times otherwise. The averaged interval and the latency
+ *         come from CAN_UpdateTiming, so from timestamped frames only. The
+ *         expected DLC of a route is that of its first frame, later frames
+ *         with another DLC count as DLC errors.
+ *
+ *         Bus load is estimated from the frames seen, without bit stuffing,
+ *         over windows of CANSTAT_LOAD_WINDOW ms. Frames dropped before their
+ *         DLC was read count as CAN_MAX_DLC data bytes. Frames removed by the
+ *         adapter acceptance filter are not seen at all, so with a filter
+ *         set this is the load of the frames let through.
+ *
+ *         Times are in ms from any clock that wraps at 2^32, e.g. timing_lib
+ *         ticks converted to ms.
+ *
+ *****************************************************************************/
+#ifndef CANSTAT_LIB_H
+#define CANSTAT_LIB_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <can_lib.h>
+
+
+
+/************************
+ * Constants and defines
+ ************************/
+
+#define CANSTAT_MAX_ROUTES 8  //!< Routes with their own statistics.
+#define CANSTAT_LOAD_WINDOW 1000U  //!< Bus load window, ms.
+#define CANSTAT_NO_INTERVAL 0xFFFFU  //!< Interval value before two frames have arrived.
+
+#define CANSTAT_STD_FRAME_BITS 47  //!< Bits of an 11-bit ID frame without data and stuffing.
+#define CANSTAT_EXT_FRAME_BITS 67  //!< Bits of a 29-bit ID frame without data and stuffing.
+
+#define CANSTAT_FLAG_SEEN    (1<<0)  //!< At least one frame received.
+#define CANSTAT_FLAG_STAMPED (1<<1)  //!< Last frame had an adapter timestamp.
+
+
+
+/*********************
+ * Types and typedefs
+ *********************/
+
+//! Statistics of one route. 16-bit counters saturate instead of wrapping.
+typedef struct CANSTAT_route_struct
+{
+	uint32_t count;  //!< Frames received.
+	uint32_t lastSeen;  //!< Arrival of last frame, ms.
+	CAN_timing_t timing;  //!< Averaged interval and latency, timestamp of last stamped frame.
+	uint16_t minInterval;  //!< Shortest interval between frames, ms, or CANSTAT_NO_INTERVAL.
+	uint16_t maxInterval;  //!< Longest interval between frames, ms, or CANSTAT_NO_INTERVAL.
+	uint16_t dlcErrors;  //!< Frames with another DLC than the first one.
+	uint8_t dlc;  //!< DLC of first frame.
+	uint8_t flags;  //!< Combination of CANSTAT_FLAG_* flags.
+} CANSTAT_route_t;
+
+//! Totals of all traffic. 16-bit counters saturate instead of wrapping.
+typedef struct CANSTAT_totals_struct
+{
+	uint32_t lines;  //!< Lines or records received, frames included.
+	uint32_t frames;  //!< Frames with a route.
+	uint16_t parseErrors;  //!< Malformed lines or records.
+	uint16_t unknownIds;  //!< Frames without a route.
+	uint16_t load;  //!< Bus load in last complete window, 0.1 %.
+} CANSTAT_totals_t;
+
+
+
+/**********************
+ * Function prototypes
+ **********************/
+
+//! Clear all statistics. Bit rate is used for the bus load.
+void CANSTAT_Init( uint16_t kbitPerSecond, uint32_t now );
+//! Count a frame with a route.
+void CANSTAT_Frame( uint8_t route, CAN_frame_t const * frame, uint32_t now );
+//! Count a frame without a route. Its DLC may be unknown.
+void CANSTAT_Unknown( CAN_frame_t const * frame, uint32_t now );
+//! Count a malformed line or record.
+void CANSTAT_ParseError( void );
+//! Count a line that is not a frame, e.g. an adapter answer.
+void CANSTAT_Response( void );
+//! Copy totals, closing the bus load window if it has ended.
+void CANSTAT_GetTotals( CANSTAT_totals_t * totals, uint32_t now );
+//! Copy statistics of a route. Returns false if the route has no entry.
+bool CANSTAT_GetRoute( uint8_t route, CANSTAT_route_t * stats );
+//! Get averaged interval of a route in ms, CANSTAT_NO_INTERVAL before two timestamped frames.
+uint16_t CANSTAT_GetInterval( CANSTAT_route_t const * stats );
+//! Get latency of the last frame of a route in ms, CANSTAT_NO_INTERVAL before a timestamped frame.
+uint16_t CANSTAT_GetLatency( CANSTAT_route_t const * stats );
+
+
+#endif
+// end of file
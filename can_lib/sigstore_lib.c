@@ -0,0 +1,145 @@
+// This file has been prepared for Doxygen automatic documentation generation.
+/*! \file *********************************************************************
+ *
+ * \brief  Latest-value signal store source file
+ *
+ *         The writer sets the changed bit after the slot is complete, so a
+ *         reader that sees the bit always finds the new value. Setting the
+ *         bit is a read-modify-write of a byte shared with the reader, so
+ *         it is done with interrupts off for the few instructions it takes.
+ *
+ *****************************************************************************/
+
+#include "sigstore_lib.h"
+#include <stddef.h>
+#include <cal.h>
+
+
+
+/***************************
+ * Function implementations
+ ***************************/
+
+void SIGSTORE_Init( SIGSTORE_store_t * store, SIGSTORE_slot_t * slots, uint8_t volatile * changed, uint8_t slotCount )
+{
+	store->slots = slots;
+	store->changed = changed;
+	store->slotCount = slotCount;
+
+	for (uint8_t slot = 0; slot < slotCount; ++slot) {
+		slots[slot].value = 0;
+		slots[slot].timestamp = 0;
+		slots[slot].sequence = 0;
+	}
+	for (uint8_t group = 0; group < SIGSTORE_MAP_SIZE( slotCount ); ++group) {
+		changed[group] = 0x00;
+	}
+}
+
+
+/*!
+ *  Only one writer per slot is allowed. Readers interrupted by the writer
+ *  retry, the writer never waits.
+ *
+ * \param  store      Signal store
+ * \param  slot       Slot number, out of range numbers are ignored
+ * \param  value      New value
+ * \param  timestamp  Time of update
+ *
+ * \return  True if the slot was still marked changed, i.e. a value was replaced before being read
+ */
+bool SIGSTORE_Write( SIGSTORE_store_t * store, uint8_t slot, int16_t value, uint16_t timestamp )
+{
+	if (slot >= store->slotCount) {
+		return false;
+	}
+
+	SIGSTORE_slot_t * target = &store->slots[slot];
+	++target->sequence;
+	target->value = value;
+	target->timestamp = timestamp;
+	++target->sequence;
+
+	uint8_t const bit = 1 << (slot & 0x07);
+	uint8_t volatile * changed = &store->changed[slot >> 3];
+	uint8_t const storedSREG = SREG;
+	CAL_disable_interrupt();
+	bool const replaced = (*changed & bit) != 0x00;
+	*changed |= bit;
+	SREG = storedSREG;
+	return replaced;
+}
+
+
+/*!
+ *  Must not be called from a context that can interrupt the writer of the
+ *  slot, since it would then wait forever for the update to complete.
+ *
+ * \param  store      Signal store
+ * \param  slot       Slot number
+ * \param  value      Where to store value
+ * \param  timestamp  Where to store time of update, or NULL
+ *
+ * \return  Sequence number, compare to a previous one to see if the slot has been written
+ */
+uint8_t SIGSTORE_Read( SIGSTORE_store_t const * store, uint8_t slot, int16_t * value, uint16_t * timestamp )
+{
+	SIGSTORE_slot_t const * source = &store->slots[slot];
+	uint8_t sequence;
+	int16_t copyValue;
+	uint16_t copyTimestamp;
+	do {
+		sequence = source->sequence;
+		copyValue = source->value;
+		copyTimestamp = source->timestamp;
+	} while (((sequence & 0x01) != 0x00) || (sequence != source->sequence));
+
+	*value = copyValue;
+	if (timestamp != NULL) {
+		*timestamp = copyTimestamp;
+	}
+	return sequence;
+}
+
+
+int16_t SIGSTORE_GetValue( SIGSTORE_store_t const * store, uint8_t slot )
+{
+	int16_t value;
+	SIGSTORE_Read( store, slot, &value, NULL );
+	return value;
+}
+
+
+/*!
+ *  Read the slots after taking their bits, a write in between then marks
+ *  the slot again and is seen on the next scan.
+ *
+ * \param  store  Signal store
+ * \param  group  Bitmap byte, 0 to SIGSTORE_MAP_SIZE( slotCount ) - 1
+ *
+ * \return  Changed bits, bit n for slot 8 * group + n
+ */
+uint8_t SIGSTORE_TakeChanged( SIGSTORE_store_t * store, uint8_t group )
+{
+	uint8_t volatile * changed = &store->changed[group];
+	uint8_t const storedSREG = SREG;
+	CAL_disable_interrupt();
+	uint8_t const bits = *changed;
+	*changed = 0x00;
+	SREG = storedSREG;
+	return bits;
+}
+
+
+bool SIGSTORE_HasChanged( SIGSTORE_store_t const * store )
+{
+	for (uint8_t group = 0; group < SIGSTORE_MAP_SIZE( store->slotCount ); ++group) {
+		if (store->changed[group] != 0x00) {
+			return true;
+		}
+	}
+	return false;
+}
+
+
+// end of file
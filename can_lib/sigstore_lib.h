@@ -0,0 +1,77 @@
+// This file has been prepared for Doxygen automatic documentation generation.
+/*! \file *********************************************************************
+ *
+ * \brief  Latest-value signal store header file
+ *
+ *         Decouples decoding from drawing. Decoded values are written into
+ *         a fixed array of slots as fast as frames arrive, newer values
+ *         simply replacing older ones, and the renderer reads the latest
+ *         values at its own pace. A bitmap marks the slots written since
+ *         they were last taken, so the renderer only visits those.
+ *
+ *         Each slot has one writer, which may run in interrupt context. A
+ *         slot holds a sequence number that is odd while the slot is being
+ *         written, so readers copy the slot and retry if the sequence
+ *         number was odd or changed meanwhile. The only interrupt lock is
+ *         the few instructions that take and clear one byte of the bitmap.
+ *
+ *****************************************************************************/
+#ifndef SIGSTORE_LIB_H
+#define SIGSTORE_LIB_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+
+
+/************************
+ * Constants and defines
+ ************************/
+
+//! Bytes of changed bitmap needed for the given number of slots.
+#define SIGSTORE_MAP_SIZE(slotCount) (((slotCount) + 7) / 8)
+
+
+
+/*********************
+ * Types and typedefs
+ *********************/
+
+//! One signal value with its time of update.
+typedef struct SIGSTORE_slot_struct
+{
+	int16_t volatile value;  //!< Latest value.
+	uint16_t volatile timestamp;  //!< Writer's time of update, e.g. timing_lib ticks.
+	uint8_t volatile sequence;  //!< Twice the number of updates, odd during an update.
+} SIGSTORE_slot_t;
+
+//! Signal store. Initialize with SIGSTORE_Init, do not modify directly.
+typedef struct SIGSTORE_store_struct
+{
+	SIGSTORE_slot_t * slots;  //!< Slot array.
+	uint8_t volatile * changed;  //!< Bitmap of slots written since last taken.
+	uint8_t slotCount;  //!< Number of slots.
+} SIGSTORE_store_t;
+
+
+
+/**********************
+ * Function prototypes
+ **********************/
+
+//! Initialize store with all values 0 and nothing changed.
+void SIGSTORE_Init( SIGSTORE_store_t * store, SIGSTORE_slot_t * slots, uint8_t volatile * changed, uint8_t slotCount );
+//! Write a slot and mark it changed. Returns true if the previous value was not taken yet.
+bool SIGSTORE_Write( SIGSTORE_store_t * store, uint8_t slot, int16_t value, uint16_t timestamp );
+//! Read a slot consistently. Returns its sequence number.
+uint8_t SIGSTORE_Read( SIGSTORE_store_t const * store, uint8_t slot, int16_t * value, uint16_t * timestamp );
+//! Read the value of a slot.
+int16_t SIGSTORE_GetValue( SIGSTORE_store_t const * store, uint8_t slot );
+//! Take and clear the changed bits of slots 8 * group to 8 * group + 7.
+uint8_t SIGSTORE_TakeChanged( SIGSTORE_store_t * store, uint8_t group );
+//! Return true if any slot has changed since last taken.
+bool SIGSTORE_HasChanged( SIGSTORE_store_t const * store );
+
+
+#endif
+// end of file
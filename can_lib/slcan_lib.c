@@ -0,0 +1,307 @@
+// This file has been prepared for Doxygen automatic documentation generation.
+/*! \file *********************************************************************
+ *
+ * \brief  Streaming SLCAN parser source file
+ *
+ *         A malformed frame line makes the parser skip to the next CR, so
+ *         one corrupted character costs one frame and the next line parses
+ *         normally.
+ *
+ *         Fields are accumulated in 16 bits. A 29-bit ID is received as two
+ *         halves of four digits, so only extended frames pay for building a
+ *         32-bit value, once per frame instead of once per digit.
+ *
+ *****************************************************************************/
+
+#include "slcan_lib.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <cal.h>
+
+
+
+/********************************
+ * Private constants and defines
+ ********************************/
+
+#define SLCAN_STD_ID_DIGITS 3  //!< Hex digits in an 11-bit ID.
+#define SLCAN_HALF_ID_DIGITS 4  //!< Hex digits in each half of a 29-bit ID.
+#define SLCAN_TIMESTAMP_DIGITS 4  //!< Hex digits in a timestamp.
+
+#define SLCAN_NOT_HEX 0xFF  //!< Hex table entry for non-hex characters.
+#define SLCAN_HEX_FIRST '0'  //!< First character in hex table.
+#define SLCAN_HEX_LAST 'f'  //!< Last character in hex table.
+
+//! Parser states.
+enum SLCAN_state_enum
+{
+	SLCAN_STATE_IDLE,  //!< Waiting for first character of a line.
+	SLCAN_STATE_ID_HIGH,  //!< Receiving upper half of a 29-bit ID.
+	SLCAN_STATE_ID,  //!< Receiving 11-bit ID or lower half of 29-bit ID.
+	SLCAN_STATE_DLC,  //!< Waiting for DLC digit.
+	SLCAN_STATE_DATA,  //!< Receiving data digits.
+	SLCAN_STATE_TAIL,  //!< Waiting for CR or first timestamp digit.
+	SLCAN_STATE_TIMESTAMP,  //!< Receiving timestamp digits.
+	SLCAN_STATE_END,  //!< Waiting for CR after timestamp.
+	SLCAN_STATE_RESPONSE,  //!< Collecting hex digits of a non-frame line up to CR.
+	SLCAN_STATE_SKIP,  //!< Skipping to CR of a malformed frame line.
+	SLCAN_STATE_FILTERED  //!< Skipping to CR of a frame line without route.
+};
+
+
+
+/********************
+ * Private variables
+ ********************/
+
+//! Value of hex digits from '0' to 'f', SLCAN_NOT_HEX for other characters.
+static uint8_t const CAL_PGM_DEF(SLCAN_hexTable[SLCAN_HEX_LAST - SLCAN_HEX_FIRST + 1]) = {
+	0, 1, 2, 3, 4, 5, 6, 7, 8, 9,  // '0' to '9'
+	SLCAN_NOT_HEX, SLCAN_NOT_HEX, SLCAN_NOT_HEX, SLCAN_NOT_HEX, SLCAN_NOT_HEX, SLCAN_NOT_HEX, SLCAN_NOT_HEX,  // ':' to '@'
+	10, 11, 12, 13, 14, 15,  // 'A' to 'F'
+	SLCAN_NOT_HEX, SLCAN_NOT_HEX, SLCAN_NOT_HEX, SLCAN_NOT_HEX, SLCAN_NOT_HEX, SLCAN_NOT_HEX, SLCAN_NOT_HEX, SLCAN_NOT_HEX,  // 'G' to 'N'
+	SLCAN_NOT_HEX, SLCAN_NOT_HEX, SLCAN_NOT_HEX, SLCAN_NOT_HEX, SLCAN_NOT_HEX, SLCAN_NOT_HEX, SLCAN_NOT_HEX, SLCAN_NOT_HEX,  // 'O' to 'V'
+	SLCAN_NOT_HEX, SLCAN_NOT_HEX, SLCAN_NOT_HEX, SLCAN_NOT_HEX, SLCAN_NOT_HEX, SLCAN_NOT_HEX, SLCAN_NOT_HEX, SLCAN_NOT_HEX,  // 'W' to '^'
+	SLCAN_NOT_HEX, SLCAN_NOT_HEX,  // '_' and '`'
+	10, 11, 12, 13, 14, 15  // 'a' to 'f'
+};
+
+
+
+/*******************************
+ * Internal function prototypes
+ *******************************/
+
+//! Get value of a hex digit, or SLCAN_NOT_HEX.
+static uint8_t SLCAN_HexValue( uint8_t character );
+//! Start a new line with its first character.
+static SLCAN_result_t SLCAN_StartLine( SLCAN_parser_t * parser, uint8_t character );
+//! Handle end of a frame field, move to next state.
+static void SLCAN_EndField( SLCAN_parser_t * parser );
+
+
+
+/***************************
+ * Function implementations
+ ***************************/
+
+void SLCAN_Init( SLCAN_parser_t * parser )
+{
+	parser->state = SLCAN_STATE_IDLE;
+	parser->FindRoute = NULL;
+	parser->route = CAN_NO_ROUTE;
+}
+
+
+void SLCAN_SetRouteFinder( SLCAN_parser_t * parser, SLCAN_RouteFinder_t FindRoute )
+{
+	parser->FindRoute = FindRoute;
+}
+
+
+/*!
+ *  Both CR and LF end a line, and an LF right after a CR is ignored, so
+ *  CRLF terminated test input works too.
+ *
+ * \param  parser     Parser state
+ * \param  character  Received character
+ *
+ * \return  SLCAN_PENDING until a line is complete, then what the line was
+ */
+SLCAN_result_t SLCAN_ProcessByte( SLCAN_parser_t * parser, uint8_t character )
+{
+	bool const endOfLine = (character == '\r') || (character == '\n');
+
+	switch (parser->state) {
+		case SLCAN_STATE_IDLE:
+			if (character == '\n') {
+				return SLCAN_PENDING;
+			}
+			return SLCAN_StartLine( parser, character );
+
+		case SLCAN_STATE_RESPONSE: {
+			if (endOfLine) {
+				parser->state = SLCAN_STATE_IDLE;
+				return SLCAN_RESPONSE;
+			}
+			uint8_t const digit = SLCAN_HexValue( character );
+			if (digit != SLCAN_NOT_HEX) {
+				parser->value = (parser->value << 4) | digit;
+			}
+			return SLCAN_PENDING;
+		}
+
+		case SLCAN_STATE_SKIP:
+			if (endOfLine) {
+				parser->state = SLCAN_STATE_IDLE;
+				return SLCAN_ERROR;
+			}
+			return SLCAN_PENDING;
+
+		case SLCAN_STATE_FILTERED:
+			if (endOfLine) {
+				parser->state = SLCAN_STATE_IDLE;
+				return SLCAN_FILTERED;
+			}
+			return SLCAN_PENDING;
+
+		case SLCAN_STATE_TAIL:
+		case SLCAN_STATE_END:
+			if (endOfLine) {
+				parser->state = SLCAN_STATE_IDLE;
+				return SLCAN_FRAME;
+			}
+			if (parser->state == SLCAN_STATE_TAIL) {
+				parser->state = SLCAN_STATE_TIMESTAMP;
+				parser->digitsLeft = SLCAN_TIMESTAMP_DIGITS;
+				parser->value = 0;
+				break;  // Digit handled below.
+			}
+			parser->state = SLCAN_STATE_SKIP;
+			return SLCAN_PENDING;
+
+		default:
+			break;
+	}
+
+	// The remaining states expect a hex digit.
+	uint8_t const digit = SLCAN_HexValue( character );
+	if (digit == SLCAN_NOT_HEX) {
+		parser->state = endOfLine ? SLCAN_STATE_IDLE : SLCAN_STATE_SKIP;
+		return endOfLine ? SLCAN_ERROR : SLCAN_PENDING;
+	}
+
+	parser->value = (parser->value << 4) | digit;
+	if (--parser->digitsLeft == 0) {
+		SLCAN_EndField( parser );
+	}
+	return SLCAN_PENDING;
+}
+
+
+static uint8_t SLCAN_HexValue( uint8_t character )
+{
+	if ((character < SLCAN_HEX_FIRST) || (character > SLCAN_HEX_LAST)) {
+		return SLCAN_NOT_HEX;
+	}
+	return CAL_pgm_read_byte( &SLCAN_hexTable[character - SLCAN_HEX_FIRST] );
+}
+
+
+static SLCAN_result_t SLCAN_StartLine( SLCAN_parser_t * parser, uint8_t character )
+{
+	parser->command = character;
+	parser->value = 0;
+	parser->frame.flags = 0x00;
+
+	switch (character) {
+		case SLCAN_CR:
+			return SLCAN_OK;
+
+		case SLCAN_BELL:
+			return SLCAN_NACK;
+
+		case 'T':
+		case 'R':
+			parser->frame.flags |= CAN_FLAG_EXTENDED;
+			parser->state = SLCAN_STATE_ID_HIGH;
+			parser->digitsLeft = SLCAN_HALF_ID_DIGITS;
+			break;
+
+		case 't':
+		case 'r':
+			parser->state = SLCAN_STATE_ID;
+			parser->digitsLeft = SLCAN_STD_ID_DIGITS;
+			break;
+
+		default:
+			parser->state = SLCAN_STATE_RESPONSE;
+			return SLCAN_PENDING;
+	}
+
+	if ((character == 'r') || (character == 'R')) {
+		parser->frame.flags |= CAN_FLAG_RTR;
+	}
+	return SLCAN_PENDING;
+}
+
+
+/*!
+ *  Checks the field value and stores it in the frame. Out of range IDs and
+ *  DLCs make the parser skip the rest of the line.
+ */
+static void SLCAN_EndField( SLCAN_parser_t * parser )
+{
+	CAN_frame_t * frame = &parser->frame;
+	uint16_t const value = parser->value;
+	parser->value = 0;
+
+	switch (parser->state) {
+		case SLCAN_STATE_ID_HIGH:
+			if (value > (uint16_t) (CAN_MAX_EXT_ID >> 16)) {
+				parser->state = SLCAN_STATE_SKIP;
+				return;
+			}
+			frame->id = (uint32_t) value << 16;
+			parser->state = SLCAN_STATE_ID;
+			parser->digitsLeft = SLCAN_HALF_ID_DIGITS;
+			break;
+
+		case SLCAN_STATE_ID:
+			if ((frame->flags & CAN_FLAG_EXTENDED) != 0x00) {
+				frame->id |= value;
+			} else if (value > CAN_MAX_STD_ID) {
+				parser->state = SLCAN_STATE_SKIP;
+				return;
+			} else {
+				frame->id = value;
+			}
+			if (parser->FindRoute != NULL) {
+				parser->route = parser->FindRoute( frame->id, frame->flags );
+				if (parser->route == CAN_NO_ROUTE) {
+					parser->state = SLCAN_STATE_FILTERED;
+					return;
+				}
+			}
+			parser->state = SLCAN_STATE_DLC;
+			parser->digitsLeft = 1;
+			break;
+
+		case SLCAN_STATE_DLC:
+			if (value > CAN_MAX_DLC) {
+				parser->state = SLCAN_STATE_SKIP;
+				return;
+			}
+			frame->dlc = value;
+			parser->dataIndex = 0;
+			if ((value == 0) || ((frame->flags & CAN_FLAG_RTR) != 0x00)) {
+				parser->state = SLCAN_STATE_TAIL;
+			} else {
+				parser->state = SLCAN_STATE_DATA;
+				parser->digitsLeft = 2;
+			}
+			break;
+
+		case SLCAN_STATE_DATA:
+			frame->data[parser->dataIndex] = value;
+			if (++parser->dataIndex < frame->dlc) {
+				parser->digitsLeft = 2;
+			} else {
+				parser->state = SLCAN_STATE_TAIL;
+			}
+			break;
+
+		case SLCAN_STATE_TIMESTAMP:
+			frame->timestamp = value;
+			frame->flags |= CAN_FLAG_TIMESTAMP;
+			parser->state = SLCAN_STATE_END;
+			break;
+
+		default:
+			parser->state = SLCAN_STATE_SKIP;
+			break;
+	}
+}
+
+
+// end of file
@@ -0,0 +1,86 @@
+// This file has been prepared for Doxygen automatic documentation generation.
+/*! \file *********************************************************************
+ *
+ * \brief  Streaming SLCAN parser header file
+ *
+ *         Decodes the ASCII lines of an SLCAN (Lawicel) adapter one byte at
+ *         a time, straight into a binary CAN_frame_t. There is no line
+ *         buffer and no string handling, each character is checked and
+ *         merged into the frame as it arrives, and the frame is validated
+ *         and handed over when the terminating CR arrives.
+ *
+ *         Frame lines are 'tiiil<data>', 'Tiiiiiiiil<data>', 'riiil' and
+ *         'Riiiiiiiil', with 3 or 8 hex ID digits, one DLC digit and two hex
+ *         digits per data byte, optionally followed by a 4 hex digit
+ *         timestamp. Other lines are reported as adapter responses.
+ *
+ *         A route finder, normally CAN_FindRoute, can be given to look up
+ *         the ID as soon as its last digit arrives. Lines with IDs that have
+ *         no route are then skipped without decoding the data.
+ *
+ *****************************************************************************/
+#ifndef SLCAN_LIB_H
+#define SLCAN_LIB_H
+
+#include <stdint.h>
+#include <can_lib.h>
+
+
+
+/************************
+ * Constants and defines
+ ************************/
+
+#define SLCAN_CR   '\r'  //!< Line terminator and positive adapter response.
+#define SLCAN_BELL '\a'  //!< Negative adapter response.
+
+//! Results of SLCAN_ProcessByte.
+enum SLCAN_result_enum
+{
+	SLCAN_PENDING,  //!< Line not complete yet.
+	SLCAN_FRAME,  //!< Valid frame received, see SLCAN_parser_t::frame.
+	SLCAN_OK,  //!< Empty line, i.e. adapter said OK. Transmit acknowledges z and Z are SLCAN_RESPONSE.
+	SLCAN_NACK,  //!< Adapter answered with BELL.
+	SLCAN_RESPONSE,  //!< Other adapter line, e.g. version, first character in SLCAN_parser_t::command and last four hex digits in SLCAN_parser_t::value.
+	SLCAN_ERROR,  //!< Malformed frame line, dropped.
+	SLCAN_FILTERED  //!< Frame line with an ID that has no route, dropped.
+};
+
+
+
+/*********************
+ * Types and typedefs
+ *********************/
+
+typedef uint8_t SLCAN_result_t;  //!< One of SLCAN_* results.
+typedef uint8_t (* SLCAN_RouteFinder_t)( uint32_t id, uint8_t flags );  //!< Returns route number or CAN_NO_ROUTE.
+
+//! Parser state. Initialize with SLCAN_Init, do not modify directly.
+typedef struct SLCAN_parser_struct
+{
+	uint8_t state;  //!< Internal parser state.
+	uint8_t digitsLeft;  //!< Hex digits left in current field.
+	uint8_t dataIndex;  //!< Index of data byte being received.
+	uint8_t command;  //!< First character of current line.
+	uint16_t value;  //!< Current field being accumulated, or hex digits of a response line.
+	SLCAN_RouteFinder_t FindRoute;  //!< Route finder, or NULL to accept all IDs.
+	uint8_t route;  //!< Route number of frame, CAN_NO_ROUTE without route finder.
+	CAN_frame_t frame;  //!< Frame being received, valid after SLCAN_FRAME until next byte.
+} SLCAN_parser_t;
+
+
+
+/**********************
+ * Function prototypes
+ **********************/
+
+//! Reset parser to wait for the start of a line.
+void SLCAN_Init( SLCAN_parser_t * parser );
+//! Set route finder called with each ID, or NULL to accept all IDs.
+void SLCAN_SetRouteFinder( SLCAN_parser_t * parser, SLCAN_RouteFinder_t FindRoute );
+//! Feed one received character to the parser.
+SLCAN_result_t SLCAN_ProcessByte( SLCAN_parser_t * parser, uint8_t character );
+
+
+#endif
+// end of file
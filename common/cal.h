@@ -89,6 +89,7 @@ CAL_function
 #define CAL_pgm_read_byte(CAL_address)    (*CAL_address)
 #define CAL_pgm_read_char(CAL_address)    ((char)(*CAL_address))
 #define CAL_pgm_read_word(CAL_address)    (*CAL_address)
+#define CAL_pgm_read_dword(CAL_address)   (*CAL_address)
 #define CAL_pgm_read_pchar(CAL_address)   ((char __flash *)(*CAL_address))
 #define CAL_pgm_read_puint8(CAL_address)  ((uint8_t __flash *)(*CAL_address))
 #define CAL_pgm_read_puint16(CAL_address) ((uint16_t __flash *)(*CAL_address))
@@ -146,6 +147,7 @@ int main (void)
 #define CAL_pgm_read_byte(CAL_address)    (pgm_read_byte( CAL_address ))
 #define CAL_pgm_read_char(CAL_address)    ((char)(pgm_read_byte( CAL_address )))
 #define CAL_pgm_read_word(CAL_address)    (pgm_read_word( CAL_address ))
+#define CAL_pgm_read_dword(CAL_address)   (pgm_read_dword( CAL_address ))
 #define CAL_pgm_read_pchar(CAL_address)   ((char*)(pgm_read_word(CAL_address)))
 #define CAL_pgm_read_puint8(CAL_address)  ((uint8_t*)(pgm_read_word(CAL_address)))
 #define CAL_pgm_read_puint16(CAL_address) ((uint16_t*)(pgm_read_word(CAL_address)))
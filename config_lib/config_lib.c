@@ -0,0 +1,309 @@
+// This file has been prepared for Doxygen automatic documentation generation.
+/*! \file *********************************************************************
+ *
+ * \brief  Wear-levelled EEPROM configuration store source file
+ *
+ *         A record is the configuration data followed by a 16-bit version
+ *         and a CRC-8 of both. Version 0xFFFF is never used, so an erased
+ *         slot is never taken for a record. The CRC is computed from the
+ *         bytes as they are written, so a setting changed during a commit
+ *         gives a consistent record and simply marks the copy dirty again.
+ *
+ *****************************************************************************/
+
+#include "config_lib.h"
+#include <cal.h>
+#include <avr/eeprom.h>
+
+
+
+/********************************
+ * Private constants and defines
+ ********************************/
+
+#define CONFIG_VERSION_OFFSET CONFIG_DATA_SIZE  //!< Record offset of version, low byte first.
+#define CONFIG_CRC_OFFSET (CONFIG_DATA_SIZE + 2)  //!< Record offset of CRC.
+#define CONFIG_RECORD_SIZE (CONFIG_DATA_SIZE + 3)  //!< Bytes per record.
+#define CONFIG_ERASED_VERSION 0xFFFF  //!< Version read from an erased slot.
+
+#define CONFIG_CRC_INIT 0x00  //!< CRC-8 start value.
+#define CONFIG_CRC_POLYNOMIAL 0x07  //!< CRC-8 polynomial, x^8 + x^2 + x + 1.
+
+#define CONFIG_FLAG_DIRTY     (1<<0)  //!< RAM copy has changes not committed.
+#define CONFIG_FLAG_SCHEDULED (1<<1)  //!< Commit event is queued.
+#define CONFIG_FLAG_WRITING   (1<<2)  //!< Record is being written.
+
+
+
+/********************
+ * Private variables
+ ********************/
+
+static uint8_t CONFIG_data[CONFIG_DATA_SIZE];  //!< RAM copy of configuration data.
+static uint8_t volatile CONFIG_flags;  //!< Combination of CONFIG_FLAG_* flags.
+static uint8_t CONFIG_slot;  //!< Slot of newest record.
+static uint16_t CONFIG_version;  //!< Version of newest record.
+static TIMING_event_t CONFIG_commitEvent;  //!< Deferred commit event.
+static CONFIG_stats_t CONFIG_stats;  //!< Write statistics.
+
+static uint8_t CONFIG_writeSlot;  //!< Slot of record being written.
+static uint16_t CONFIG_writeVersion;  //!< Version of record being written.
+static uint16_t CONFIG_writeAddress;  //!< EEPROM address of next record byte.
+static uint8_t CONFIG_writeIndex;  //!< Offset of next record byte.
+static uint8_t CONFIG_writeCrc;  //!< CRC of record bytes so far.
+
+
+
+/*******************************
+ * Internal function prototypes
+ *******************************/
+
+//! Add one byte to a CRC-8.
+static uint8_t CONFIG_UpdateCrc( uint8_t crc, uint8_t data );
+//! Return EEPROM address of a slot.
+static uint16_t CONFIG_SlotAddress( uint8_t slot );
+//! Check a record in EEPROM, returning its version or CONFIG_ERASED_VERSION if invalid.
+static uint16_t CONFIG_CheckRecord( uint8_t slot );
+//! Return true if version a is newer than version b.
+static bool CONFIG_IsNewer( uint16_t a, uint16_t b );
+//! Begin writing a record. Interrupts must be disabled.
+static void CONFIG_StartWrite( void );
+//! Get next byte of record being written, updating its CRC.
+static uint8_t CONFIG_NextWriteByte( void );
+//! Deferred commit event handler, called in interrupt context.
+static void CONFIG_CommitHandler( void );
+//! Add to a statistics counter without wrapping.
+static void CONFIG_Count( uint16_t * counter );
+
+
+
+/***************************
+ * Function implementations
+ ***************************/
+
+/*!
+ *  Reads the whole ring once, which takes about a millisecond. Call before
+ *  enabling interrupts or at least before any CONFIG_Set.
+ *
+ * \return  True if a valid record was found
+ */
+bool CONFIG_Init( void )
+{
+	CONFIG_flags = 0x00;
+	CONFIG_stats.commits = 0;
+	CONFIG_stats.bytesWritten = 0;
+	CONFIG_stats.bytesSkipped = 0;
+
+	// Without a record, the first commit goes to slot 0 with version 0.
+	bool found = false;
+	CONFIG_slot = CONFIG_RECORD_COUNT - 1;
+	CONFIG_version = CONFIG_ERASED_VERSION;
+	for (uint8_t slot = 0; slot < CONFIG_RECORD_COUNT; ++slot) {
+		uint16_t const version = CONFIG_CheckRecord( slot );
+		if ((version != CONFIG_ERASED_VERSION) && ((found == false) || CONFIG_IsNewer( version, CONFIG_version ))) {
+			found = true;
+			CONFIG_slot = slot;
+			CONFIG_version = version;
+		}
+	}
+
+	if (found) {
+		eeprom_read_block( CONFIG_data, (void const *) CONFIG_SlotAddress( CONFIG_slot ), CONFIG_DATA_SIZE );
+	} else {
+		for (uint8_t index = 0; index < CONFIG_DATA_SIZE; ++index) {
+			CONFIG_data[index] = 0;
+		}
+	}
+	return found;
+}
+
+
+uint8_t CONFIG_Get( uint8_t item )
+{
+	return (item < CONFIG_DATA_SIZE) ? CONFIG_data[item] : 0;
+}
+
+
+/*!
+ *  The commit is scheduled by the first change only, so a sender changing
+ *  settings continuously still gets at most one commit per commit delay.
+ *
+ * \param  item   One of CONFIG_* items, out of range items are ignored
+ * \param  value  New value
+ *
+ * \return  True if the value differs from the previous one
+ */
+bool CONFIG_Set( uint8_t item, uint8_t value )
+{
+	if ((item >= CONFIG_DATA_SIZE) || (CONFIG_data[item] == value)) {
+		return false;
+	}
+
+	uint8_t const storedSREG = SREG;
+	CAL_disable_interrupt();
+	CONFIG_data[item] = value;
+	CONFIG_flags |= CONFIG_FLAG_DIRTY;
+	if ((CONFIG_flags & CONFIG_FLAG_SCHEDULED) == 0x00) {
+		CONFIG_flags |= CONFIG_FLAG_SCHEDULED;
+		TIMING_AddCallbackEventAfter( CONFIG_COMMIT_DELAY, CONFIG_CommitHandler, &CONFIG_commitEvent );
+	}
+	SREG = storedSREG;
+	return true;
+}
+
+
+void CONFIG_Commit( void )
+{
+	uint8_t const storedSREG = SREG;
+	CAL_disable_interrupt();
+	if ((CONFIG_flags & CONFIG_FLAG_SCHEDULED) != 0x00) {
+		TIMING_RemoveEvent( &CONFIG_commitEvent );
+	}
+	CONFIG_CommitHandler();
+	SREG = storedSREG;
+}
+
+
+bool CONFIG_IsBusy( void )
+{
+	return (CONFIG_flags & (CONFIG_FLAG_DIRTY | CONFIG_FLAG_WRITING)) != 0x00;
+}
+
+
+void CONFIG_GetStats( CONFIG_stats_t * stats )
+{
+	uint8_t const storedSREG = SREG;
+	CAL_disable_interrupt();
+	*stats = CONFIG_stats;
+	SREG = storedSREG;
+}
+
+
+static uint8_t CONFIG_UpdateCrc( uint8_t crc, uint8_t data )
+{
+	crc ^= data;
+	for (uint8_t bit = 0; bit < 8; ++bit) {
+		crc = ((crc & 0x80) != 0x00) ? (uint8_t) ((crc << 1) ^ CONFIG_CRC_POLYNOMIAL) : (uint8_t) (crc << 1);
+	}
+	return crc;
+}
+
+
+static uint16_t CONFIG_SlotAddress( uint8_t slot )
+{
+	return CONFIG_RING_START + (uint16_t) slot * CONFIG_RECORD_SIZE;
+}
+
+
+static uint16_t CONFIG_CheckRecord( uint8_t slot )
+{
+	uint8_t const * address = (uint8_t const *) CONFIG_SlotAddress( slot );
+	uint8_t crc = CONFIG_CRC_INIT;
+	for (uint8_t index = 0; index < CONFIG_CRC_OFFSET; ++index) {
+		crc = CONFIG_UpdateCrc( crc, eeprom_read_byte( address + index ) );
+	}
+	if (crc != eeprom_read_byte( address + CONFIG_CRC_OFFSET )) {
+		return CONFIG_ERASED_VERSION;
+	}
+	return eeprom_read_word( (uint16_t const *) (address + CONFIG_VERSION_OFFSET) );
+}
+
+
+/*!
+ *  Versions wrap around, but the records in the ring are never more than
+ *  CONFIG_RECORD_COUNT versions apart.
+ */
+static bool CONFIG_IsNewer( uint16_t a, uint16_t b )
+{
+	return (int16_t) (a - b) > 0;
+}
+
+
+static void CONFIG_StartWrite( void )
+{
+	CONFIG_flags = (CONFIG_flags & ~CONFIG_FLAG_DIRTY) | CONFIG_FLAG_WRITING;
+	CONFIG_writeSlot = (CONFIG_slot + 1 < CONFIG_RECORD_COUNT) ? CONFIG_slot + 1 : 0;
+	CONFIG_writeVersion = CONFIG_version + 1;
+	if (CONFIG_writeVersion == CONFIG_ERASED_VERSION) {
+		CONFIG_writeVersion = 0;
+	}
+	CONFIG_writeAddress = CONFIG_SlotAddress( CONFIG_writeSlot );
+	CONFIG_writeIndex = 0;
+	CONFIG_writeCrc = CONFIG_CRC_INIT;
+	EECR |= (1 << EERIE);
+}
+
+
+static uint8_t CONFIG_NextWriteByte( void )
+{
+	uint8_t const index = CONFIG_writeIndex++;
+	uint8_t data;
+	if (index < CONFIG_VERSION_OFFSET) {
+		data = CONFIG_data[index];
+	} else if (index == CONFIG_VERSION_OFFSET) {
+		data = (uint8_t) CONFIG_writeVersion;
+	} else if (index == CONFIG_VERSION_OFFSET + 1) {
+		data = (uint8_t) (CONFIG_writeVersion >> 8);
+	} else {
+		return CONFIG_writeCrc;
+	}
+	CONFIG_writeCrc = CONFIG_UpdateCrc( CONFIG_writeCrc, data );
+	return data;
+}
+
+
+/*!
+ *  A commit due while a record is still being written is started when
+ *  that record is complete.
+ */
+static void CONFIG_CommitHandler( void )
+{
+	CONFIG_flags &= ~CONFIG_FLAG_SCHEDULED;
+	if (((CONFIG_flags & CONFIG_FLAG_DIRTY) != 0x00) && ((CONFIG_flags & CONFIG_FLAG_WRITING) == 0x00)) {
+		CONFIG_StartWrite();
+	}
+}
+
+
+static void CONFIG_Count( uint16_t * counter )
+{
+	if (*counter != 0xFFFF) {
+		++(*counter);
+	}
+}
+
+
+/*!
+ *  Skips record bytes that already hold the right value and starts writing
+ *  the first one that does not. The interrupt comes again when that write
+ *  is done. The EEPROM is idle while this runs, so it can be read directly.
+ */
+CAL_ISR(EE_READY_vect)
+{
+	while (CONFIG_writeIndex < CONFIG_RECORD_SIZE) {
+		uint8_t const data = CONFIG_NextWriteByte();
+		EEAR = CONFIG_writeAddress++;
+		EECR |= (1 << EERE);
+		if (EEDR != data) {
+			EEDR = data;
+			EECR |= (1 << EEMPE);
+			EECR |= (1 << EEPE);
+			CONFIG_Count( &CONFIG_stats.bytesWritten );
+			return;
+		}
+		CONFIG_Count( &CONFIG_stats.bytesSkipped );
+	}
+
+	EECR &= ~(1 << EERIE);
+	CONFIG_slot = CONFIG_writeSlot;
+	CONFIG_version = CONFIG_writeVersion;
+	CONFIG_flags &= ~CONFIG_FLAG_WRITING;
+	CONFIG_Count( &CONFIG_stats.commits );
+
+	if ((CONFIG_flags & (CONFIG_FLAG_DIRTY | CONFIG_FLAG_SCHEDULED)) == CONFIG_FLAG_DIRTY) {
+		CONFIG_StartWrite();
+	}
+}
+
+
+// end of file
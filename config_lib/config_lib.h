@@ -0,0 +1,84 @@
+// This file has been prepared for Doxygen automatic documentation generation.
+/*! \file *********************************************************************
+ *
+ * \brief  Wear-levelled EEPROM configuration store header file
+ *
+ *         Settings are kept in a RAM copy and read from there. Changing a
+ *         setting only marks the copy dirty, and a commit is scheduled with
+ *         timing_lib CONFIG_COMMIT_DELAY ticks later, so a burst of changes
+ *         costs one commit. Setting a value that is already set does
+ *         nothing at all.
+ *
+ *         A commit writes the whole copy as a new record into the next slot
+ *         of a ring of CONFIG_RECORD_COUNT slots in EEPROM, spreading wear
+ *         over all of them. Each record has a version number and a CRC, the
+ *         valid record with the newest version is loaded at start-up, and a
+ *         commit cut short by a reset leaves the previous record in place.
+ *
+ *         EEPROM bytes are written from the EE_READY interrupt, one byte
+ *         per interrupt, so the main loop never waits for the EEPROM. Bytes
+ *         already holding the right value are not written again.
+ *
+ *****************************************************************************/
+#ifndef CONFIG_LIB_H
+#define CONFIG_LIB_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <timing_lib.h>
+#include <rtc_driver.h>
+
+
+
+/************************
+ * Constants and defines
+ ************************/
+
+#define CONFIG_DATA_SIZE 16  //!< Bytes of configuration data.
+#define CONFIG_RECORD_COUNT 64  //!< Records in EEPROM ring.
+#define CONFIG_RING_START 32  //!< EEPROM address of first record, leaves the legacy settings alone.
+#define CONFIG_COMMIT_DELAY (2 * RTC_TICKS_PER_SECOND)  //!< Ticks from first change to commit.
+
+//! Configuration items, byte offsets into the configuration data.
+#define CONFIG_CONTRAST  0  //!< LCD contrast, 0 to 63.
+#define CONFIG_RED       1  //!< Backlight red.
+#define CONFIG_GREEN     2  //!< Backlight green.
+#define CONFIG_BLUE      3  //!< Backlight blue.
+#define CONFIG_INTENSITY 4  //!< Backlight intensity.
+
+
+
+/*********************
+ * Types and typedefs
+ *********************/
+
+//! Write statistics. Counters saturate instead of wrapping.
+typedef struct CONFIG_stats_struct
+{
+	uint16_t commits;  //!< Records written.
+	uint16_t bytesWritten;  //!< EEPROM bytes written.
+	uint16_t bytesSkipped;  //!< EEPROM bytes that already held the right value.
+} CONFIG_stats_t;
+
+
+
+/**********************
+ * Function prototypes
+ **********************/
+
+//! Load newest valid record into RAM copy. Returns false and clears the copy if there is none.
+bool CONFIG_Init( void );
+//! Get a configuration byte.
+uint8_t CONFIG_Get( uint8_t item );
+//! Set a configuration byte, scheduling a commit. Returns true if the value changed.
+bool CONFIG_Set( uint8_t item, uint8_t value );
+//! Start committing changes now instead of after the commit delay.
+void CONFIG_Commit( void );
+//! Return true while changes are waiting for or being written to EEPROM.
+bool CONFIG_IsBusy( void );
+//! Copy write statistics.
+void CONFIG_GetStats( CONFIG_stats_t * stats );
+
+
+#endif
+// end of file
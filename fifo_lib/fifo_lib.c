@@ -464,3 +464,46 @@ void FIFO_GetBlock( FIFO_handle_t * handle, void * data, FIFO_size_t size )
 		--size;
 	}
 }
+
+
+/*!
+ * \param  ring    Ring buffer control block
+ * \param  buffer  Buffer memory
+ * \param  size    Buffer size, a power of two, at most 128
+ */
+void FIFO_RingInit( FIFO_ring_t * ring, FIFO_data_t * buffer, FIFO_size_t size )
+{
+	ring->buffer = buffer;
+	ring->mask = size - 1;
+	ring->head = 0;
+	ring->tail = 0;
+}
+
+
+/*!
+ *  Must only be called by the consumer. The items are copied before "tail"
+ *  is moved once for the whole block, so the producer can refill the space
+ *  only after it has been read.
+ *
+ * \param  ring     Ring buffer to get data from
+ * \param  data     Where to save the data
+ * \param  maxSize  Max number of items to get
+ *
+ * \return  Number of items saved, 0 if ring was empty
+ */
+FIFO_size_t FIFO_RingGetBlock( FIFO_ring_t * ring, FIFO_data_t * data, FIFO_size_t maxSize )
+{
+	FIFO_size_t tail = ring->tail;
+	FIFO_size_t count = ring->head - tail;
+	if (count > maxSize) {
+		count = maxSize;
+	}
+
+	for (FIFO_size_t index = 0; index < count; ++index) {
+		data[index] = ring->buffer[tail & ring->mask];
+		++tail;
+	}
+	ring->tail = tail;
+
+	return count;
+}
@@ -254,5 +254,65 @@ void     FIFO_GetBlock ( FIFO_handle_t * handle, void * data, FIFO_size_t size )
 #define FIFO_QuickGetUint8(handle)       ((uint8_t) FIFO_QuickGetData( (handle) ))
 
 
+/****************************************************************************
+ * Lock-free ring buffer for one producer and one consumer.
+ *
+ * The ring is meant for passing bytes from an interrupt handler to the main
+ * loop, or the other way round, without disabling interrupts. The producer
+ * only writes "head" and the consumer only writes "tail". Both are free
+ * running counts that wrap at 256, so the number of items is their
+ * difference, and the buffer position is found by masking with the buffer
+ * size minus one. The buffer size must therefore be a power of two, at
+ * most 128.
+ ****************************************************************************/
+
+//! Ring buffer control block. Initialize with FIFO_RingInit.
+typedef struct FIFO_ring_struct
+{
+	FIFO_data_t * buffer;  //!< Buffer memory, a power of two in size.
+	FIFO_size_t mask;  //!< Buffer size minus one.
+	FIFO_size_t volatile head;  //!< Items inserted so far, written by producer only.
+	FIFO_size_t volatile tail;  //!< Items removed so far, written by consumer only.
+} FIFO_ring_t;
+
+//! Initialize a ring buffer. The size must be a power of two, at most 128.
+void FIFO_RingInit( FIFO_ring_t * ring, FIFO_data_t * buffer, FIFO_size_t size );
+//! Remove up to "maxSize" items into "data". Returns number of items removed.
+FIFO_size_t FIFO_RingGetBlock( FIFO_ring_t * ring, FIFO_data_t * data, FIFO_size_t maxSize );
+
+//! Get number of items in ring.
+#define FIFO_RingGetItemsUsed(ring)  ((FIFO_size_t) ((ring)->head - (ring)->tail))
+//! Return true if ring is full.
+#define FIFO_RingIsFull(ring)        (FIFO_RingGetItemsUsed( (ring) ) > (ring)->mask)
+//! Return true if ring is empty.
+#define FIFO_RingIsEmpty(ring)       ((ring)->head == (ring)->tail)
+
+/*! \brief  Macro for inserting one item into a ring, for use by the producer.
+ *
+ *  The data is stored before "head" is moved, so the consumer never sees
+ *  an item that is not there yet. The caller must check FIFO_RingIsFull
+ *  first.
+ */
+#define FIFO_RingQuickPut(ring,data)                                  \
+{                                                                     \
+	FIFO_size_t const ringHead = (ring)->head;                        \
+	(ring)->buffer[ringHead & (ring)->mask] = (data);                 \
+	(ring)->head = ringHead + 1;                                      \
+}
+
+/*! \brief  Macro for removing one item from a ring, for use by the consumer.
+ *
+ *  The item is read before "tail" is moved, so the producer never
+ *  overwrites it too early. The caller must check FIFO_RingIsEmpty first.
+ */
+#define FIFO_RingQuickGet(ring,data)                                  \
+{                                                                     \
+	FIFO_size_t const ringTail = (ring)->tail;                        \
+	(data) = (ring)->buffer[ringTail & (ring)->mask];                 \
+	(ring)->tail = ringTail + 1;                                      \
+}
+// end
+
+
 
 #endif
@@ -0,0 +1,274 @@
+// This file has been prepared for Doxygen automatic documentation generation.
+/*! \file *********************************************************************
+ *
+ * \brief  Blinking alert banner source file
+ *
+ *         The banner image is rendered again on every toggle instead of
+ *         being kept in SRAM. The text pointer is kept, so the image that
+ *         is XOR-ed away is always the one that was XOR-ed on.
+ *
+ *****************************************************************************/
+
+#include "alert_lib.h"
+#include <stddef.h>
+#include <string.h>
+#include <lcd_lib.h>
+#include <termfont_lib.h>
+#include <timing_lib.h>
+#include <fifo_lib.h>
+#include <song_lib.h>
+#include <backlight_driver.h>
+
+
+
+/********************************
+ * Private constants and defines
+ ********************************/
+
+#define ALERT_SOUND_FIFO_SIZE 8  //!< Audio FIFO size, two notes.
+
+
+
+/*********************
+ * Types and typedefs
+ *********************/
+
+//! One alert slot.
+typedef struct ALERT_slot_struct
+{
+	uint8_t priority;  //!< Alert priority, 0 if slot is empty.
+	uint8_t flags;  //!< Combination of ALERT_FLAG_* flags.
+	uint8_t beepsLeft;  //!< Blinks that still beep.
+	char const CAL_PGM(* text);  //!< Banner text in flash.
+} ALERT_slot_t;
+
+
+
+/********************
+ * Private variables
+ ********************/
+
+static ALERT_slot_t ALERT_slots[ALERT_SLOT_COUNT];  //!< All alert slots.
+
+static uint8_t ALERT_page;  //!< Banner LCD page.
+static uint8_t ALERT_column;  //!< Leftmost banner column.
+static uint8_t ALERT_width;  //!< Banner width in columns.
+
+static char const CAL_PGM(* ALERT_drawnText);  //!< Text of banner on LCD, NULL if banner is off.
+static uint8_t ALERT_suspendCount;  //!< Nesting level of ALERT_Suspend.
+static bool ALERT_dimmed;  //!< True if backlight is dimmed.
+static uint8_t ALERT_intensity;  //!< Backlight intensity to restore.
+
+static TIMING_event_t ALERT_blinkEvent;  //!< Periodic blink event.
+static TIMING_counter_t volatile ALERT_blinkCount;  //!< Blink periods passed since last task.
+
+static FIFO_handle_t ALERT_soundFifo;  //!< Audio FIFO for beeps.
+static FIFO_data_t ALERT_soundBuffer[ALERT_SOUND_FIFO_SIZE];  //!< Audio FIFO storage.
+
+//! Short two-tone beep.
+static uint16_t const CAL_PGM_DEF(ALERT_beepTune[]) = {
+	SOUND_timeToTimingTicks(0.0625), SOUND_A2,
+	SOUND_timeToTimingTicks(0.0625), SOUND_E2,
+	SOUND_STOP
+};
+
+
+
+/*******************************
+ * Internal function prototypes
+ *******************************/
+
+//! Return slot of highest priority alert, or ALERT_SLOT_COUNT if none.
+static uint8_t ALERT_GetTopSlot( void );
+//! XOR banner image with given text onto LCD.
+static void ALERT_FlipBanner( char const CAL_PGM(* text) );
+//! Dim or restore backlight.
+static void ALERT_SetDimmed( bool dimmed );
+
+
+
+/***************************
+ * Function implementations
+ ***************************/
+
+/*!
+ * \param  page    LCD page of banner
+ * \param  column  Leftmost column of banner
+ * \param  width   Banner width in columns
+ */
+void ALERT_Init( uint8_t page, uint8_t column, uint8_t width )
+{
+	memset( ALERT_slots, 0x00, sizeof(ALERT_slots) );
+	ALERT_page = page;
+	ALERT_column = column;
+	ALERT_width = width;
+	ALERT_drawnText = NULL;
+	ALERT_suspendCount = 0;
+	ALERT_dimmed = false;
+
+	FIFO_Init( &ALERT_soundFifo, ALERT_soundBuffer, ALERT_SOUND_FIFO_SIZE );
+
+	TIMING_RemoveEvent( &ALERT_blinkEvent );
+	ALERT_blinkCount = 0;
+	TIMING_AddRepCounterEvent( TIMING_INFINITE_REPEAT, ALERT_BLINK_PERIOD, &ALERT_blinkCount, &ALERT_blinkEvent );
+}
+
+
+/*!
+ *  The banner changes on the next blink if the new alert has the highest
+ *  priority. Among alerts with equal priority the lowest slot wins.
+ *
+ * \param  slot      Alert slot, below ALERT_SLOT_COUNT
+ * \param  priority  Priority, higher is more important
+ * \param  flags     Combination of ALERT_FLAG_* flags
+ * \param  text      Banner text in flash, at most banner width / TERMFONT_CHAR_WIDTH characters
+ */
+void ALERT_Raise( uint8_t slot, uint8_t priority, uint8_t flags, char const CAL_PGM(* text) )
+{
+	if (slot >= ALERT_SLOT_COUNT) {
+		return;
+	}
+	ALERT_slots[slot].priority = priority;
+	ALERT_slots[slot].flags = flags;
+	ALERT_slots[slot].beepsLeft = ((flags & ALERT_FLAG_SOUND) != 0x00) ? ALERT_BEEP_COUNT : 0;
+	ALERT_slots[slot].text = text;
+}
+
+
+void ALERT_Clear( uint8_t slot )
+{
+	if (slot < ALERT_SLOT_COUNT) {
+		ALERT_slots[slot].priority = 0;
+	}
+}
+
+
+bool ALERT_IsActive( uint8_t slot )
+{
+	return (slot < ALERT_SLOT_COUNT) && (ALERT_slots[slot].priority != 0);
+}
+
+
+/*!
+ *  A visible banner is always removed on a blink, and the top alert, if
+ *  any, is put on at the next blink. Cleared alerts therefore go away
+ *  within one blink period. If the task is late, missed blinks are not
+ *  made up for.
+ */
+void ALERT_Task( void )
+{
+	if ((ALERT_blinkCount == 0) || (ALERT_suspendCount != 0)) {
+		return;
+	}
+	uint8_t const storedSREG = SREG;
+	CAL_disable_interrupt();
+	ALERT_blinkCount = 0;
+	SREG = storedSREG;
+
+	if (ALERT_drawnText != NULL) {
+		ALERT_FlipBanner( ALERT_drawnText );
+		ALERT_drawnText = NULL;
+		if (ALERT_dimmed == false) {
+			uint8_t const top = ALERT_GetTopSlot();
+			if ((top < ALERT_SLOT_COUNT) && ((ALERT_slots[top].flags & ALERT_FLAG_BACKLIGHT) != 0x00)) {
+				ALERT_SetDimmed( true );
+			}
+		}
+		return;
+	}
+
+	uint8_t const top = ALERT_GetTopSlot();
+	ALERT_SetDimmed( false );
+	if (top < ALERT_SLOT_COUNT) {
+		ALERT_slot_t * slot = &ALERT_slots[top];
+		ALERT_drawnText = slot->text;
+		ALERT_FlipBanner( ALERT_drawnText );
+
+		if (slot->beepsLeft != 0) {
+			--slot->beepsLeft;
+			SONG_StartTune_F( &ALERT_soundFifo, ALERT_beepTune );
+		}
+	}
+}
+
+
+void ALERT_Suspend( void )
+{
+	if ((ALERT_suspendCount++ == 0) && (ALERT_drawnText != NULL)) {
+		ALERT_FlipBanner( ALERT_drawnText );
+	}
+}
+
+
+/*!
+ *  The banner is put back with the same text it had, even if the alerts
+ *  changed meanwhile. The next blink removes it as usual.
+ */
+void ALERT_Resume( void )
+{
+	if ((ALERT_suspendCount != 0) && (--ALERT_suspendCount == 0) && (ALERT_drawnText != NULL)) {
+		ALERT_FlipBanner( ALERT_drawnText );
+	}
+}
+
+
+static uint8_t ALERT_GetTopSlot( void )
+{
+	uint8_t top = ALERT_SLOT_COUNT;
+	uint8_t topPriority = 0;
+	for (uint8_t slot = 0; slot < ALERT_SLOT_COUNT; ++slot) {
+		if (ALERT_slots[slot].priority > topPriority) {
+			top = slot;
+			topPriority = ALERT_slots[slot].priority;
+		}
+	}
+	return top;
+}
+
+
+/*!
+ *  The image is the text centered on a solid bar, inverted, so the banner
+ *  stands out over both empty and busy screen areas. Text longer than the
+ *  banner is cut.
+ */
+static void ALERT_FlipBanner( char const CAL_PGM(* text) )
+{
+	uint8_t image[LCD_WIDTH];
+	memset( image, 0x00, ALERT_width );
+
+	uint8_t const maxLength = ALERT_width / TERMFONT_CHAR_WIDTH;
+	uint8_t length = 0;
+	while ((length < maxLength) && (CAL_pgm_read_char( &text[length] ) != '\0')) {
+		++length;
+	}
+
+	uint8_t * pImage = image + (ALERT_width - length * TERMFONT_CHAR_WIDTH) / 2;
+	for (uint8_t index = 0; index < length; ++index) {
+		TERMFONT_DisplayPageBufferChar( pImage, CAL_pgm_read_char( &text[index] ) );
+		pImage += TERMFONT_CHAR_WIDTH;
+	}
+
+	for (uint8_t column = 0; column < ALERT_width; ++column) {
+		image[column] = ~image[column];
+	}
+
+	LCD_XORPage( image, ALERT_page, ALERT_column, ALERT_width );
+}
+
+
+static void ALERT_SetDimmed( bool dimmed )
+{
+	if (dimmed == ALERT_dimmed) {
+		return;
+	}
+	ALERT_dimmed = dimmed;
+	if (dimmed) {
+		ALERT_intensity = BACKLIGHT_GetIntensity();
+		BACKLIGHT_SetIntensity( 0 );
+	} else {
+		BACKLIGHT_SetIntensity( ALERT_intensity );
+	}
+}
+
+
+// end of file
@@ -0,0 +1,64 @@
+// This file has been prepared for Doxygen automatic documentation generation.
+/*! \file *********************************************************************
+ *
+ * \brief  Blinking alert banner header file
+ *
+ *         Alerts are raised in a fixed number of slots, each with a priority
+ *         and a text. The highest priority alert is shown in a one page high
+ *         banner, which blinks by XOR-ing an inverted text image onto the
+ *         LCD. XOR-ing it a second time restores whatever is below, so only
+ *         the banner bytes are ever written and nothing needs redrawing.
+ *
+ *         Anything drawn below a visible banner would be spoiled by the next
+ *         XOR, so drawing in the banner area must be wrapped in
+ *         ALERT_Suspend and ALERT_Resume.
+ *
+ *         Alerts can also beep and flash the backlight in step with the
+ *         banner.
+ *
+ *****************************************************************************/
+#ifndef ALERT_LIB_H
+#define ALERT_LIB_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <cal.h>
+#include <rtc_driver.h>
+
+
+
+/************************
+ * Constants and defines
+ ************************/
+
+#define ALERT_SLOT_COUNT 4  //!< Number of alert slots.
+#define ALERT_BLINK_PERIOD (RTC_TICKS_PER_SECOND / 2)  //!< Ticks between banner toggles.
+#define ALERT_BEEP_COUNT 3  //!< Number of blinks that beep for alerts with ALERT_FLAG_SOUND.
+
+#define ALERT_FLAG_SOUND     (1<<0)  //!< Beep on the first ALERT_BEEP_COUNT blinks.
+#define ALERT_FLAG_BACKLIGHT (1<<1)  //!< Dim backlight while banner is off.
+
+
+
+/**********************
+ * Function prototypes
+ **********************/
+
+//! Set banner area and start blink timer. No alerts are active afterwards.
+void ALERT_Init( uint8_t page, uint8_t column, uint8_t width );
+//! Raise an alert in a slot, replacing any alert there. Priority 0 clears the slot.
+void ALERT_Raise( uint8_t slot, uint8_t priority, uint8_t flags, char const CAL_PGM(* text) );
+//! Clear the alert in a slot.
+void ALERT_Clear( uint8_t slot );
+//! Return true if a slot holds an alert.
+bool ALERT_IsActive( uint8_t slot );
+//! Toggle banner when due and show the highest priority alert. Call from main loop.
+void ALERT_Task( void );
+//! Remove banner from LCD before drawing below it. Calls may be nested.
+void ALERT_Suspend( void );
+//! Put banner back after drawing below it.
+void ALERT_Resume( void );
+
+
+#endif
+// end of file
@@ -0,0 +1,274 @@
+// This file has been prepared for Doxygen automatic documentation generation.
+/*! \file *********************************************************************
+ *
+ * \brief  Incremental bar graph widget source file
+ *
+ *         See bar_lib.h for a description of the widget. Positions along
+ *         the value axis are counted from the zero end of the bar, i.e.
+ *         from the left for horizontal bars and from the bottom for
+ *         vertical bars.
+ *
+ *****************************************************************************/
+
+#include "bar_lib.h"
+#include "lcd_lib.h"
+
+
+
+/*******************************
+ * Internal function prototypes
+ *******************************/
+
+//! Convert a value into number of filled pixels.
+static uint8_t BAR_ValueToPixels( BAR_bar_t const * bar, uint16_t value );
+//! Set or clear the box covering positions first..last, inclusive, across full thickness.
+static void BAR_PaintBox( BAR_bar_t const * bar, uint8_t first, uint8_t last, bool set );
+//! Check if a position is the gap pixel of a segment.
+static bool BAR_IsGap( BAR_bar_t const * bar, uint8_t pos );
+//! Set positions from..to-1, leaving segment gaps clear.
+static void BAR_FillSpan( BAR_bar_t const * bar, uint8_t from, uint8_t to );
+
+
+
+/***************************
+ * Function implementations
+ ***************************/
+
+/*!
+ * \param  bar        Bar state to initialize
+ * \param  x          Leftmost column of bar, including frame if any
+ * \param  y          Top row of bar, including frame if any
+ * \param  length     Size along the value axis in pixels, including frame if any
+ * \param  thickness  Size across the value axis in pixels, including frame if any
+ * \param  style      Combination of BAR_STYLE_* flags
+ * \param  maxValue   Value that gives a full bar
+ */
+void BAR_Init( BAR_bar_t * bar, uint8_t x, uint8_t y, uint8_t length, uint8_t thickness, uint8_t style, uint16_t maxValue )
+{
+	if ((style & BAR_STYLE_FRAME) != 0x00) {
+		x += BAR_FRAME_INSET;
+		y += BAR_FRAME_INSET;
+		length -= 2 * BAR_FRAME_INSET;
+		thickness -= 2 * BAR_FRAME_INSET;
+	}
+
+	bar->x = x;
+	bar->y = y;
+	bar->length = length;
+	bar->thickness = thickness;
+	bar->style = style;
+	bar->segmentWidth = 0;
+	bar->value = 0;
+	bar->drawnFill = 0;
+	bar->drawnPeak = 0;
+	bar->peakFill = 0;
+	bar->peakHold = 0;
+	bar->peakHoldTime = 0;
+	BAR_SetMaxValue( bar, maxValue );
+}
+
+
+void BAR_SetSegments( BAR_bar_t * bar, uint8_t segmentWidth )
+{
+	// A segment needs at least one lit pixel besides the gap.
+	bar->segmentWidth = (segmentWidth < 2) ? 0 : segmentWidth;
+}
+
+
+void BAR_SetPeakHold( BAR_bar_t * bar, uint8_t holdUpdates )
+{
+	bar->peakHoldTime = holdUpdates;
+	bar->peakHold = holdUpdates;
+}
+
+
+/*!
+ *  This is the only place a division is done. The factor is rounded up so
+ *  that maxValue always maps to a completely filled bar.
+ */
+void BAR_SetMaxValue( BAR_bar_t * bar, uint16_t maxValue )
+{
+	if (maxValue == 0) {
+		maxValue = 1;
+	}
+	bar->maxValue = maxValue;
+	bar->scale = (((uint32_t) bar->length << 16) + maxValue - 1) / maxValue;
+}
+
+
+void BAR_ResetPeak( BAR_bar_t * bar )
+{
+	bar->peakFill = 0;
+	bar->peakHold = 0;
+}
+
+
+/*!
+ *  The frame is drawn with line functions, the fill area is cleared with one
+ *  box operation and the bar is then drawn from scratch with BAR_Update.
+ */
+void BAR_Draw( BAR_bar_t * bar )
+{
+	uint8_t width, height;
+	if ((bar->style & BAR_STYLE_VERTICAL) != 0x00) {
+		width = bar->thickness;
+		height = bar->length;
+	} else {
+		width = bar->length;
+		height = bar->thickness;
+	}
+
+	if ((bar->style & BAR_STYLE_FRAME) != 0x00) {
+		uint8_t const x1 = bar->x - BAR_FRAME_INSET;
+		uint8_t const y1 = bar->y - BAR_FRAME_INSET;
+		uint8_t const x2 = bar->x + width + BAR_FRAME_INSET - 1;
+		uint8_t const y2 = bar->y + height + BAR_FRAME_INSET - 1;
+		LCD_SetHLine( x1, x2, y1 );
+		LCD_SetHLine( x1, x2, y2 );
+		LCD_SetVLine( x1, y1, y2 );
+		LCD_SetVLine( x2, y1, y2 );
+	}
+
+	LCD_ClrBox( bar->x, bar->y, bar->x + width - 1, bar->y + height - 1 );
+	bar->drawnFill = 0;
+	bar->drawnPeak = 0;
+	BAR_Update( bar, bar->value );
+}
+
+
+/*!
+ *  Only the pixels between the previously drawn and the new fill level are
+ *  touched, plus the old and new peak marker lines if they moved. Calling
+ *  this with an unchanged value and no peak movement writes nothing.
+ *
+ *  When peak hold is enabled, the peak follows the fill upwards immediately.
+ *  After peakHoldTime updates without a new peak it falls one pixel per
+ *  update until it meets the fill level.
+ */
+void BAR_Update( BAR_bar_t * bar, uint16_t value )
+{
+	bar->value = value;
+	uint8_t const oldFill = bar->drawnFill;
+	uint8_t const newFill = BAR_ValueToPixels( bar, value );
+
+	// Update held peak.
+	uint8_t newPeak = 0;
+	if (bar->peakHoldTime != 0) {
+		if (newFill >= bar->peakFill) {
+			bar->peakFill = newFill;
+			bar->peakHold = bar->peakHoldTime;
+		} else if (bar->peakHold > 0) {
+			--bar->peakHold;
+		} else {
+			--bar->peakFill;
+		}
+
+		// Marker is only visible above the fill, stored as position plus one.
+		if (bar->peakFill > newFill) {
+			newPeak = bar->peakFill;
+		}
+	}
+	uint8_t const oldPeak = bar->drawnPeak;
+
+	// Remove old marker unless it stays put or will be covered by a lit fill pixel.
+	if ((oldPeak != 0) && (oldPeak != newPeak)
+	    && (((oldPeak - 1) >= newFill) || BAR_IsGap( bar, oldPeak - 1 ))) {
+		BAR_PaintBox( bar, oldPeak - 1, oldPeak - 1, false );
+	}
+
+	// Grow or shrink the fill.
+	if (newFill > oldFill) {
+		BAR_FillSpan( bar, oldFill, newFill );
+	} else if (newFill < oldFill) {
+		BAR_PaintBox( bar, newFill, oldFill - 1, false );
+	}
+
+	// Draw new marker if it moved or was just erased by a shrinking fill.
+	if ((newPeak != 0) && ((newPeak != oldPeak) || ((newPeak - 1) < oldFill))) {
+		BAR_PaintBox( bar, newPeak - 1, newPeak - 1, true );
+	}
+
+	bar->drawnFill = newFill;
+	bar->drawnPeak = newPeak;
+}
+
+
+void BAR_SetValue( BAR_bar_t * bar, uint16_t value )
+{
+	bar->value = value;
+}
+
+
+static uint8_t BAR_ValueToPixels( BAR_bar_t const * bar, uint16_t value )
+{
+	if (value > bar->maxValue) {
+		value = bar->maxValue;
+	}
+
+	// value <= maxValue, so the product never exceeds length << 16.
+	uint8_t pixels = ((uint32_t) value * bar->scale) >> 16;
+	if (pixels > bar->length) {
+		pixels = bar->length;
+	}
+	return pixels;
+}
+
+
+static void BAR_PaintBox( BAR_bar_t const * bar, uint8_t first, uint8_t last, bool set )
+{
+	uint8_t x1, y1, x2, y2;
+	if ((bar->style & BAR_STYLE_VERTICAL) != 0x00) {
+		uint8_t const bottom = bar->y + bar->length - 1;
+		x1 = bar->x;
+		x2 = bar->x + bar->thickness - 1;
+		y1 = bottom - last;
+		y2 = bottom - first;
+	} else {
+		x1 = bar->x + first;
+		x2 = bar->x + last;
+		y1 = bar->y;
+		y2 = bar->y + bar->thickness - 1;
+	}
+
+	if (set) {
+		LCD_SetBox( x1, y1, x2, y2 );
+	} else {
+		LCD_ClrBox( x1, y1, x2, y2 );
+	}
+}
+
+
+static bool BAR_IsGap( BAR_bar_t const * bar, uint8_t pos )
+{
+	return (bar->segmentWidth != 0) && ((pos % bar->segmentWidth) == (bar->segmentWidth - 1));
+}
+
+
+static void BAR_FillSpan( BAR_bar_t const * bar, uint8_t from, uint8_t to )
+{
+	uint8_t const segmentWidth = bar->segmentWidth;
+	if (segmentWidth == 0) {
+		BAR_PaintBox( bar, from, to - 1, true );
+		return;
+	}
+
+	// Walk segment by segment, skipping the last pixel of each segment.
+	uint8_t offset = from % segmentWidth;
+	while (from < to) {
+		if (offset == (segmentWidth - 1)) {
+			++from;
+			offset = 0;
+		} else {
+			uint8_t end = from + (segmentWidth - 1 - offset);
+			if (end > to) {
+				end = to;
+			}
+			BAR_PaintBox( bar, from, end - 1, true );
+			offset += end - from;
+			from = end;
+		}
+	}
+}
+
+
+// end of file
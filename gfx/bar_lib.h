@@ -0,0 +1,85 @@
+// This file has been prepared for Doxygen automatic documentation generation.
+/*! \file *********************************************************************
+ *
+ * \brief  Incremental bar graph widget header file
+ *
+ *         A bar remembers how many pixels it has drawn and where its peak
+ *         marker is, so that an update only touches the columns (or rows)
+ *         between the old and the new value. All drawing is done with the
+ *         page-masked box functions of lcd_lib, so full pages are written
+ *         directly and only the partial top/bottom pages need read-back.
+ *
+ *         Values are scaled to pixels with a 16.16 fixed-point factor that
+ *         is computed once in BAR_Init, so BAR_Update is free of divisions.
+ *
+ *****************************************************************************/
+#ifndef BAR_LIB_H
+#define BAR_LIB_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+
+
+/************************
+ * Constants and defines
+ ************************/
+
+#define BAR_STYLE_HORIZONTAL 0x00    //!< Bar grows from left to right.
+#define BAR_STYLE_VERTICAL   (1<<0)  //!< Bar grows from bottom to top.
+#define BAR_STYLE_FRAME      (1<<1)  //!< Draw a frame with one pixel spacing around the fill area.
+
+#define BAR_FRAME_INSET 2  //!< Distance from frame to fill area, frame line included.
+
+
+
+/*********************
+ * Types and typedefs
+ *********************/
+
+//! State of one bar graph. Initialize with BAR_Init, do not modify directly.
+typedef struct BAR_bar_struct
+{
+	uint8_t x;  //!< Leftmost column of fill area.
+	uint8_t y;  //!< Top row of fill area.
+	uint8_t length;  //!< Fill area size along the value axis, in pixels.
+	uint8_t thickness;  //!< Fill area size across the value axis, in pixels.
+	uint8_t style;  //!< Combination of BAR_STYLE_* flags.
+	uint8_t segmentWidth;  //!< Pixels per segment including a one pixel gap. 0 for solid bar.
+	uint16_t maxValue;  //!< Value giving a full bar.
+	uint16_t value;  //!< Last value given to BAR_Update.
+	uint32_t scale;  //!< Pixels per value unit, 16.16 fixed point.
+
+	uint8_t drawnFill;  //!< Number of pixels currently filled on LCD.
+	uint8_t drawnPeak;  //!< Position of peak marker on LCD plus one, 0 if none.
+	uint8_t peakFill;  //!< Held peak, in pixels.
+	uint8_t peakHold;  //!< Updates left before held peak starts to fall.
+	uint8_t peakHoldTime;  //!< Updates to hold peak. 0 disables the peak marker.
+} BAR_bar_t;
+
+
+
+/**********************
+ * Function prototypes
+ **********************/
+
+//! Initialize bar state. Does not draw anything.
+void BAR_Init( BAR_bar_t * bar, uint8_t x, uint8_t y, uint8_t length, uint8_t thickness, uint8_t style, uint16_t maxValue );
+//! Split bar into segments of given width, gap included. 0 gives a solid bar.
+void BAR_SetSegments( BAR_bar_t * bar, uint8_t segmentWidth );
+//! Enable peak-hold marker, holding peak for given number of updates. 0 disables.
+void BAR_SetPeakHold( BAR_bar_t * bar, uint8_t holdUpdates );
+//! Change full-scale value. Takes effect on next update.
+void BAR_SetMaxValue( BAR_bar_t * bar, uint16_t maxValue );
+//! Drop held peak to current value on next update.
+void BAR_ResetPeak( BAR_bar_t * bar );
+//! Draw frame and complete bar, e.g. after screen has been cleared.
+void BAR_Draw( BAR_bar_t * bar );
+//! Set new value and redraw only the changed part of the bar.
+void BAR_Update( BAR_bar_t * bar, uint16_t value );
+//! Set new value without drawing, e.g. while bar is not on screen. Shown on next BAR_Draw.
+void BAR_SetValue( BAR_bar_t * bar, uint16_t value );
+
+
+#endif
+// end of file
@@ -0,0 +1,287 @@
+// This file has been prepared for Doxygen automatic documentation generation.
+/*! \file *********************************************************************
+ *
+ * \brief  Scrolling trend chart widget source file
+ *
+ *         See chart_lib.h for a description of the widget. One pixel column
+ *         of the chart is handled as a 32-bit word where bit n is pixel row
+ *         n counted from the top, which matches the bit order of the LCD
+ *         pages, so byte n of the word is the byte for page n of the chart.
+ *         Value rows are counted from the bottom.
+ *
+ *****************************************************************************/
+
+#include "chart_lib.h"
+#include <lcd_lib.h>
+#include <string.h>
+
+
+
+/*******************************
+ * Internal function prototypes
+ *******************************/
+
+//! Convert a value into a pixel row counted from the bottom, clamped to the chart.
+static uint8_t CHART_ValueToRow( CHART_chart_t const * chart, int16_t value );
+//! Get pixel column word for a min/max pair.
+static uint32_t CHART_ColumnBits( CHART_chart_t const * chart, CHART_column_t const * column );
+//! Read pixel column word from page buffer.
+static uint32_t CHART_GetBufferColumn( CHART_chart_t const * chart, uint8_t x );
+//! Write pixel column word to page buffer.
+static void CHART_SetBufferColumn( CHART_chart_t * chart, uint8_t x, uint32_t bits );
+//! Double the range and squeeze rendered columns into the lower or upper half.
+static void CHART_Squeeze( CHART_chart_t * chart, bool upperHalf );
+//! Render all columns in the ring into the page buffer.
+static void CHART_Render( CHART_chart_t * chart );
+
+
+
+/***************************
+ * Function implementations
+ ***************************/
+
+/*!
+ * \param  chart             Chart state to initialize
+ * \param  column            Leftmost LCD column of chart
+ * \param  page              Top LCD page of chart
+ * \param  width             Chart width in pixel columns
+ * \param  pageCount         Chart height in LCD pages, max CHART_MAX_PAGES
+ * \param  columns           Column ring buffer with width entries
+ * \param  pageBuffer        Buffer of CHART_PAGEBUFFER_SIZE( width, pageCount ) bytes
+ * \param  samplesPerColumn  Number of samples decimated into one pixel column
+ */
+void CHART_Init( CHART_chart_t * chart, uint8_t column, uint8_t page, uint8_t width, uint8_t pageCount, CHART_column_t * columns, uint8_t * pageBuffer, uint8_t samplesPerColumn )
+{
+	if (pageCount > CHART_MAX_PAGES) {
+		pageCount = CHART_MAX_PAGES;
+	}
+	if (samplesPerColumn == 0) {
+		samplesPerColumn = 1;
+	}
+
+	chart->column = column;
+	chart->page = page;
+	chart->width = width;
+	chart->pageCount = pageCount;
+	chart->flags = CHART_FLAG_AUTOSCALE;
+	chart->samplesPerColumn = samplesPerColumn;
+	chart->columns = columns;
+	chart->pageBuffer = pageBuffer;
+	chart->base = 0;
+	chart->shift = 0;
+	CHART_Clear( chart );
+}
+
+
+/*!
+ *  The page buffer is rendered again from the column ring, so a manual
+ *  range change is exact. Call CHART_Draw to show the result.
+ *
+ * \param  chart  Chart to change
+ * \param  base   Value at bottom pixel row
+ * \param  shift  Log2 of value units per pixel row, max CHART_MAX_SHIFT
+ * \param  flags  Combination of CHART_FLAG_* flags
+ */
+void CHART_SetRange( CHART_chart_t * chart, int16_t base, uint8_t shift, uint8_t flags )
+{
+	if (shift > CHART_MAX_SHIFT) {
+		shift = CHART_MAX_SHIFT;
+	}
+
+	chart->base = base;
+	chart->shift = shift;
+	chart->flags = flags;
+	CHART_Render( chart );
+}
+
+
+void CHART_Clear( CHART_chart_t * chart )
+{
+	chart->sampleCount = 0;
+	chart->head = 0;
+	chart->used = 0;
+	memset( chart->pageBuffer, 0x00, CHART_PAGEBUFFER_SIZE( chart->width, chart->pageCount ) );
+}
+
+
+void CHART_Draw( CHART_chart_t * chart )
+{
+	uint8_t const * pPageBuffer = chart->pageBuffer;
+	for (uint8_t page = 0; page < chart->pageCount; ++page) {
+		LCD_WritePage( pPageBuffer, chart->page + page, chart->column, chart->width );
+		pPageBuffer += chart->width;
+	}
+}
+
+
+void CHART_AddSample( CHART_chart_t * chart, int16_t value )
+{
+	if (CHART_StoreSample( chart, value )) {
+		CHART_Draw( chart );
+	}
+}
+
+
+/*!
+ *  Samples are collected into a pending min/max pair. When samplesPerColumn
+ *  samples have been collected the pair is stored in the ring, the range is
+ *  widened if needed, the page buffer is scrolled one column and only the
+ *  new column is drawn into it. Nothing is written to the LCD, so a chart
+ *  that is not on screen keeps its history.
+ */
+bool CHART_StoreSample( CHART_chart_t * chart, int16_t value )
+{
+	// Collect min/max for pending column.
+	if (chart->sampleCount == 0) {
+		chart->pending.min = value;
+		chart->pending.max = value;
+	} else if (value < chart->pending.min) {
+		chart->pending.min = value;
+	} else if (value > chart->pending.max) {
+		chart->pending.max = value;
+	}
+
+	if (++chart->sampleCount < chart->samplesPerColumn) {
+		return false;
+	}
+	chart->sampleCount = 0;
+
+	// Store completed column in ring.
+	chart->columns[chart->head] = chart->pending;
+	if (++chart->head == chart->width) {
+		chart->head = 0;
+	}
+	if (chart->used < chart->width) {
+		++chart->used;
+	}
+
+	// Widen range until the new column fits.
+	if ((chart->flags & CHART_FLAG_AUTOSCALE) != 0x00) {
+		uint8_t const height = chart->pageCount * LCD_PAGE_HEIGHT;
+		while ((chart->shift < CHART_MAX_SHIFT)
+		       && (chart->pending.max >= (chart->base + ((int32_t) height << chart->shift)))) {
+			CHART_Squeeze( chart, false );
+		}
+		while ((chart->shift < CHART_MAX_SHIFT) && (chart->pending.min < chart->base)) {
+			CHART_Squeeze( chart, true );
+		}
+	}
+
+	// Scroll one column left and draw new column at the right end.
+	uint8_t * pPageBuffer = chart->pageBuffer;
+	for (uint8_t page = 0; page < chart->pageCount; ++page) {
+		memmove( pPageBuffer, pPageBuffer + 1, chart->width - 1 );
+		pPageBuffer += chart->width;
+	}
+	CHART_SetBufferColumn( chart, chart->width - 1, CHART_ColumnBits( chart, &chart->pending ) );
+
+	return true;
+}
+
+
+static uint8_t CHART_ValueToRow( CHART_chart_t const * chart, int16_t value )
+{
+	int32_t const offset = (int32_t) value - chart->base;
+	if (offset < 0) {
+		return 0;
+	}
+
+	uint8_t const height = chart->pageCount * LCD_PAGE_HEIGHT;
+	int32_t const row = offset >> chart->shift;
+	if (row >= height) {
+		return height - 1;
+	}
+	return row;
+}
+
+
+/*!
+ *  All rows between the min and the max sample are set, so a column shows
+ *  the spread of its samples as a vertical line.
+ */
+static uint32_t CHART_ColumnBits( CHART_chart_t const * chart, CHART_column_t const * column )
+{
+	uint8_t const lastRow = chart->pageCount * LCD_PAGE_HEIGHT - 1;
+	uint8_t const top = lastRow - CHART_ValueToRow( chart, column->max );
+	uint8_t const bottom = lastRow - CHART_ValueToRow( chart, column->min );
+
+	// Bits top..bottom inclusive. Shifting 2 instead of 1 avoids an undefined 32-bit shift.
+	return ((uint32_t) 2 << bottom) - ((uint32_t) 1 << top);
+}
+
+
+static uint32_t CHART_GetBufferColumn( CHART_chart_t const * chart, uint8_t x )
+{
+	uint32_t bits = 0;
+	uint8_t const * pPageBuffer = chart->pageBuffer + x + (chart->pageCount - 1) * chart->width;
+	for (uint8_t page = chart->pageCount; page != 0; --page) {
+		bits = (bits << 8) | *pPageBuffer;
+		pPageBuffer -= chart->width;
+	}
+	return bits;
+}
+
+
+static void CHART_SetBufferColumn( CHART_chart_t * chart, uint8_t x, uint32_t bits )
+{
+	uint8_t * pPageBuffer = chart->pageBuffer + x;
+	for (uint8_t page = 0; page < chart->pageCount; ++page) {
+		*pPageBuffer = bits;
+		bits >>= 8;
+		pPageBuffer += chart->width;
+	}
+}
+
+
+/*!
+ *  Doubling the range maps value row r to r/2 when the base is kept, or to
+ *  (r + height)/2 when the base is lowered by the old range. Every rendered
+ *  column is transformed that way in place, which is exactly what a full
+ *  re-plot would give for single-pixel columns and very close to it for
+ *  min/max spans.
+ *
+ * \param  chart      Chart to rescale
+ * \param  upperHalf  If true, lower the base and move old columns to the upper half
+ */
+static void CHART_Squeeze( CHART_chart_t * chart, bool upperHalf )
+{
+	uint8_t const height = chart->pageCount * LCD_PAGE_HEIGHT;
+	if (upperHalf) {
+		chart->base -= (int32_t) height << chart->shift;
+	}
+	++chart->shift;
+
+	for (uint8_t x = 0; x < chart->width; ++x) {
+		uint32_t oldBits = CHART_GetBufferColumn( chart, x );
+		uint32_t newBits = 0;
+		uint8_t top = 0;
+		while (oldBits != 0) {
+			if ((oldBits & 0x01) != 0x00) {
+				uint8_t row = height - 1 - top;
+				row = upperHalf ? ((row + height) >> 1) : (row >> 1);
+				newBits |= (uint32_t) 1 << (height - 1 - row);
+			}
+			oldBits >>= 1;
+			++top;
+		}
+		CHART_SetBufferColumn( chart, x, newBits );
+	}
+}
+
+
+static void CHART_Render( CHART_chart_t * chart )
+{
+	memset( chart->pageBuffer, 0x00, CHART_PAGEBUFFER_SIZE( chart->width, chart->pageCount ) );
+
+	// Newest column is right before head in the ring and goes to the right end.
+	uint8_t index = chart->head;
+	uint8_t x = chart->width;
+	for (uint8_t count = chart->used; count != 0; --count) {
+		index = (index == 0) ? (chart->width - 1) : (index - 1);
+		--x;
+		CHART_SetBufferColumn( chart, x, CHART_ColumnBits( chart, &chart->columns[index] ) );
+	}
+}
+
+
+// end of file
@@ -0,0 +1,98 @@
+// This file has been prepared for Doxygen automatic documentation generation.
+/*! \file *********************************************************************
+ *
+ * \brief  Scrolling trend chart widget header file
+ *
+ *         A chart shows the history of one signal as a strip of pixel
+ *         columns, newest to the right. Samples are decimated into one
+ *         min/max pair per column, kept in a ring buffer with one entry
+ *         per column. The rendered chart is kept in an SRAM page buffer,
+ *         so when a column is completed the buffer is shifted one column
+ *         left, only the new column is drawn into it, and the chart area
+ *         is written to the LCD with one page write per page.
+ *
+ *         The vertical range is base .. base + (height << shift) - 1. With
+ *         autoscale enabled the range is doubled whenever a value falls
+ *         outside it, and the already rendered columns are squeezed into
+ *         the new range directly in the page buffer, so nothing needs to
+ *         be re-plotted from the samples.
+ *
+ *****************************************************************************/
+#ifndef CHART_LIB_H
+#define CHART_LIB_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+
+
+/************************
+ * Constants and defines
+ ************************/
+
+#define CHART_MAX_PAGES 4  //!< Maximum chart height in LCD pages.
+#define CHART_MAX_SHIFT 16  //!< Largest scale shift, range then covers any 16-bit value.
+
+#define CHART_FLAG_AUTOSCALE (1<<0)  //!< Double the range when a value falls outside it.
+
+//! Size in bytes of the page buffer needed for a chart.
+#define CHART_PAGEBUFFER_SIZE(width, pageCount) ((width) * (pageCount))
+
+
+
+/*********************
+ * Types and typedefs
+ *********************/
+
+//! Smallest and largest sample within one pixel column.
+typedef struct CHART_column_struct
+{
+	int16_t min;  //!< Smallest sample.
+	int16_t max;  //!< Largest sample.
+} CHART_column_t;
+
+//! State of one chart. Initialize with CHART_Init, do not modify directly.
+typedef struct CHART_chart_struct
+{
+	uint8_t column;  //!< Leftmost LCD column of chart.
+	uint8_t page;  //!< Top LCD page of chart.
+	uint8_t width;  //!< Number of pixel columns, also number of entries in column ring.
+	uint8_t pageCount;  //!< Chart height in LCD pages, max CHART_MAX_PAGES.
+	uint8_t flags;  //!< Combination of CHART_FLAG_* flags.
+
+	uint8_t samplesPerColumn;  //!< Samples decimated into one pixel column.
+	uint8_t sampleCount;  //!< Samples collected into pending column so far.
+	CHART_column_t pending;  //!< Column being collected.
+
+	CHART_column_t * columns;  //!< Ring buffer of completed columns, width entries.
+	uint8_t head;  //!< Ring index where next completed column is stored.
+	uint8_t used;  //!< Number of valid columns in ring.
+
+	int32_t base;  //!< Value at bottom pixel row, may go below int16_t range when autoscaling.
+	uint8_t shift;  //!< Log2 of value units per pixel row.
+
+	uint8_t * pageBuffer;  //!< Rendered chart, pageCount rows of width bytes, top page first.
+} CHART_chart_t;
+
+
+
+/**********************
+ * Function prototypes
+ **********************/
+
+//! Initialize chart state with an empty history and autoscale from zero. Does not draw anything.
+void CHART_Init( CHART_chart_t * chart, uint8_t column, uint8_t page, uint8_t width, uint8_t pageCount, CHART_column_t * columns, uint8_t * pageBuffer, uint8_t samplesPerColumn );
+//! Set vertical range and autoscale flags, then render chart again into page buffer.
+void CHART_SetRange( CHART_chart_t * chart, int16_t base, uint8_t shift, uint8_t flags );
+//! Forget history and clear page buffer.
+void CHART_Clear( CHART_chart_t * chart );
+//! Write page buffer to LCD, e.g. after screen has been cleared.
+void CHART_Draw( CHART_chart_t * chart );
+//! Add one sample. Scrolls and redraws the chart when a column is completed.
+void CHART_AddSample( CHART_chart_t * chart, int16_t value );
+//! Add one sample to history and page buffer without drawing. Returns true if page buffer changed.
+bool CHART_StoreSample( CHART_chart_t * chart, int16_t value );
+
+
+#endif
+// end of file
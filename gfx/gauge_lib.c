@@ -0,0 +1,383 @@
+// This file has been prepared for Doxygen automatic documentation generation.
+/*! \file *********************************************************************
+ *
+ * \brief  Arc gauge widget source file
+ *
+ *         See gauge_lib.h for a description of the widget. All drawing is
+ *         done into the page buffer with coordinates relative to the gauge
+ *         area. Pixels outside the area are silently dropped.
+ *
+ *****************************************************************************/
+
+#include "gauge_lib.h"
+#include <lcd_lib.h>
+#include <cal.h>
+#include <string.h>
+
+
+
+/************************
+ * Constants and defines
+ ************************/
+
+#define GAUGE_ARC_STEP 4  //!< Binary angle between arc points, joined by straight lines.
+#define GAUGE_PIVOT_SIZE 1  //!< Pivot box extends this many pixels around center.
+#define GAUGE_NEEDLE_GAP 1  //!< Pixels between needle tip and inner end of ticks.
+
+
+
+/*************************
+ * Private lookup tables
+ *************************/
+
+/*!
+ *  Quarter-wave sine table, round( 255 * sin( i * 2 * pi / 256 ) ) for
+ *  i = 0..64. The other quadrants are found by symmetry.
+ */
+static uint8_t const CAL_PGM_DEF(GAUGE_sinTable[GAUGE_ANGLE_QUARTER + 1]) = {
+	  0,   6,  13,  19,  25,  31,  37,  44,
+	 50,  56,  62,  68,  74,  80,  86,  92,
+	 98, 103, 109, 115, 120, 126, 131, 136,
+	142, 147, 152, 157, 162, 167, 171, 176,
+	180, 185, 189, 193, 197, 201, 205, 208,
+	212, 215, 219, 222, 225, 228, 231, 233,
+	236, 238, 240, 242, 244, 246, 247, 249,
+	250, 251, 252, 253, 254, 254, 255, 255,
+	255
+};
+
+
+
+/*******************************
+ * Internal function prototypes
+ *******************************/
+
+//! Convert a value into needle angle.
+static uint8_t GAUGE_ValueToAngle( GAUGE_gauge_t const * gauge, uint16_t value );
+//! Find point at given angle and distance from pivot.
+static void GAUGE_Point( GAUGE_gauge_t const * gauge, uint8_t angle, uint8_t distance, int16_t * x, int16_t * y );
+//! Set or flip one pixel in page buffer, ignoring pixels outside gauge area.
+static void GAUGE_PlotPixel( GAUGE_gauge_t * gauge, int16_t x, int16_t y, bool flip );
+//! Set or flip a line in page buffer, each pixel exactly once.
+static void GAUGE_PlotLine( GAUGE_gauge_t * gauge, int16_t x1, int16_t y1, int16_t x2, int16_t y2, bool flip );
+//! Flip needle at given angle and grow dirty rectangle to cover it.
+static void GAUGE_FlipNeedle( GAUGE_gauge_t * gauge, uint8_t angle, int16_t * dirty );
+//! Write part of page buffer covering given rectangle to LCD.
+static void GAUGE_WriteArea( GAUGE_gauge_t const * gauge, int16_t const * dirty );
+
+
+
+/***************************
+ * Function implementations
+ ***************************/
+
+/*!
+ * \param  gauge       Gauge state to initialize
+ * \param  column      Leftmost LCD column of gauge area
+ * \param  page        Top LCD page of gauge area
+ * \param  width       Gauge area width in pixels
+ * \param  pageCount   Gauge area height in LCD pages
+ * \param  pageBuffer  Buffer of GAUGE_PAGEBUFFER_SIZE( width, pageCount ) bytes
+ * \param  centerX     Needle pivot, relative to gauge area
+ * \param  centerY     Needle pivot, relative to gauge area
+ * \param  radius      Distance from pivot to outer end of ticks and arc
+ * \param  style       Combination of GAUGE_STYLE_* flags
+ * \param  maxValue    Full-scale value
+ */
+void GAUGE_Init( GAUGE_gauge_t * gauge, uint8_t column, uint8_t page, uint8_t width, uint8_t pageCount, uint8_t * pageBuffer, uint8_t centerX, uint8_t centerY, uint8_t radius, uint8_t style, uint16_t maxValue )
+{
+	gauge->column = column;
+	gauge->page = page;
+	gauge->width = width;
+	gauge->pageCount = pageCount;
+	gauge->pageBuffer = pageBuffer;
+	gauge->centerX = centerX;
+	gauge->centerY = centerY;
+	gauge->radius = radius;
+	gauge->style = style;
+	gauge->tickCount = 0;
+	gauge->tickLength = 0;
+	gauge->value = 0;
+	gauge->needleAngle = 0;
+	gauge->needleDrawn = false;
+	gauge->maxValue = 1;
+	GAUGE_SetAngles( gauge, GAUGE_DEFAULT_START, GAUGE_DEFAULT_SWEEP );
+	GAUGE_SetMaxValue( gauge, maxValue );
+}
+
+
+/*!
+ *  Takes effect on next GAUGE_Draw.
+ */
+void GAUGE_SetAngles( GAUGE_gauge_t * gauge, uint8_t startAngle, uint8_t sweep )
+{
+	gauge->startAngle = startAngle;
+	gauge->sweep = sweep;
+	GAUGE_SetMaxValue( gauge, gauge->maxValue );
+}
+
+
+/*!
+ *  Takes effect on next GAUGE_Draw.
+ */
+void GAUGE_SetTicks( GAUGE_gauge_t * gauge, uint8_t tickCount, uint8_t tickLength )
+{
+	gauge->tickCount = tickCount;
+	gauge->tickLength = tickLength;
+}
+
+
+/*!
+ *  This is where the division is done, so that updates only multiply.
+ */
+void GAUGE_SetMaxValue( GAUGE_gauge_t * gauge, uint16_t maxValue )
+{
+	if (maxValue == 0) {
+		maxValue = 1;
+	}
+	gauge->maxValue = maxValue;
+	gauge->scale = ((uint32_t) gauge->sweep << 16) / maxValue;
+}
+
+
+/*!
+ *  The dial is rendered from scratch, so this is the place to pay for the
+ *  arc and tick lines. The needle is then XOR-ed on top.
+ */
+void GAUGE_Draw( GAUGE_gauge_t * gauge )
+{
+	memset( gauge->pageBuffer, 0x00, GAUGE_PAGEBUFFER_SIZE( gauge->width, gauge->pageCount ) );
+
+	// Arc, as short straight lines between points on the circle.
+	if ((gauge->style & GAUGE_STYLE_ARC) != 0x00) {
+		int16_t x1, y1, x2, y2;
+		GAUGE_Point( gauge, gauge->startAngle, gauge->radius, &x1, &y1 );
+		uint16_t offset = 0;
+		do {
+			offset += GAUGE_ARC_STEP;
+			if (offset > gauge->sweep) {
+				offset = gauge->sweep;
+			}
+			GAUGE_Point( gauge, gauge->startAngle + offset, gauge->radius, &x2, &y2 );
+			GAUGE_PlotLine( gauge, x1, y1, x2, y2, false );
+			x1 = x2;
+			y1 = y2;
+		} while (offset < gauge->sweep);
+	}
+
+	// Ticks, evenly spread from start to end of sweep.
+	for (uint8_t tick = 0; tick < gauge->tickCount; ++tick) {
+		uint8_t angle = gauge->startAngle;
+		if (gauge->tickCount > 1) {
+			angle += ((uint16_t) gauge->sweep * tick) / (gauge->tickCount - 1);
+		}
+		int16_t x1, y1, x2, y2;
+		GAUGE_Point( gauge, angle, gauge->radius - gauge->tickLength + 1, &x1, &y1 );
+		GAUGE_Point( gauge, angle, gauge->radius, &x2, &y2 );
+		GAUGE_PlotLine( gauge, x1, y1, x2, y2, false );
+	}
+
+	// Pivot box.
+	if ((gauge->style & GAUGE_STYLE_PIVOT) != 0x00) {
+		for (int8_t dy = -GAUGE_PIVOT_SIZE; dy <= GAUGE_PIVOT_SIZE; ++dy) {
+			for (int8_t dx = -GAUGE_PIVOT_SIZE; dx <= GAUGE_PIVOT_SIZE; ++dx) {
+				GAUGE_PlotPixel( gauge, gauge->centerX + dx, gauge->centerY + dy, false );
+			}
+		}
+	}
+
+	// Needle, then write everything.
+	int16_t dirty[4] = { INT16_MAX, INT16_MAX, INT16_MIN, INT16_MIN };
+	gauge->needleAngle = GAUGE_ValueToAngle( gauge, gauge->value );
+	gauge->needleDrawn = true;
+	GAUGE_FlipNeedle( gauge, gauge->needleAngle, dirty );
+
+	dirty[0] = 0;
+	dirty[1] = 0;
+	dirty[2] = gauge->width - 1;
+	dirty[3] = gauge->pageCount * LCD_PAGE_HEIGHT - 1;
+	GAUGE_WriteArea( gauge, dirty );
+}
+
+
+/*!
+ *  The old needle is removed by flipping its pixels again, then the new
+ *  needle is flipped in. Only the rectangle covering both needles is
+ *  written to the LCD. Nothing is written if the needle angle is unchanged.
+ */
+void GAUGE_Update( GAUGE_gauge_t * gauge, uint16_t value )
+{
+	gauge->value = value;
+	uint8_t const angle = GAUGE_ValueToAngle( gauge, value );
+	if (gauge->needleDrawn && (angle == gauge->needleAngle)) {
+		return;
+	}
+
+	// Dirty rectangle as left, top, right, bottom, starting out empty.
+	int16_t dirty[4] = { INT16_MAX, INT16_MAX, INT16_MIN, INT16_MIN };
+	if (gauge->needleDrawn) {
+		GAUGE_FlipNeedle( gauge, gauge->needleAngle, dirty );
+	}
+	GAUGE_FlipNeedle( gauge, angle, dirty );
+	gauge->needleAngle = angle;
+	gauge->needleDrawn = true;
+
+	GAUGE_WriteArea( gauge, dirty );
+}
+
+
+int16_t GAUGE_Sin( uint8_t angle )
+{
+	uint8_t const index = angle & (GAUGE_ANGLE_QUARTER - 1);
+	int16_t value;
+	if ((angle & GAUGE_ANGLE_QUARTER) == 0x00) {
+		value = CAL_pgm_read_byte( &GAUGE_sinTable[index] );
+	} else {
+		value = CAL_pgm_read_byte( &GAUGE_sinTable[GAUGE_ANGLE_QUARTER - index] );
+	}
+
+	// Second half turn is negative.
+	if ((angle & (2 * GAUGE_ANGLE_QUARTER)) != 0x00) {
+		value = -value;
+	}
+	return value;
+}
+
+
+int16_t GAUGE_Cos( uint8_t angle )
+{
+	return GAUGE_Sin( angle + GAUGE_ANGLE_QUARTER );
+}
+
+
+void GAUGE_SetValue( GAUGE_gauge_t * gauge, uint16_t value )
+{
+	gauge->value = value;
+}
+
+
+static uint8_t GAUGE_ValueToAngle( GAUGE_gauge_t const * gauge, uint16_t value )
+{
+	if (value > gauge->maxValue) {
+		value = gauge->maxValue;
+	}
+	return gauge->startAngle + (uint8_t) (((uint32_t) value * gauge->scale) >> 16);
+}
+
+
+/*!
+ *  Distance must be 127 or less, so that distance times GAUGE_TRIG_ONE
+ *  fits in 16-bit arithmetic.
+ */
+static void GAUGE_Point( GAUGE_gauge_t const * gauge, uint8_t angle, uint8_t distance, int16_t * x, int16_t * y )
+{
+	// Add half before shifting to round to nearest pixel.
+	*x = gauge->centerX + ((distance * GAUGE_Sin( angle ) + 128) >> 8);
+	*y = gauge->centerY - ((distance * GAUGE_Cos( angle ) + 128) >> 8);
+}
+
+
+static void GAUGE_PlotPixel( GAUGE_gauge_t * gauge, int16_t x, int16_t y, bool flip )
+{
+	if ((x < 0) || (y < 0) || (x >= gauge->width) || (y >= (gauge->pageCount * LCD_PAGE_HEIGHT))) {
+		return;
+	}
+
+	uint8_t * pByte = gauge->pageBuffer + (y / LCD_PAGE_HEIGHT) * gauge->width + x;
+	uint8_t const mask = 1 << (y % LCD_PAGE_HEIGHT);
+	if (flip) {
+		*pByte ^= mask;
+	} else {
+		*pByte |= mask;
+	}
+}
+
+
+/*!
+ *  Bresenham line. Every pixel is visited exactly once, which is required
+ *  for flipping a line twice to restore what was underneath.
+ */
+static void GAUGE_PlotLine( GAUGE_gauge_t * gauge, int16_t x1, int16_t y1, int16_t x2, int16_t y2, bool flip )
+{
+	int16_t dx = x2 - x1;
+	int16_t dy = y2 - y1;
+	int8_t const xinc = (dx < 0) ? -1 : 1;
+	int8_t const yinc = (dy < 0) ? -1 : 1;
+	if (dx < 0) { dx = -dx; }
+	if (dy < 0) { dy = -dy; }
+
+	int16_t error = dx - dy;
+	for (;;) {
+		GAUGE_PlotPixel( gauge, x1, y1, flip );
+		if ((x1 == x2) && (y1 == y2)) {
+			break;
+		}
+		int16_t const error2 = 2 * error;
+		if (error2 > -dy) {
+			error -= dy;
+			x1 += xinc;
+		}
+		if (error2 < dx) {
+			error += dx;
+			y1 += yinc;
+		}
+	}
+}
+
+
+static void GAUGE_FlipNeedle( GAUGE_gauge_t * gauge, uint8_t angle, int16_t * dirty )
+{
+	// Needle starts outside the pivot box and stops short of the ticks.
+	uint8_t inner = 0;
+	if ((gauge->style & GAUGE_STYLE_PIVOT) != 0x00) {
+		inner = GAUGE_PIVOT_SIZE + 1;
+	}
+	uint8_t outer = gauge->radius;
+	if (gauge->tickCount != 0) {
+		outer -= gauge->tickLength + GAUGE_NEEDLE_GAP;
+	}
+
+	int16_t x1, y1, x2, y2;
+	GAUGE_Point( gauge, angle, inner, &x1, &y1 );
+	GAUGE_Point( gauge, angle, outer, &x2, &y2 );
+	GAUGE_PlotLine( gauge, x1, y1, x2, y2, true );
+
+	if (x1 < dirty[0]) { dirty[0] = x1; }
+	if (x2 < dirty[0]) { dirty[0] = x2; }
+	if (y1 < dirty[1]) { dirty[1] = y1; }
+	if (y2 < dirty[1]) { dirty[1] = y2; }
+	if (x1 > dirty[2]) { dirty[2] = x1; }
+	if (x2 > dirty[2]) { dirty[2] = x2; }
+	if (y1 > dirty[3]) { dirty[3] = y1; }
+	if (y2 > dirty[3]) { dirty[3] = y2; }
+}
+
+
+/*!
+ *  The rectangle is clipped to the gauge area and widened to whole pages.
+ *  One LCD_WritePage is done per page.
+ *
+ * \param  gauge  Gauge to write
+ * \param  dirty  Rectangle as left, top, right, bottom, inclusive
+ */
+static void GAUGE_WriteArea( GAUGE_gauge_t const * gauge, int16_t const * dirty )
+{
+	int16_t left = dirty[0];
+	int16_t top = dirty[1];
+	int16_t right = dirty[2];
+	int16_t bottom = dirty[3];
+	if (left < 0) { left = 0; }
+	if (top < 0) { top = 0; }
+	if (right >= gauge->width) { right = gauge->width - 1; }
+	if (bottom >= (gauge->pageCount * LCD_PAGE_HEIGHT)) { bottom = gauge->pageCount * LCD_PAGE_HEIGHT - 1; }
+	if ((left > right) || (top > bottom)) {
+		return;
+	}
+
+	for (uint8_t page = top / LCD_PAGE_HEIGHT; page <= (bottom / LCD_PAGE_HEIGHT); ++page) {
+		LCD_WritePage( gauge->pageBuffer + page * gauge->width + left, gauge->page + page, gauge->column + left, right - left + 1 );
+	}
+}
+
+
+// end of file
@@ -0,0 +1,104 @@
+// This file has been prepared for Doxygen automatic documentation generation.
+/*! \file *********************************************************************
+ *
+ * \brief  Arc gauge widget header file
+ *
+ *         A gauge shows a value as a needle sweeping over a dial with tick
+ *         marks and an optional arc. The gauge area is kept in an SRAM page
+ *         buffer. The needle is drawn into the buffer with XOR, so moving it
+ *         is done by XOR-ing the old needle away and the new one in, which
+ *         restores the dial underneath without redrawing it. Only the pages
+ *         and columns covered by the old and new needle are then written to
+ *         the LCD.
+ *
+ *         Angles are binary angles, 256 per full turn, with 0 pointing up
+ *         and increasing clockwise. Sine and cosine are looked up in a
+ *         quarter-wave table in flash, so no floating point is used.
+ *
+ *****************************************************************************/
+#ifndef GAUGE_LIB_H
+#define GAUGE_LIB_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+
+
+/************************
+ * Constants and defines
+ ************************/
+
+#define GAUGE_ANGLE_QUARTER 64  //!< Binary angle for a quarter turn, 90 degrees.
+#define GAUGE_TRIG_ONE 255  //!< GAUGE_Sin and GAUGE_Cos value for 1.0.
+
+#define GAUGE_STYLE_ARC   (1<<0)  //!< Draw an arc through the outer end of the ticks.
+#define GAUGE_STYLE_PIVOT (1<<1)  //!< Draw a small box at the needle pivot.
+
+#define GAUGE_DEFAULT_START 160  //!< Default start angle, 135 degrees left of up.
+#define GAUGE_DEFAULT_SWEEP 192  //!< Default sweep, 270 degrees.
+
+//! Size in bytes of the page buffer needed for a gauge.
+#define GAUGE_PAGEBUFFER_SIZE(width, pageCount) ((width) * (pageCount))
+
+
+
+/*********************
+ * Types and typedefs
+ *********************/
+
+//! State of one gauge. Initialize with GAUGE_Init, do not modify directly.
+typedef struct GAUGE_gauge_struct
+{
+	uint8_t column;  //!< Leftmost LCD column of gauge area.
+	uint8_t page;  //!< Top LCD page of gauge area.
+	uint8_t width;  //!< Gauge area width in pixels.
+	uint8_t pageCount;  //!< Gauge area height in LCD pages.
+	uint8_t centerX;  //!< Needle pivot, relative to gauge area.
+	uint8_t centerY;  //!< Needle pivot, relative to gauge area.
+	uint8_t radius;  //!< Radius to outer end of ticks, max 127.
+	uint8_t style;  //!< Combination of GAUGE_STYLE_* flags.
+
+	uint8_t startAngle;  //!< Binary angle of needle at zero value.
+	uint8_t sweep;  //!< Binary angle from zero to full-scale value.
+	uint8_t tickCount;  //!< Number of ticks including both ends, 0 for none.
+	uint8_t tickLength;  //!< Tick length in pixels.
+
+	uint16_t maxValue;  //!< Full-scale value.
+	uint16_t value;  //!< Last value given to GAUGE_Update.
+	uint32_t scale;  //!< Binary angle per value unit, 16.16 fixed point.
+
+	uint8_t needleAngle;  //!< Angle of needle in page buffer.
+	bool needleDrawn;  //!< True if needle is in page buffer.
+
+	uint8_t * pageBuffer;  //!< Rendered gauge, pageCount rows of width bytes, top page first.
+} GAUGE_gauge_t;
+
+
+
+/**********************
+ * Function prototypes
+ **********************/
+
+//! Initialize gauge state with default angles and no ticks. Does not draw anything.
+void GAUGE_Init( GAUGE_gauge_t * gauge, uint8_t column, uint8_t page, uint8_t width, uint8_t pageCount, uint8_t * pageBuffer, uint8_t centerX, uint8_t centerY, uint8_t radius, uint8_t style, uint16_t maxValue );
+//! Set binary start angle and sweep of the scale.
+void GAUGE_SetAngles( GAUGE_gauge_t * gauge, uint8_t startAngle, uint8_t sweep );
+//! Set number of ticks, both ends included, and their length.
+void GAUGE_SetTicks( GAUGE_gauge_t * gauge, uint8_t tickCount, uint8_t tickLength );
+//! Change full-scale value. Takes effect on next update.
+void GAUGE_SetMaxValue( GAUGE_gauge_t * gauge, uint16_t maxValue );
+//! Render dial and needle and write the whole gauge area to LCD.
+void GAUGE_Draw( GAUGE_gauge_t * gauge );
+//! Set new value, move needle and write only the area it touched.
+void GAUGE_Update( GAUGE_gauge_t * gauge, uint16_t value );
+//! Set new value without drawing, e.g. while gauge is not on screen. Shown on next GAUGE_Draw.
+void GAUGE_SetValue( GAUGE_gauge_t * gauge, uint16_t value );
+
+//! Sine of binary angle, scaled to +/- GAUGE_TRIG_ONE.
+int16_t GAUGE_Sin( uint8_t angle );
+//! Cosine of binary angle, scaled to +/- GAUGE_TRIG_ONE.
+int16_t GAUGE_Cos( uint8_t angle );
+
+
+#endif
+// end of file
@@ -185,196 +185,119 @@ static uint8_t const CAL_PGM_DEF(* const soc_pictures[102]) = {
 void LCD_UpdateSOC(uint8_t soc)
 {
 	// Battery icon location is right of the screen, from top left 96 px X, 0 px Y
-	// Battery icon size is 32 x 64 px.
-
-	//PICTURE_CopyFullscreenFlashToLcd( CAL_pgm_read_puint8(&pictures[picIdx]) );
-	
-	//! Display section of image data stored in FLASH on display.
-	/*void PICTURE_CopyFlashToLcd(
-		uint8_t const CAL_PGM(* source), uint16_t sourceWidth, uint16_t sourceX, uint8_t sourcePage,
-		uint8_t destX, uint8_t destPage,
-		uint8_t width, uint8_t heightInPages );	
-	*/
-	if (soc < 1)
-		soc = 0;
-	if (soc > 100)
-		soc = 100;
-		
-	PICTURE_CopyFlashToLcd(CAL_pgm_read_puint8(&soc_pictures[soc]), 32, 0, 0, 96, 0, 32, 8);
-	
+	LCD_DrawBattery(soc, 96, 0);
 	LCD_UpdateBigNumbers(soc);
-	
 }
 
-void LCD_UpdateMinVolt(uint16_t volt)
+void LCD_DrawBattery(uint8_t soc, uint8_t x, uint8_t page)
 {
-	//TERMFONT_DisplayChar( *str, page, column );
-	// y, x
-	// y = rows
-	// x = pixels ?
-	char buffer [sizeof(uint16_t)*8+1];
-	int charw=6;
-	int startpos=60;
-	
-	TERMFONT_DisplayString("Min Volt:", 7, 0);
-	
-	// convert to ascii
-    itoa(volt,buffer,10);
-
-	//TERMFONT_DisplayChar(buffer[0], 7, startpos );
-	
-	if (volt<10)
-	{
-		// leading zero
-		TERMFONT_DisplayChar('0', 7, startpos );
-		TERMFONT_DisplayChar('.', 7, startpos+charw );
-		TERMFONT_DisplayChar(buffer[0], 7, startpos+2*charw );
-	} else {
-		TERMFONT_DisplayChar(buffer[0], 7, startpos );
-		TERMFONT_DisplayChar('.', 7, startpos+charw );
-		TERMFONT_DisplayChar(buffer[1], 7, startpos+2*charw );
-		TERMFONT_DisplayChar(buffer[2], 7, startpos+3*charw );
-	}
-
-	TERMFONT_DisplayString("V" , 7, startpos+4*charw );
-
+	// Battery icon size is 32 x 64 px.
+	if (soc > 100)
+		soc = 100;
+		
+	PICTURE_CopyFlashToLcd(CAL_pgm_read_puint8(&soc_pictures[soc]), 32, 0, 0, x, page, 32, 8);
 }
 
-void LCD_UpdateMaxTemp(uint8_t temp)
+void LCD_UpdateBigNumbers(uint8_t value)
 {
-	char buffer [sizeof(uint8_t)*8+1];
-    itoa(temp,buffer,10);
-	
-	TERMFONT_DisplayString( "Max Temp:", 5, 0 );
-
-	if (temp<10)
-	{
-		// erase old content
-		TERMFONT_DisplayString("    ",5,66);
-		TERMFONT_DisplayString(buffer,5,66);
-	} else {
-		TERMFONT_DisplayString( buffer, 5, 66 );
-	}
-	
-	TERMFONT_DisplayString( "C", 5, 84 );
-
+	LCD_DrawBigNumbers(value, 0, 0);
 }
 
-void LCD_UpdateBigNumbers(uint8_t value)
+void LCD_DrawBigNumbers(uint8_t value, uint8_t x, uint8_t page)
 {
-	// 1 - 3 BIG numbers to the middle of the screen
+	// 1 - 3 BIG numbers, 96 x 32 px area starting at x, page
 	//
-	// 1 number, position 32,0 px from left corner
-	// 2 numbers, positions 16,0 px and 48,0 px 
-	// 3 numbers, positions 0,0 px, 32,0 px and 64,0 px
+	// 1 number, number at x+32 px and percent mark at x+64 px
+	// 2 numbers, numbers at x and x+32 px, percent mark at x+64 px
+	// 3 numbers, positions x, x+32 px and x+64 px
 	//
 	// Each number 32 px x 32 px in size.
 	//
 
-	int first=0;
-	int second=0;
-	int third=0;
+	uint8_t first;
+	uint8_t second;
+	uint8_t third;
 	
-	if (value < 1)
-		value = 0;
 	if (value > 254)
 		value = 254;
 	
 	// clear background "just in case" there is some garbage on the screen
-	LCD_ClrBox(0,0,96,32);
+	LCD_ClrBox(x, page*LCD_PAGE_HEIGHT, x+95, page*LCD_PAGE_HEIGHT+31);
 
 	if (value < 10)
 	{
-		// 1 number to the middle of the screen
-		PICTURE_CopyFlashToLcd(CAL_pgm_read_puint8(&big_number_pictures[value]), 32, 0, 0, 32, 0, 32, 4);
+		// 1 number to the middle of the area
+		PICTURE_CopyFlashToLcd(CAL_pgm_read_puint8(&big_number_pictures[value]), 32, 0, 0, x+32, page, 32, 4);
 
 		// percent mark to this row
-		PICTURE_CopyFlashToLcd(FLASHPICS_pros, 32, 0, 0, 64, 0, 32, 4);
-
+		PICTURE_CopyFlashToLcd(FLASHPICS_pros, 32, 0, 0, x+64, page, 32, 4);
 	} 
-	else if (value > 9 && value < 100) 
+	else if (value < 100) 
 	{
-		/*
-		
-		// 2 numbers to the middle of the screen
+		// 2 numbers and percent mark
 		first = value / 10;
-		// 1st number
-		PICTURE_CopyFlashToLcd(CAL_pgm_read_puint8(&big_number_pictures[first]), 32, 0, 0, 16, 0, 32, 4);
-		
-		second = value - (first*10);
-		// 2nd number
-		PICTURE_CopyFlashToLcd(CAL_pgm_read_puint8(&big_number_pictures[second]), 32, 0, 0, 48, 0, 32, 4);
-		
-		*/
-		
-		// 2 numbers and percent mark to the middle of the screen
-		first = value / 10;
-		// 1st number
-		PICTURE_CopyFlashToLcd(CAL_pgm_read_puint8(&big_number_pictures[first]), 32, 0, 0, 0, 0, 32, 4);
-		
 		second = value - (first*10);
-		// 2nd number
-		PICTURE_CopyFlashToLcd(CAL_pgm_read_puint8(&big_number_pictures[second]), 32, 0, 0, 32, 0, 32, 4);
-		
-		// percent mark to this row
-		PICTURE_CopyFlashToLcd(FLASHPICS_pros, 32, 0, 0, 64, 0, 32, 4);
-		
-		// percent mark to next row
-		//PICTURE_CopyFlashToLcd(FLASHPICS_pros, 32, 0, 0, 32, 4, 32, 4);
+		PICTURE_CopyFlashToLcd(CAL_pgm_read_puint8(&big_number_pictures[first]), 32, 0, 0, x, page, 32, 4);
+		PICTURE_CopyFlashToLcd(CAL_pgm_read_puint8(&big_number_pictures[second]), 32, 0, 0, x+32, page, 32, 4);
 
+		// percent mark to this row
+		PICTURE_CopyFlashToLcd(FLASHPICS_pros, 32, 0, 0, x+64, page, 32, 4);
 	}
 	else
 	{
-		// 3 numbers to the screen
-		
+		// 3 numbers
 		first = value / 100;
 		second = (value - (first*100)) / 10;
 		third = value - (first*100) - (second*10);
-
-		// 1st number
-		PICTURE_CopyFlashToLcd(CAL_pgm_read_puint8(&big_number_pictures[first]), 32, 0, 0, 0, 0, 32, 4);
-		
-		// 2nd number
-		PICTURE_CopyFlashToLcd(CAL_pgm_read_puint8(&big_number_pictures[second]), 32, 0, 0, 32, 0, 32, 4);
-
-		// 3rd number
-		PICTURE_CopyFlashToLcd(CAL_pgm_read_puint8(&big_number_pictures[third]), 32, 0, 0, 64, 0, 32, 4);
-			
+		PICTURE_CopyFlashToLcd(CAL_pgm_read_puint8(&big_number_pictures[first]), 32, 0, 0, x, page, 32, 4);
+		PICTURE_CopyFlashToLcd(CAL_pgm_read_puint8(&big_number_pictures[second]), 32, 0, 0, x+32, page, 32, 4);
+		PICTURE_CopyFlashToLcd(CAL_pgm_read_puint8(&big_number_pictures[third]), 32, 0, 0, x+64, page, 32, 4);
 	}
-
 }
 
 /*
- * \param  Xstart  X-coordinate for the start of the line
- * \param  Ystart  Y-coordinate for the start of the line
- * \param  Xend    X-coordinate for the end of the line
- * \param  Yend    X-coordinate for the end of the line
+ * Stateless progress bar, redrawn completely on every call. Use the BAR_*
+ * widget in bar_lib.h for bars that are updated periodically.
+ *
+ * \param  Xstart     X-coordinate of the left edge of the frame
+ * \param  Ystart     Y-coordinate of the top edge of the frame
+ * \param  height     Distance from top to bottom edge of the frame
+ * \param  lenght     Distance from left to right edge of the frame
+ * \param  maxvalue   Value giving a full bar
+ * \param  currvalue  Value to display
+ * \param  peakvalue  Position of peak marker line, not drawn if below currvalue
  */
 void LCD_DrawProgressBar(uint8_t Xstart, uint8_t Ystart, uint8_t height, uint8_t lenght, uint8_t maxvalue, uint8_t currvalue, uint8_t peakvalue)
 {
-	uint8_t i;
 	uint8_t val2px;
-	
+	uint8_t peak2px;
+
+	if ((maxvalue == 0) || (height < 2) || (lenght < 2))
+		return;
+	if (currvalue > maxvalue)
+		currvalue = maxvalue;
+	if (peakvalue > maxvalue)
+		peakvalue = maxvalue;
+
 	// draw box around corners of progress bar
-	LCD_SetLine(Xstart,Ystart,Xstart+lenght,Ystart);
-	LCD_SetLine(Xstart+lenght,Ystart,Xstart+lenght,Ystart+height);
-	LCD_SetLine(Xstart,Ystart+height,Xstart+lenght,Ystart+height);
-	LCD_SetLine(Xstart,Ystart,Xstart,Ystart+height);
-	
-	// calculate value in pixels
-	val2px = lenght/maxvalue*currvalue;
-	
-	// clear box from previous values
-	for (i=1;i<lenght;i++)
-	{
-		LCD_ClrLine(Xstart+i,Ystart+1,Xstart+i,Ystart+height-1);		
-	}
-	
-	// fill box up to value
-	for (i=1;i<val2px;i++)
-	{
-		LCD_SetLine(Xstart+i,Ystart,Xstart+i,Ystart+height);		
-	}
+	LCD_SetHLine(Xstart, Xstart+lenght, Ystart);
+	LCD_SetHLine(Xstart, Xstart+lenght, Ystart+height);
+	LCD_SetVLine(Xstart, Ystart, Ystart+height);
+	LCD_SetVLine(Xstart+lenght, Ystart, Ystart+height);
+
+	// calculate value in pixels, multiply first so that small values don't truncate to 0
+	val2px = ((uint16_t)(lenght-1) * currvalue) / maxvalue;
+	peak2px = ((uint16_t)(lenght-1) * peakvalue) / maxvalue;
+
+	// fill box up to value and clear the rest, both as page-masked box writes
+	if (val2px > 0)
+		LCD_SetBox(Xstart+1, Ystart+1, Xstart+val2px, Ystart+height-1);
+	if (val2px < lenght-1)
+		LCD_ClrBox(Xstart+val2px+1, Ystart+1, Xstart+lenght-1, Ystart+height-1);
+
+	// peak marker
+	if (peak2px > val2px)
+		LCD_SetVLine(Xstart+peak2px, Ystart+1, Ystart+height-1);
 }
 
 /*
@@ -69,19 +69,19 @@ void LCD_ClrLine(uint8_t Xstart, uint8_t Ystart, uint8_t Xend, uint8_t Yend);
 void LCD_SetCircle(uint8_t Xcenter, uint8_t Ycenter, uint8_t Radius);
 //! Clear a circle, specified by center and radius
 void LCD_ClrCircle(uint8_t Xcenter, uint8_t Ycenter, uint8_t Radius);
-//! Draw a progress bar
+//! Draw a complete progress bar. See bar_lib.h for incremental updates.
 void LCD_DrawProgressBar(uint8_t Xstart, uint8_t Ystart, uint8_t height, uint8_t lenght, uint8_t maxvalue, uint8_t currvalue, uint8_t peakvalue);
 
 //! Draw a battery icon
 void LCD_UpdateSOC(uint8_t soc);
 
-//! Max temperature
-void LCD_UpdateMaxTemp(uint8_t temp);
-
-//! Min voltage
-void LCD_UpdateMinVolt(uint16_t volt);
-
 //! Draw big numbers to the center of the screen
 void LCD_UpdateBigNumbers(uint8_t value);
 
+//! Draw battery picture for state of charge 0-100 %, 32 x 64 px
+void LCD_DrawBattery(uint8_t soc, uint8_t x, uint8_t page);
+
+//! Draw big numbers with percent mark into a 96 x 32 px area
+void LCD_DrawBigNumbers(uint8_t value, uint8_t x, uint8_t page);
+
 #endif
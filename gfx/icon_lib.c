@@ -0,0 +1,177 @@
+// This file has been prepared for Doxygen automatic documentation generation.
+/*! \file *********************************************************************
+ *
+ * \brief  Status icon atlas source file
+ *
+ *         Glyphs are stored in LCD page format, one byte per column with the
+ *         top pixel in bit 0, as for PICTURE_CopyFlashToLcd.
+ *
+ *****************************************************************************/
+
+#include "icon_lib.h"
+#include <cal.h>
+#include <lcd_lib.h>
+
+
+
+/********************
+ * Private variables
+ ********************/
+
+//! Packed glyphs of all icons, ICON_WIDTH bytes each, in icon ID and state order.
+static uint8_t const CAL_PGM_DEF(ICON_atlas[][ICON_WIDTH]) = {
+	{ 0x00, 0x08, 0x4C, 0x6E, 0x76, 0x32, 0x10, 0x00 },  // Charging.
+	{ 0x08, 0x08, 0x1C, 0x3E, 0x3E, 0x3E, 0x14, 0x14 },  // Plug.
+	{ 0x40, 0x70, 0x4C, 0x5B, 0x5B, 0x4C, 0x70, 0x40 },  // Fault.
+	{ 0x20, 0x38, 0x7C, 0x3C, 0x7C, 0x3C, 0x2E, 0x06 },  // Turtle.
+	{ 0x06, 0x0E, 0x6C, 0x78, 0x1E, 0x36, 0x70, 0x60 },  // Fan, first blade position.
+	{ 0x60, 0x70, 0x36, 0x1E, 0x78, 0x6C, 0x0E, 0x06 },  // Fan, second blade position.
+	{ 0x10, 0x38, 0x08, 0x04, 0x02, 0x00, 0x38, 0x10 },  // Contactor open.
+	{ 0x10, 0x38, 0x10, 0x10, 0x10, 0x10, 0x38, 0x10 }   // Contactor closed.
+};
+
+//! Atlas index of the glyph for state 1 of each icon. The last entry ends the atlas.
+static uint8_t const CAL_PGM_DEF(ICON_index[ICON_COUNT + 1]) = {
+	0,  // ICON_CHARGING
+	1,  // ICON_PLUG
+	2,  // ICON_FAULT
+	3,  // ICON_TURTLE
+	4,  // ICON_FAN
+	6,  // ICON_CONTACTOR
+	8
+};
+
+
+
+/*******************************
+ * Internal function prototypes
+ *******************************/
+
+//! Render one slot into a page buffer of ICON_SLOT_WIDTH bytes.
+static void ICON_RenderSlot( ICON_strip_t const * strip, uint8_t slot, uint8_t * buffer );
+
+
+
+/***************************
+ * Function implementations
+ ***************************/
+
+/*!
+ * \param  strip      Strip state
+ * \param  page       LCD page
+ * \param  column     Leftmost LCD column
+ * \param  firstIcon  Icon ID of first slot
+ * \param  count      Number of slots, showing icons firstIcon and up
+ */
+void ICON_Init( ICON_strip_t * strip, uint8_t page, uint8_t column, uint8_t firstIcon, uint8_t count )
+{
+	if (firstIcon > ICON_COUNT) {
+		firstIcon = ICON_COUNT;
+	}
+	if (count > ICON_COUNT - firstIcon) {
+		count = ICON_COUNT - firstIcon;
+	}
+	if (count > (LCD_WIDTH - column) / ICON_SLOT_WIDTH) {
+		count = (LCD_WIDTH - column) / ICON_SLOT_WIDTH;
+	}
+
+	strip->page = page;
+	strip->column = column;
+	strip->firstIcon = firstIcon;
+	strip->count = count;
+	strip->changed = 0x00;
+	for (uint8_t slot = 0; slot < ICON_COUNT; ++slot) {
+		strip->state[slot] = ICON_HIDDEN;
+	}
+}
+
+
+/*!
+ *  Setting the state an icon already has, or an icon not in the strip,
+ *  does nothing. States without a glyph show the icon hidden.
+ */
+void ICON_SetState( ICON_strip_t * strip, uint8_t icon, uint8_t state )
+{
+	uint8_t const slot = icon - strip->firstIcon;
+	if ((icon < strip->firstIcon) || (slot >= strip->count)) {
+		return;
+	}
+	if (strip->state[slot] != state) {
+		strip->state[slot] = state;
+		strip->changed |= (1 << slot);
+	}
+}
+
+
+uint8_t ICON_GetState( ICON_strip_t const * strip, uint8_t icon )
+{
+	uint8_t const slot = icon - strip->firstIcon;
+	if ((icon < strip->firstIcon) || (slot >= strip->count)) {
+		return ICON_HIDDEN;
+	}
+	return strip->state[slot];
+}
+
+
+bool ICON_IsChanged( ICON_strip_t const * strip )
+{
+	return strip->changed != 0x00;
+}
+
+
+void ICON_Draw( ICON_strip_t * strip )
+{
+	strip->changed = (1 << strip->count) - 1;
+	ICON_Update( strip );
+}
+
+
+/*!
+ *  Unchanged slots between two changed ones are rendered again as part of
+ *  the span, which is cheaper than a page write per changed slot.
+ */
+void ICON_Update( ICON_strip_t * strip )
+{
+	if (strip->changed == 0x00) {
+		return;
+	}
+
+	uint8_t first = 0;
+	while ((strip->changed & (1 << first)) == 0x00) {
+		++first;
+	}
+	uint8_t last = strip->count - 1;
+	while ((strip->changed & (1 << last)) == 0x00) {
+		--last;
+	}
+	strip->changed = 0x00;
+
+	uint8_t buffer[ICON_COUNT * ICON_SLOT_WIDTH];
+	for (uint8_t slot = first; slot <= last; ++slot) {
+		ICON_RenderSlot( strip, slot, &buffer[(slot - first) * ICON_SLOT_WIDTH] );
+	}
+	LCD_WritePage( buffer, strip->page, strip->column + first * ICON_SLOT_WIDTH, (last - first + 1) * ICON_SLOT_WIDTH );
+}
+
+
+static void ICON_RenderSlot( ICON_strip_t const * strip, uint8_t slot, uint8_t * buffer )
+{
+	uint8_t const icon = strip->firstIcon + slot;
+	uint8_t const state = strip->state[slot];
+	uint8_t const first = CAL_pgm_read_byte( &ICON_index[icon] );
+	uint8_t const end = CAL_pgm_read_byte( &ICON_index[icon + 1] );
+
+	uint8_t column = 0;
+	if ((state != ICON_HIDDEN) && (state <= end - first)) {
+		uint8_t const CAL_PGM(* glyph) = ICON_atlas[first + state - 1];
+		for (; column < ICON_WIDTH; ++column) {
+			buffer[column] = CAL_pgm_read_byte( &glyph[column] );
+		}
+	}
+	for (; column < ICON_SLOT_WIDTH; ++column) {
+		buffer[column] = 0x00;
+	}
+}
+
+
+// end of file
@@ -0,0 +1,87 @@
+// This file has been prepared for Doxygen automatic documentation generation.
+/*! \file *********************************************************************
+ *
+ * \brief  Status icon atlas header file
+ *
+ *         All status icons are 8x8 pixel glyphs packed into one flash table,
+ *         the atlas. An index table gives the first glyph of each icon, so an
+ *         icon can have several glyphs, one for each visible state. State 0
+ *         is always hidden and needs no glyph.
+ *
+ *         Icons are shown in strips, a row of fixed slots on one LCD page.
+ *         Setting an icon state only marks the slot as changed. ICON_Update
+ *         then renders the span from the first to the last changed slot into
+ *         a page buffer and writes it with one LCD_WritePage, so unchanged
+ *         icons are not drawn and a frame costs at most one page write per
+ *         strip.
+ *
+ *****************************************************************************/
+#ifndef ICON_LIB_H
+#define ICON_LIB_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+
+
+/************************
+ * Constants and defines
+ ************************/
+
+#define ICON_WIDTH 8  //!< Glyph width in pixels, one page high.
+#define ICON_SLOT_WIDTH 10  //!< Columns per strip slot, glyph plus gap.
+
+#define ICON_HIDDEN 0  //!< State of a hidden icon.
+#define ICON_SHOWN 1  //!< State of an icon with one glyph when shown.
+
+//! Icon IDs, in atlas order. A strip shows consecutive IDs.
+enum ICON_id_enum
+{
+	ICON_CHARGING,  //!< Charging, state 1 shows a bolt.
+	ICON_PLUG,  //!< Charge plug connected, state 1 shows a plug.
+	ICON_FAULT,  //!< Fault, state 1 shows a warning triangle.
+	ICON_TURTLE,  //!< Power limited, state 1 shows a turtle.
+	ICON_FAN,  //!< Fan running, states 1 and 2 show alternating blade positions.
+	ICON_CONTACTOR,  //!< Main contactor, state 1 open, state 2 closed.
+	ICON_COUNT  //!< Number of icons, at most 8.
+};
+
+
+
+/*********************
+ * Types and typedefs
+ *********************/
+
+//! State of one icon strip. Initialize with ICON_Init, do not modify directly.
+typedef struct ICON_strip_struct
+{
+	uint8_t page;  //!< LCD page of strip.
+	uint8_t column;  //!< Leftmost LCD column of strip.
+	uint8_t firstIcon;  //!< Icon ID in first slot.
+	uint8_t count;  //!< Number of slots.
+	uint8_t changed;  //!< Bit mask of slots changed since last draw.
+	uint8_t state[ICON_COUNT];  //!< Current state of each slot.
+} ICON_strip_t;
+
+
+
+/**********************
+ * Function prototypes
+ **********************/
+
+//! Initialize strip with all icons hidden. Does not draw anything.
+void ICON_Init( ICON_strip_t * strip, uint8_t page, uint8_t column, uint8_t firstIcon, uint8_t count );
+//! Set state of an icon. Drawn on next ICON_Update or ICON_Draw.
+void ICON_SetState( ICON_strip_t * strip, uint8_t icon, uint8_t state );
+//! Get state of an icon.
+uint8_t ICON_GetState( ICON_strip_t const * strip, uint8_t icon );
+//! Return true if any icon changed since the strip was last drawn.
+bool ICON_IsChanged( ICON_strip_t const * strip );
+//! Draw all slots, e.g. after screen has been cleared.
+void ICON_Draw( ICON_strip_t * strip );
+//! Draw only the changed slots, with one page write.
+void ICON_Update( ICON_strip_t * strip );
+
+
+#endif
+// end of file
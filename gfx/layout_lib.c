@@ -0,0 +1,293 @@
+// This file has been prepared for Doxygen automatic documentation generation.
+/*! \file *********************************************************************
+ *
+ * \brief  Table-driven screen layout engine source file
+ *
+ *         See layout_lib.h for a description of the layout tables. Items
+ *         are copied from flash to the stack one at a time before use, so
+ *         the engine itself needs no SRAM besides the widget states given
+ *         in the table.
+ *
+ *****************************************************************************/
+
+#include "layout_lib.h"
+#include <stdbool.h>
+#include <lcd_lib.h>
+#include <termfont_lib.h>
+#include <gfx_lib.h>
+#include <numfield_lib.h>
+#include <bar_lib.h>
+#include <gauge_lib.h>
+#include <chart_lib.h>
+
+
+
+/*******************************
+ * Internal function prototypes
+ *******************************/
+
+//! Copy one item from flash.
+static void LAYOUT_ReadItem( LAYOUT_layout_t const CAL_PGM(* layout), uint8_t index, LAYOUT_item_t * item );
+//! Initialize widget state of one item.
+static void LAYOUT_InitItem( LAYOUT_item_t const * item );
+//! Draw one item completely.
+static void LAYOUT_DrawItem( LAYOUT_item_t const * item );
+//! Give all items bound to a signal a new value, drawing them if requested.
+static void LAYOUT_UpdateSignal( LAYOUT_layout_t const CAL_PGM(* layout), uint8_t signal, int16_t value, bool draw );
+//! Give one item a new value, drawing it if requested.
+static void LAYOUT_UpdateItem( LAYOUT_item_t const * item, int16_t value, bool draw );
+
+
+
+/***************************
+ * Function implementations
+ ***************************/
+
+void LAYOUT_Init( LAYOUT_layout_t const CAL_PGM(* layout) )
+{
+	LAYOUT_item_t item;
+	uint8_t const itemCount = CAL_pgm_read_byte( &layout->itemCount );
+	for (uint8_t index = 0; index < itemCount; ++index) {
+		LAYOUT_ReadItem( layout, index, &item );
+		LAYOUT_InitItem( &item );
+	}
+}
+
+
+/*!
+ *  Items are drawn in table order, which the layout compiler sorts by page
+ *  and column. Widgets draw their last known value.
+ */
+void LAYOUT_Draw( LAYOUT_layout_t const CAL_PGM(* layout) )
+{
+	LAYOUT_item_t item;
+	uint8_t const itemCount = CAL_pgm_read_byte( &layout->itemCount );
+	for (uint8_t index = 0; index < itemCount; ++index) {
+		LAYOUT_ReadItem( layout, index, &item );
+		LAYOUT_DrawItem( &item );
+	}
+}
+
+
+/*!
+ *  The buffer is laid out as for LCD_WriteFrameBuffer. Only labels are
+ *  composed, the widget areas are left blank.
+ */
+void LAYOUT_DrawStatic( LAYOUT_layout_t const CAL_PGM(* layout), uint8_t * buffer )
+{
+	LCD_SetBuffer( buffer, 0x00 );
+
+	LAYOUT_item_t item;
+	uint8_t const itemCount = CAL_pgm_read_byte( &layout->itemCount );
+	for (uint8_t index = 0; index < itemCount; ++index) {
+		LAYOUT_ReadItem( layout, index, &item );
+		if (item.type == LAYOUT_TYPE_LABEL) {
+			TERMFONT_DisplayBufferString_F( buffer, item.text, item.y, item.x );
+		}
+	}
+}
+
+
+void LAYOUT_DrawDynamic( LAYOUT_layout_t const CAL_PGM(* layout) )
+{
+	LAYOUT_item_t item;
+	uint8_t const itemCount = CAL_pgm_read_byte( &layout->itemCount );
+	for (uint8_t index = 0; index < itemCount; ++index) {
+		LAYOUT_ReadItem( layout, index, &item );
+		if (item.type != LAYOUT_TYPE_LABEL) {
+			LAYOUT_DrawItem( &item );
+		}
+	}
+}
+
+
+/*!
+ *  Only the items bound to the signal are visited, found through the
+ *  signal map of the layout. Unknown signal IDs are ignored.
+ *
+ * \param  layout  Layout to update
+ * \param  signal  Signal ID that got a new value
+ * \param  value   New value
+ */
+void LAYOUT_Update( LAYOUT_layout_t const CAL_PGM(* layout), uint8_t signal, int16_t value )
+{
+	LAYOUT_UpdateSignal( layout, signal, value, true );
+}
+
+
+/*!
+ *  The new values are shown on the next LAYOUT_Draw or LAYOUT_DrawDynamic.
+ *  Charts keep collecting samples into their history as usual.
+ */
+void LAYOUT_Store( LAYOUT_layout_t const CAL_PGM(* layout), uint8_t signal, int16_t value )
+{
+	LAYOUT_UpdateSignal( layout, signal, value, false );
+}
+
+
+static void LAYOUT_UpdateSignal( LAYOUT_layout_t const CAL_PGM(* layout), uint8_t signal, int16_t value, bool draw )
+{
+	if (signal >= CAL_pgm_read_byte( &layout->signalCount )) {
+		return;
+	}
+
+	uint8_t const CAL_PGM(* signalStart) = CAL_pgm_read_puint8( &layout->signalStart );
+	uint8_t const CAL_PGM(* signalItems) = CAL_pgm_read_puint8( &layout->signalItems );
+	uint8_t const end = CAL_pgm_read_byte( &signalStart[signal + 1] );
+
+	LAYOUT_item_t item;
+	for (uint8_t offset = CAL_pgm_read_byte( &signalStart[signal] ); offset < end; ++offset) {
+		LAYOUT_ReadItem( layout, CAL_pgm_read_byte( &signalItems[offset] ), &item );
+		LAYOUT_UpdateItem( &item, value, draw );
+	}
+}
+
+
+static void LAYOUT_ReadItem( LAYOUT_layout_t const CAL_PGM(* layout), uint8_t index, LAYOUT_item_t * item )
+{
+	LAYOUT_item_t const CAL_PGM(* items) = (LAYOUT_item_t const CAL_PGM(*)) CAL_pgm_read_pvoid( &layout->items );
+	uint8_t const CAL_PGM(* source) = (uint8_t const CAL_PGM(*)) &items[index];
+	uint8_t * destination = (uint8_t *) item;
+	for (uint8_t count = sizeof(LAYOUT_item_t); count != 0; --count) {
+		*destination++ = CAL_pgm_read_byte( source++ );
+	}
+}
+
+
+static void LAYOUT_InitItem( LAYOUT_item_t const * item )
+{
+	switch (item->type) {
+		case LAYOUT_TYPE_NUMBER:
+			NUMFIELD_Init( item->state, item->y, item->x, item->width, item->arg[0], item->style, item->text );
+			NUMFIELD_SetScale( item->state, item->range, item->arg[1] );
+			break;
+
+		case LAYOUT_TYPE_BAR:
+			BAR_Init( item->state, item->x, item->y, item->width, item->height, item->style, item->range );
+			BAR_SetSegments( item->state, item->arg[0] );
+			BAR_SetPeakHold( item->state, item->arg[1] );
+			break;
+
+		case LAYOUT_TYPE_BIGNUMBER:
+		case LAYOUT_TYPE_BATTERY:
+			*(uint8_t *) item->state = 0;
+			break;
+
+		case LAYOUT_TYPE_GAUGE:
+			GAUGE_Init( item->state, item->x, item->y, item->width, item->height, item->buffer,
+			            item->arg[0], item->arg[1], item->arg[2], item->style, item->range );
+			GAUGE_SetTicks( item->state, item->arg[3], LAYOUT_GAUGE_TICK_LENGTH );
+			break;
+
+		case LAYOUT_TYPE_CHART:
+			// Column ring first, page buffer right after it.
+			CHART_Init( item->state, item->x, item->y, item->width, item->height,
+			            item->buffer, (uint8_t *) ((CHART_column_t *) item->buffer + item->width), item->arg[0] );
+			break;
+
+		default:
+			break;
+	}
+}
+
+
+static void LAYOUT_DrawItem( LAYOUT_item_t const * item )
+{
+	switch (item->type) {
+		case LAYOUT_TYPE_LABEL:
+			TERMFONT_DisplayString_F( item->text, item->y, item->x );
+			break;
+
+		case LAYOUT_TYPE_NUMBER:
+			NUMFIELD_Draw( item->state );
+			break;
+
+		case LAYOUT_TYPE_BAR:
+			BAR_Draw( item->state );
+			break;
+
+		case LAYOUT_TYPE_BIGNUMBER:
+			LCD_DrawBigNumbers( *(uint8_t *) item->state, item->x, item->y );
+			break;
+
+		case LAYOUT_TYPE_BATTERY:
+			LCD_DrawBattery( *(uint8_t *) item->state, item->x, item->y );
+			break;
+
+		case LAYOUT_TYPE_GAUGE:
+			GAUGE_Draw( item->state );
+			break;
+
+		case LAYOUT_TYPE_CHART:
+			CHART_Draw( item->state );
+			break;
+
+		default:
+			break;
+	}
+}
+
+
+/*!
+ *  Negative values are shown as zero on widgets that cannot show them.
+ *  Picture based items are only redrawn when their value changes, the other
+ *  widgets do their own change tracking.
+ */
+static void LAYOUT_UpdateItem( LAYOUT_item_t const * item, int16_t value, bool draw )
+{
+	uint16_t const unsignedValue = (value < 0) ? 0 : value;
+	uint8_t * lastValue = item->state;
+
+	switch (item->type) {
+		case LAYOUT_TYPE_NUMBER:
+			if (draw) {
+				NUMFIELD_Update( item->state, value );
+			} else {
+				NUMFIELD_SetValue( item->state, value );
+			}
+			break;
+
+		case LAYOUT_TYPE_BAR:
+			if (draw) {
+				BAR_Update( item->state, unsignedValue );
+			} else {
+				BAR_SetValue( item->state, unsignedValue );
+			}
+			break;
+
+		case LAYOUT_TYPE_BIGNUMBER:
+		case LAYOUT_TYPE_BATTERY: {
+			uint8_t const limit = (item->type == LAYOUT_TYPE_BATTERY) ? 100 : 254;
+			uint8_t const newValue = (unsignedValue > limit) ? limit : unsignedValue;
+			if (newValue != *lastValue) {
+				*lastValue = newValue;
+				if (draw) {
+					LAYOUT_DrawItem( item );
+				}
+			}
+			break;
+		}
+
+		case LAYOUT_TYPE_GAUGE:
+			if (draw) {
+				GAUGE_Update( item->state, unsignedValue );
+			} else {
+				GAUGE_SetValue( item->state, unsignedValue );
+			}
+			break;
+
+		case LAYOUT_TYPE_CHART:
+			if (draw) {
+				CHART_AddSample( item->state, value );
+			} else {
+				CHART_StoreSample( item->state, value );
+			}
+			break;
+
+		default:
+			break;
+	}
+}
+
+
+// end of file
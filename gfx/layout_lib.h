@@ -0,0 +1,123 @@
+// This file has been prepared for Doxygen automatic documentation generation.
+/*! \file *********************************************************************
+ *
+ * \brief  Table-driven screen layout engine header file
+ *
+ *         A layout is a table of items in flash, each item being a label or
+ *         a widget at a fixed position, optionally bound to a signal ID.
+ *         The layout engine initializes, draws and updates the widgets from
+ *         the table, so screens can be changed without touching C code.
+ *
+ *         Layout tables are normally generated from a text description by
+ *         the host tool utils/layout/layout2c.rb, which also checks the
+ *         regions, orders the items for drawing and builds the table that
+ *         maps each signal ID to the items bound to it.
+ *
+ *         Labels are the static part of a layout. They can be composed once
+ *         into a frame buffer with LAYOUT_DrawStatic, so showing the layout
+ *         again only takes LCD_WriteFrameBuffer and LAYOUT_DrawDynamic. A
+ *         layout that is not on screen can be kept up to date with
+ *         LAYOUT_Store, which updates widget states without drawing.
+ *
+ *****************************************************************************/
+#ifndef LAYOUT_LIB_H
+#define LAYOUT_LIB_H
+
+#include <stdint.h>
+#include <cal.h>
+
+
+
+/************************
+ * Constants and defines
+ ************************/
+
+#define LAYOUT_NO_SIGNAL 0xFF  //!< Signal ID for items that are not bound to any signal.
+
+#define LAYOUT_GAUGE_TICK_LENGTH 3  //!< Tick length for gauges in layouts.
+
+/*!
+ *  Item types. Fields not listed are unused for that type.
+ *
+ *  LABEL:     x, y (page), text.
+ *  NUMBER:    x, y (page), width (characters), style (NUMFIELD flags),
+ *             arg[0] (decimals), arg[1] (scale shift), range (scale
+ *             multiplier), text (units), state (NUMFIELD_field_t).
+ *  BAR:       x, y (pixel row), width (length), height (thickness), style
+ *             (BAR flags), arg[0] (segment width), arg[1] (peak hold
+ *             updates), range (max value), state (BAR_bar_t).
+ *  BIGNUMBER: x, y (page), state (uint8_t, last value).
+ *  BATTERY:   x, y (page), state (uint8_t, last value).
+ *  GAUGE:     x, y (page), width, height (pages), style (GAUGE flags),
+ *             arg[0..2] (pivot x, pivot y, radius), arg[3] (tick count),
+ *             range (max value), state (GAUGE_gauge_t), buffer (page buffer).
+ *  CHART:     x, y (page), width, height (pages), arg[0] (samples per
+ *             column), state (CHART_chart_t), buffer (width column entries
+ *             followed by the page buffer).
+ */
+enum LAYOUT_type_enum
+{
+	LAYOUT_TYPE_LABEL,
+	LAYOUT_TYPE_NUMBER,
+	LAYOUT_TYPE_BAR,
+	LAYOUT_TYPE_BIGNUMBER,
+	LAYOUT_TYPE_BATTERY,
+	LAYOUT_TYPE_GAUGE,
+	LAYOUT_TYPE_CHART
+};
+
+
+
+/*********************
+ * Types and typedefs
+ *********************/
+
+//! One item of a layout, stored in flash.
+typedef struct LAYOUT_item_struct
+{
+	uint8_t type;  //!< One of LAYOUT_TYPE_*.
+	uint8_t signal;  //!< Bound signal ID, or LAYOUT_NO_SIGNAL.
+	uint8_t x;  //!< Leftmost column.
+	uint8_t y;  //!< Top page, or pixel row for bars.
+	uint8_t width;  //!< Width, see item types.
+	uint8_t height;  //!< Height, see item types.
+	uint8_t style;  //!< Widget style flags.
+	uint8_t arg[4];  //!< Type specific arguments, see item types.
+	uint16_t range;  //!< Max value or scale multiplier, see item types.
+	char const CAL_PGM(* text);  //!< Label text or units in flash, or NULL.
+	void * state;  //!< Widget state in SRAM, or NULL.
+	void * buffer;  //!< Widget buffer in SRAM, or NULL.
+} LAYOUT_item_t;
+
+//! A complete layout, stored in flash.
+typedef struct LAYOUT_layout_struct
+{
+	LAYOUT_item_t const CAL_PGM(* items);  //!< Items in drawing order.
+	uint8_t itemCount;  //!< Number of items.
+	uint8_t signalCount;  //!< Highest bound signal ID plus one.
+	uint8_t const CAL_PGM(* signalStart);  //!< signalCount + 1 offsets into signalItems.
+	uint8_t const CAL_PGM(* signalItems);  //!< Item indexes grouped by signal ID.
+} LAYOUT_layout_t;
+
+
+
+/**********************
+ * Function prototypes
+ **********************/
+
+//! Initialize the states of all widgets in a layout. Does not draw anything.
+void LAYOUT_Init( LAYOUT_layout_t const CAL_PGM(* layout) );
+//! Draw all items, e.g. after screen has been cleared.
+void LAYOUT_Draw( LAYOUT_layout_t const CAL_PGM(* layout) );
+//! Clear a frame buffer of LCD_BUF_SIZE bytes and compose the labels into it.
+void LAYOUT_DrawStatic( LAYOUT_layout_t const CAL_PGM(* layout), uint8_t * buffer );
+//! Draw all widgets but no labels, e.g. after writing the static frame buffer to LCD.
+void LAYOUT_DrawDynamic( LAYOUT_layout_t const CAL_PGM(* layout) );
+//! Update all items bound to a signal with a new value.
+void LAYOUT_Update( LAYOUT_layout_t const CAL_PGM(* layout), uint8_t signal, int16_t value );
+//! Give all items bound to a signal a new value without drawing anything.
+void LAYOUT_Store( LAYOUT_layout_t const CAL_PGM(* layout), uint8_t signal, int16_t value );
+
+
+#endif
+// end of file
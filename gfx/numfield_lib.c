@@ -0,0 +1,239 @@
+// This file has been prepared for Doxygen automatic documentation generation.
+/*! \file *********************************************************************
+ *
+ * \brief  Numeric field renderer source file
+ *
+ *         See numfield_lib.h for a description of the field. Characters in
+ *         a field are indexed from the left, digits in the BCD buffer are
+ *         indexed from the least significant one.
+ *
+ *****************************************************************************/
+
+#include "numfield_lib.h"
+#include <lcd_lib.h>
+#include <termfont_lib.h>
+#include <stdbool.h>
+#include <string.h>
+
+
+
+/************************
+ * Constants and defines
+ ************************/
+
+#define NUMFIELD_BCD_BYTES 3  //!< Packed BCD bytes needed for a 16-bit value, 5 digits.
+#define NUMFIELD_BCD_DIGITS 5  //!< Maximum number of digits of a 16-bit value.
+
+
+
+/*******************************
+ * Internal function prototypes
+ *******************************/
+
+//! Convert binary value into packed BCD, least significant digit pair first.
+static void NUMFIELD_ToBCD( uint16_t value, uint8_t * bcd );
+
+
+
+/***************************
+ * Function implementations
+ ***************************/
+
+/*!
+ * \param  field     Field state to initialize
+ * \param  page      LCD page to draw on
+ * \param  column    Leftmost column of field
+ * \param  width     Characters for number, sign and decimal point included, max NUMFIELD_MAX_WIDTH
+ * \param  decimals  Number of digits after the decimal point
+ * \param  flags     Combination of NUMFIELD_ALIGN_* and NUMFIELD_ZERO_PAD
+ * \param  units     Unit text in flash drawn right after the number, or NULL
+ */
+void NUMFIELD_Init( NUMFIELD_field_t * field, uint8_t page, uint8_t column, uint8_t width, uint8_t decimals, uint8_t flags, char const CAL_PGM(* units) )
+{
+	if (width > NUMFIELD_MAX_WIDTH) {
+		width = NUMFIELD_MAX_WIDTH;
+	}
+
+	field->page = page;
+	field->column = column;
+	field->width = width;
+	field->decimals = decimals;
+	field->flags = flags;
+	field->scaleMul = 1;
+	field->scaleShift = 0;
+	field->value = 0;
+	field->units = units;
+	memset( field->drawn, 0x00, NUMFIELD_MAX_WIDTH );
+}
+
+
+/*!
+ *  Use a power of two as divisor to keep updates free of divisions, e.g.
+ *  mul = 1, shift = 1 for a value given in 0.5 units per LSB.
+ */
+void NUMFIELD_SetScale( NUMFIELD_field_t * field, uint16_t mul, uint8_t shift )
+{
+	field->scaleMul = mul;
+	field->scaleShift = shift;
+}
+
+
+/*!
+ *  The scaled value is shown with at least one digit before the decimal
+ *  point. If the result does not fit in the field, the whole field is
+ *  filled with NUMFIELD_OVERFLOW_CHAR.
+ *
+ * \param  field  Field giving format
+ * \param  value  Unscaled value to format
+ * \param  text   Buffer receiving field width characters, not terminated
+ */
+void NUMFIELD_Format( NUMFIELD_field_t const * field, int16_t value, char * text )
+{
+	uint8_t const width = field->width;
+	uint8_t const decimals = field->decimals;
+
+	// Scale magnitude, the sign is handled separately and dropped for zero.
+	uint32_t magnitude = (value < 0) ? -(int32_t) value : value;
+	magnitude = (magnitude * field->scaleMul) >> field->scaleShift;
+	bool const negative = (value < 0) && (magnitude != 0);
+
+	uint8_t bcd[NUMFIELD_BCD_BYTES];
+	uint8_t digits = 0;
+	if (magnitude <= 0xFFFF) {
+		NUMFIELD_ToBCD( magnitude, bcd );
+
+		// Count significant digits, but show at least one before the point.
+		digits = NUMFIELD_BCD_DIGITS;
+		while ((digits > (decimals + 1))
+		       && (((bcd[(digits - 1) >> 1] >> (((digits - 1) & 0x01) << 2)) & 0x0F) == 0)) {
+			--digits;
+		}
+	}
+
+	// Check that digits, decimal point and sign fit.
+	uint8_t length = digits;
+	if (decimals != 0) { ++length; }
+	if (negative) { ++length; }
+	if ((digits == 0) || (digits < (decimals + 1)) || (length > width)) {
+		memset( text, NUMFIELD_OVERFLOW_CHAR, width );
+		return;
+	}
+
+	// Place number and padding.
+	uint8_t start = 0;
+	char pad = ' ';
+	if ((field->flags & NUMFIELD_ZERO_PAD) != 0x00) {
+		pad = '0';
+	}
+	if ((field->flags & NUMFIELD_ALIGN_LEFT) == 0x00) {
+		start = width - length;
+	}
+	memset( text, pad, width );
+
+	char * pos = text + start + length;
+	for (uint8_t digit = 0; digit < digits; ++digit) {
+		if ((digit == decimals) && (decimals != 0)) {
+			*--pos = '.';
+		}
+		*--pos = '0' + ((bcd[digit >> 1] >> ((digit & 0x01) << 2)) & 0x0F);
+	}
+
+	// Sign goes in front of zero padding, otherwise right before the digits.
+	if (negative) {
+		if (pad == '0') {
+			text[0] = '-';
+		} else {
+			*--pos = '-';
+		}
+	}
+
+	// Left aligned padding is always spaces.
+	if ((field->flags & NUMFIELD_ALIGN_LEFT) != 0x00) {
+		memset( text + length, ' ', width - length );
+	}
+}
+
+
+/*!
+ *  The unit text is only drawn here, as it never changes.
+ */
+void NUMFIELD_Draw( NUMFIELD_field_t * field )
+{
+	if (field->units != NULL) {
+		TERMFONT_DisplayString_F( field->units, field->page, field->column + field->width * TERMFONT_CHAR_WIDTH );
+	}
+
+	memset( field->drawn, 0x00, NUMFIELD_MAX_WIDTH );
+	NUMFIELD_Update( field, field->value );
+}
+
+
+/*!
+ *  The new text is compared with the characters on the LCD. The span from
+ *  the first to the last changed character is rendered into a page buffer
+ *  and written with one LCD_WritePage call. Nothing is written if the text
+ *  did not change.
+ */
+void NUMFIELD_Update( NUMFIELD_field_t * field, int16_t value )
+{
+	field->value = value;
+
+	char text[NUMFIELD_MAX_WIDTH];
+	NUMFIELD_Format( field, value, text );
+
+	// Find span of changed characters.
+	uint8_t first = 0;
+	uint8_t last = field->width;
+	while ((first < last) && (text[first] == field->drawn[first])) {
+		++first;
+	}
+	if (first == last) {
+		return;
+	}
+	while (text[last - 1] == field->drawn[last - 1]) {
+		--last;
+	}
+
+	uint8_t pageBuffer[NUMFIELD_MAX_WIDTH * TERMFONT_CHAR_WIDTH];
+	uint8_t * pPageBuffer = pageBuffer;
+	for (uint8_t index = first; index < last; ++index) {
+		TERMFONT_DisplayPageBufferChar( pPageBuffer, text[index] );
+		pPageBuffer += TERMFONT_CHAR_WIDTH;
+		field->drawn[index] = text[index];
+	}
+
+	LCD_WritePage( pageBuffer, field->page, field->column + first * TERMFONT_CHAR_WIDTH, (last - first) * TERMFONT_CHAR_WIDTH );
+}
+
+
+void NUMFIELD_SetValue( NUMFIELD_field_t * field, int16_t value )
+{
+	field->value = value;
+}
+
+
+/*!
+ *  Shift-and-add-3: before each shift, every BCD digit of 5 or more gets 3
+ *  added so that it carries correctly into the next digit when doubled.
+ */
+static void NUMFIELD_ToBCD( uint16_t value, uint8_t * bcd )
+{
+	bcd[0] = 0;
+	bcd[1] = 0;
+	bcd[2] = 0;
+
+	for (uint8_t bit = 16; bit != 0; --bit) {
+		for (uint8_t index = 0; index < NUMFIELD_BCD_BYTES; ++index) {
+			if ((bcd[index] & 0x0F) >= 0x05) { bcd[index] += 0x03; }
+			if ((bcd[index] & 0xF0) >= 0x50) { bcd[index] += 0x30; }
+		}
+
+		bcd[2] = (bcd[2] << 1) | (bcd[1] >> 7);
+		bcd[1] = (bcd[1] << 1) | (bcd[0] >> 7);
+		bcd[0] = (bcd[0] << 1) | (uint8_t) (value >> 15);
+		value <<= 1;
+	}
+}
+
+
+// end of file
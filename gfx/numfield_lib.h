@@ -0,0 +1,80 @@
+// This file has been prepared for Doxygen automatic documentation generation.
+/*! \file *********************************************************************
+ *
+ * \brief  Numeric field renderer header file
+ *
+ *         A numeric field shows a fixed-point value with a given number of
+ *         decimals in a fixed number of terminal font characters, followed
+ *         by an optional unit text. The field remembers which characters
+ *         are on the LCD, so an update only writes the span of characters
+ *         that actually changed, as one page write.
+ *
+ *         Values are converted to decimal with the shift-and-add-3 (double
+ *         dabble) method, so formatting does not need any division. An
+ *         optional scale factor raw * mul / 2^shift can be given to convert
+ *         raw units, e.g. 0.5 % per LSB, to display units.
+ *
+ *****************************************************************************/
+#ifndef NUMFIELD_LIB_H
+#define NUMFIELD_LIB_H
+
+#include <stdint.h>
+#include <cal.h>
+
+
+
+/************************
+ * Constants and defines
+ ************************/
+
+#define NUMFIELD_MAX_WIDTH 8  //!< Maximum number of characters in a field, sign and decimal point included.
+
+#define NUMFIELD_ALIGN_RIGHT 0x00    //!< Right-align number in field, pad with spaces on the left.
+#define NUMFIELD_ALIGN_LEFT  (1<<0)  //!< Left-align number in field, pad with spaces on the right.
+#define NUMFIELD_ZERO_PAD    (1<<1)  //!< Right-align and pad with zeros instead of spaces.
+
+#define NUMFIELD_OVERFLOW_CHAR '#'  //!< Field is filled with this when the value does not fit.
+
+
+
+/*********************
+ * Types and typedefs
+ *********************/
+
+//! State of one numeric field. Initialize with NUMFIELD_Init, do not modify directly.
+typedef struct NUMFIELD_field_struct
+{
+	uint8_t page;  //!< LCD page of field.
+	uint8_t column;  //!< Leftmost column of field.
+	uint8_t width;  //!< Number of characters for the number, units not included.
+	uint8_t decimals;  //!< Number of digits after the decimal point.
+	uint8_t flags;  //!< Combination of NUMFIELD_ALIGN_* and NUMFIELD_ZERO_PAD.
+	uint8_t scaleShift;  //!< Scaled value is (value * scaleMul) >> scaleShift.
+	uint16_t scaleMul;  //!< Scale multiplier, see scaleShift.
+	int16_t value;  //!< Last value given to NUMFIELD_Update, unscaled.
+	char const CAL_PGM(* units);  //!< Unit text in flash drawn after the number, or NULL.
+	char drawn[NUMFIELD_MAX_WIDTH];  //!< Characters currently on LCD, 0 if unknown.
+} NUMFIELD_field_t;
+
+
+
+/**********************
+ * Function prototypes
+ **********************/
+
+//! Initialize field state with unity scale. Does not draw anything.
+void NUMFIELD_Init( NUMFIELD_field_t * field, uint8_t page, uint8_t column, uint8_t width, uint8_t decimals, uint8_t flags, char const CAL_PGM(* units) );
+//! Set scale factor so that displayed value is (value * mul) >> shift.
+void NUMFIELD_SetScale( NUMFIELD_field_t * field, uint16_t mul, uint8_t shift );
+//! Format a value as it would be shown in the field. Text gets field width characters, not terminated.
+void NUMFIELD_Format( NUMFIELD_field_t const * field, int16_t value, char * text );
+//! Draw units and complete number, e.g. after screen has been cleared.
+void NUMFIELD_Draw( NUMFIELD_field_t * field );
+//! Set new value and redraw only the characters that changed.
+void NUMFIELD_Update( NUMFIELD_field_t * field, int16_t value );
+//! Set new value without drawing, e.g. while field is not on screen. Shown on next NUMFIELD_Draw.
+void NUMFIELD_SetValue( NUMFIELD_field_t * field, int16_t value );
+
+
+#endif
+// end of file
@@ -9,6 +9,11 @@
  *      previously on screen. The library takes care of centering the box on
  *      screen and wrapping the text over several lines.
  *
+ *      A popup can also be opened as an overlay, which returns at once. The
+ *      LCD area under the box is saved to a memory block first and written
+ *      back when the overlay is closed, so the screen below is not redrawn.
+ *      The application must not draw under an open overlay.
+ *
  * \par Application note:
  *      AVR482: DB101 Software
  *
@@ -55,6 +60,29 @@
 #include <termfont_lib.h>
 #include <joystick_driver.h>
 #include <power_driver.h>
+#include <memblock_lib.h>
+#include <stddef.h>
+
+
+
+/********************
+ * Private variables
+ ********************/
+
+static POPUP_overlay_t * POPUP_activeOverlay = NULL;  //!< Overlay owning the joystick, if any.
+
+
+
+/*******************************
+ * Internal function prototypes
+ *******************************/
+
+//! Calculate LCD area covered by popup box, frame and shadow included.
+static void POPUP_GetBoxArea( uint8_t widthInChars, uint8_t heightInPages, uint8_t margin, uint8_t * firstColumn, uint8_t * width, uint8_t * firstPage, uint8_t * pageCount );
+//! Draw popup box with text centered on screen.
+static void POPUP_DrawBox( uint8_t widthInChars, uint8_t heightInPages, uint8_t margin, char const * str );
+//! Joystick handler used while an overlay is open.
+static void POPUP_OverlayJoystickHandler( JOYSTICK_event_t const * event );
 
 
 
@@ -79,7 +107,134 @@ void POPUP_MsgBox( uint8_t widthInChars, uint8_t heightInPages, uint8_t margin,
 	if (parentForm != NULL) {
 		FORMS_NormalizeLCDScroll( parentForm );
 	}
-	
+
+	POPUP_DrawBox( widthInChars, heightInPages, margin, str );
+
+	// Wait until joystick is released (could still be held down after select a menu item).
+	while (JOYSTICK_GetState() != 0x00) { POWER_EnterIdleSleepMode(); }
+	// Wait until joystick is pressed (user wants to exit popup box).
+	while (JOYSTICK_GetState() == 0x00) { POWER_EnterIdleSleepMode(); }
+	// Wait until joystick is released again (in order not to give unwanted joystick events to the calling application).
+	while (JOYSTICK_GetState() != 0x00) { POWER_EnterIdleSleepMode(); }
+
+	// Redraw parent form if requested.
+	if (parentForm != NULL) {
+		FORMS_Draw( parentForm );
+	}
+}
+
+
+/*!
+ * Opens a popup box like POPUP_MsgBox, but returns as soon as it is drawn.
+ * The overlay takes over the joystick until closed, so the application
+ * below does not react to the click that dismisses it. Only one overlay
+ * can be open at a time.
+ *
+ * \param  widthInChars   How wide in chars you want the text in the box to be
+ * \param  heightInPages  How high you want the box to be in pages
+ * \param  margin         Number of pixels between the text and the sides of the box
+ * \param  str            Pointer to a null-terminated string. Supports LF and CR.
+ * \param  timeout        Ticks until the overlay is dismissed, 0 to wait for joystick only
+ *
+ * \return  Overlay handle, or NULL if another overlay is open or memory is short
+ */
+POPUP_overlay_t * POPUP_OpenOverlay( uint8_t widthInChars, uint8_t heightInPages, uint8_t margin, char const * str, TIMING_time_t timeout )
+{
+	if (POPUP_activeOverlay != NULL) {
+		return NULL;
+	}
+
+	uint8_t firstColumn, width, firstPage, pageCount;
+	POPUP_GetBoxArea( widthInChars, heightInPages, margin, &firstColumn, &width, &firstPage, &pageCount );
+
+	POPUP_overlay_t * overlay = MEMBLOCK_Allocate( sizeof(POPUP_overlay_t) + (uint16_t) width * pageCount );
+	if (overlay == NULL) {
+		return NULL;
+	}
+	overlay->firstColumn = firstColumn;
+	overlay->width = width;
+	overlay->firstPage = firstPage;
+	overlay->pageCount = pageCount;
+	overlay->dismissCount = 0;
+
+	// Save only the pages and columns the box covers.
+	uint8_t * pSaveUnder = overlay->saveUnder;
+	for (uint8_t page = 0; page < pageCount; ++page) {
+		LCD_ReadPage( pSaveUnder, firstPage + page, firstColumn, width );
+		pSaveUnder += width;
+	}
+
+	POPUP_DrawBox( widthInChars, heightInPages, margin, str );
+
+	uint8_t const storedSREG = SREG;
+	CAL_disable_interrupt();
+	POPUP_activeOverlay = overlay;
+	overlay->oldJoystickHandler = JOYSTICK_GetEventHandler();
+	JOYSTICK_SetEventHandler( POPUP_OverlayJoystickHandler );
+	SREG = storedSREG;
+
+	if (timeout != 0) {
+		TIMING_AddCounterEventAfter( timeout, &overlay->dismissCount, &overlay->timeoutEvent );
+	}
+
+	return overlay;
+}
+
+
+bool POPUP_ServiceOverlay( POPUP_overlay_t * overlay )
+{
+	if (overlay->dismissCount == 0) {
+		return false;
+	}
+	POPUP_CloseOverlay( overlay );
+	return true;
+}
+
+
+/*!
+ * The handle is invalid after this call.
+ */
+void POPUP_CloseOverlay( POPUP_overlay_t * overlay )
+{
+	uint8_t const storedSREG = SREG;
+	CAL_disable_interrupt();
+	JOYSTICK_SetEventHandler( overlay->oldJoystickHandler );
+	POPUP_activeOverlay = NULL;
+	SREG = storedSREG;
+	TIMING_RemoveEvent( &overlay->timeoutEvent );
+
+	uint8_t const * pSaveUnder = overlay->saveUnder;
+	for (uint8_t page = 0; page < overlay->pageCount; ++page) {
+		LCD_WritePage( pSaveUnder, overlay->firstPage + page, overlay->firstColumn, overlay->width );
+		pSaveUnder += overlay->width;
+	}
+
+	MEM_FREE( overlay );
+}
+
+
+/*!
+ * Same geometry as used by POPUP_DrawBox. The shadow reaches one pixel
+ * right of and below the frame.
+ */
+static void POPUP_GetBoxArea( uint8_t widthInChars, uint8_t heightInPages, uint8_t margin, uint8_t * firstColumn, uint8_t * width, uint8_t * firstPage, uint8_t * pageCount )
+{
+	uint8_t const widthInPixels = widthInChars * TERMFONT_CHAR_WIDTH;
+	uint8_t const startX = (LCD_WIDTH / 2) - (widthInPixels / 2) - margin;
+	uint8_t const endX = (LCD_WIDTH / 2) + (widthInPixels / 2) + margin + 1;
+	uint8_t const startPage = (LCD_HEIGHT / LCD_PAGE_HEIGHT / 2) - 1 - ((heightInPages - 1) / 2);
+	uint8_t const startY = (startPage * LCD_PAGE_HEIGHT) - margin;
+	uint8_t const endY = ((startPage + heightInPages) * LCD_PAGE_HEIGHT) + margin + 1;
+
+	*firstColumn = startX;
+	*width = ((endX < LCD_WIDTH) ? endX : (LCD_WIDTH - 1)) - startX + 1;
+	*firstPage = startY / LCD_PAGE_HEIGHT;
+	*pageCount = ((endY < LCD_HEIGHT) ? endY : (LCD_HEIGHT - 1)) / LCD_PAGE_HEIGHT - *firstPage + 1;
+}
+
+
+static void POPUP_DrawBox( uint8_t widthInChars, uint8_t heightInPages, uint8_t margin, char const * str )
+{
 	// Calculate some coordinates, with text centered in screen.
 	uint8_t const widthInPixels = widthInChars * TERMFONT_CHAR_WIDTH;
 	uint8_t const startColumn = (LCD_WIDTH / 2) - (widthInPixels / 2);
@@ -120,17 +275,17 @@ void POPUP_MsgBox( uint8_t widthInChars, uint8_t heightInPages, uint8_t margin,
 		}
 		++str;
 	}
-	
-	// Wait until joystick is released (could still be held down after select a menu item).
-	while (JOYSTICK_GetState() != 0x00) { POWER_EnterIdleSleepMode(); }
-	// Wait until joystick is pressed (user wants to exit popup box).
-	while (JOYSTICK_GetState() == 0x00) { POWER_EnterIdleSleepMode(); }
-	// Wait until joystick is released again (in order not to give unwanted joystick events to the calling application).
-	while (JOYSTICK_GetState() != 0x00) { POWER_EnterIdleSleepMode(); }
+}
 
-	// Redraw parent form if requested.
-	if (parentForm != NULL) {
-		FORMS_Draw( parentForm );
+
+/*!
+ * Runs in interrupt context, so it only counts the click. Events are not
+ * passed on to the old handler while the overlay is open.
+ */
+static void POPUP_OverlayJoystickHandler( JOYSTICK_event_t const * event )
+{
+	if ((event->clicked != 0x00) && (POPUP_activeOverlay != NULL)) {
+		++POPUP_activeOverlay->dismissCount;
 	}
 }
 
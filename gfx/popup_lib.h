@@ -9,6 +9,11 @@
  *      previously on screen. The library takes care of centering the box on
  *      screen and wrapping the text over several lines.
  *
+ *      A popup can also be opened as an overlay, which returns at once. The
+ *      LCD area under the box is saved to a memory block first and written
+ *      back when the overlay is closed, so the screen below is not redrawn.
+ *      The application must not draw under an open overlay.
+ *
  * \par Application note:
  *      AVR482: DB101 Software
  *
@@ -55,7 +60,28 @@
 
 
 #include <forms_lib.h>
+#include <timing_lib.h>
+#include <joystick_driver.h>
 #include <stdint.h>
+#include <stdbool.h>
+
+
+/*********************
+ * Types and typedefs
+ *********************/
+
+//! An open popup overlay. Created by POPUP_OpenOverlay, do not modify directly.
+typedef struct POPUP_overlay_struct
+{
+	uint8_t firstColumn;  //!< Leftmost LCD column of saved area.
+	uint8_t width;  //!< Width of saved area in columns.
+	uint8_t firstPage;  //!< Top LCD page of saved area.
+	uint8_t pageCount;  //!< Height of saved area in pages.
+	TIMING_event_t timeoutEvent;  //!< Timing event for automatic dismissal.
+	TIMING_counter_t volatile dismissCount;  //!< Incremented by timeout and joystick clicks.
+	JOYSTICK_EventHandler_t oldJoystickHandler;  //!< Handler to restore on close.
+	uint8_t saveUnder[];  //!< Saved LCD area, pageCount rows of width bytes, top page first.
+} POPUP_overlay_t;
 
 
 /**********************
@@ -64,6 +90,12 @@
 
 //! Display a popup box, wait for joystick event, redraw parent form if any.
 void POPUP_MsgBox( uint8_t widthInChars, uint8_t heightInPages, uint8_t margin, char const * str, FORMS_form_t * parentForm );
+//! Save the area under a popup box, draw the box and return at once. Returns NULL if it cannot be opened.
+POPUP_overlay_t * POPUP_OpenOverlay( uint8_t widthInChars, uint8_t heightInPages, uint8_t margin, char const * str, TIMING_time_t timeout );
+//! Close overlay if dismissed by joystick or timeout. Returns true if closed. Call from main loop.
+bool POPUP_ServiceOverlay( POPUP_overlay_t * overlay );
+//! Close overlay now, restoring the area under it.
+void POPUP_CloseOverlay( POPUP_overlay_t * overlay );
 
 
 #endif
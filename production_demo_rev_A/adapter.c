@@ -0,0 +1,473 @@
+// This file has been prepared for Doxygen automatic documentation generation.
+/*! \file *********************************************************************
+ *
+ * \brief  CAN adapter link source file
+ *
+ *         Deadlines are compared with TIMING_GetTime, so no timing events
+ *         are needed and nothing runs in interrupt context. Commands are
+ *         only written from ADAPTER_Task and answers handled as they are
+ *         parsed, both from the main loop.
+ *
+ *         Answers that arrive after their command timed out are taken as
+ *         answers to whatever is pending then. That is harmless, at worst
+ *         one more bring-up attempt.
+ *
+ *         When a command gets no answer at all, the link speed is switched
+ *         between ADAPTER_BAUD and ADAPTER_FAST_BAUD for the next attempt,
+ *         so a display restarted while the adapter stays at the fast speed
+ *         finds it again.
+ *
+ *****************************************************************************/
+
+#include "adapter.h"
+#include <cal.h>
+#include <stddef.h>
+#include <string.h>
+#include <can_lib.h>
+#include <slcan_lib.h>
+#include <canbin_lib.h>
+#include <canstat_lib.h>
+#include <icon_lib.h>
+
+#include "dashboard.h"
+
+
+
+/********************************
+ * Private constants and defines
+ ********************************/
+
+#define ADAPTER_STEP_OPTIONAL  (1<<0)  //!< BELL answer is accepted.
+#define ADAPTER_STEP_NO_ANSWER (1<<1)  //!< Answers are not checked, wait ADAPTER_WAKE_TIME.
+#define ADAPTER_STEP_FAST_BAUD (1<<2)  //!< Switch to ADAPTER_FAST_BAUD when acknowledged.
+#define ADAPTER_STEP_BINARY    (1<<3)  //!< Switch to binary records when acknowledged.
+#define ADAPTER_STEP_PUT_CODE  (1<<4)  //!< Command takes the acceptance filter code.
+#define ADAPTER_STEP_PUT_MASK  (1<<5)  //!< Command takes the acceptance filter mask.
+
+#define ADAPTER_FILTER_DIGITS 8  //!< Hex digits of acceptance filter code and mask.
+
+//! Bring-up steps, in order.
+enum ADAPTER_step_enum
+{
+	ADAPTER_STEP_WAKE,  //!< End any partial command line.
+	ADAPTER_STEP_TEXT,  //!< Leave binary records, in case a bridge is still sending them.
+	ADAPTER_STEP_CLOSE,  //!< Close channel, so it can be set up. First step of a reopen.
+	ADAPTER_STEP_VERSION,  //!< Ask version, to see the adapter answers at all.
+	ADAPTER_STEP_BAUD,  //!< Ask for faster link.
+	ADAPTER_STEP_AUTO_POLL,  //!< Send frames without polling.
+	ADAPTER_STEP_TIMESTAMPS,  //!< Add timestamps to frames.
+	ADAPTER_STEP_BITRATE,  //!< 500 kbit/s.
+	ADAPTER_STEP_CODE,  //!< Acceptance filter code.
+	ADAPTER_STEP_MASK,  //!< Acceptance filter mask.
+	ADAPTER_STEP_OPEN,  //!< Open channel.
+	ADAPTER_STEP_RECORDS,  //!< Ask for binary records, last since a bridge then hides answers.
+	ADAPTER_STEP_COUNT  //!< Number of steps.
+};
+
+
+
+/*********************
+ * Types and typedefs
+ *********************/
+
+//! One bring-up step, stored in flash.
+typedef struct ADAPTER_step_struct
+{
+	char const CAL_PGM(* command);  //!< Command line to send.
+	uint8_t flags;  //!< Combination of ADAPTER_STEP_* flags.
+} ADAPTER_step_t;
+
+
+
+/********************
+ * Private variables
+ ********************/
+
+static char const CAL_PGM_DEF(ADAPTER_txtWake[]) = "\r\r";  //!< Wake up command.
+static char const CAL_PGM_DEF(ADAPTER_txtText[]) = "B0\r";  //!< Leave binary records command.
+static char const CAL_PGM_DEF(ADAPTER_txtClose[]) = "C\r";  //!< Close channel command.
+static char const CAL_PGM_DEF(ADAPTER_txtVersion[]) = "V\r";  //!< Version command.
+static char const CAL_PGM_DEF(ADAPTER_txtBaud[]) = "U1\r";  //!< Link speed command, 1 is 115200 baud.
+static char const CAL_PGM_DEF(ADAPTER_txtAutoPoll[]) = "X1\r";  //!< Auto poll command.
+static char const CAL_PGM_DEF(ADAPTER_txtTimestamps[]) = "Z1\r";  //!< Timestamp command.
+static char const CAL_PGM_DEF(ADAPTER_txtBitrate[]) = "S6\r";  //!< Bit rate command, 6 is 500 kbit/s.
+static char const CAL_PGM_DEF(ADAPTER_txtCode[]) = "M";  //!< Acceptance code command, digits and CR added.
+static char const CAL_PGM_DEF(ADAPTER_txtMask[]) = "m";  //!< Acceptance mask command, digits and CR added.
+static char const CAL_PGM_DEF(ADAPTER_txtOpen[]) = "O\r";  //!< Open channel command.
+static char const CAL_PGM_DEF(ADAPTER_txtRecords[]) = CANBIN_REQUEST;  //!< Binary records command.
+static char const CAL_PGM_DEF(ADAPTER_txtStatus[]) = "F\r";  //!< Status flags command.
+
+//! Bring-up steps.
+static ADAPTER_step_t const CAL_PGM_DEF(ADAPTER_steps[ADAPTER_STEP_COUNT]) = {
+	[ADAPTER_STEP_WAKE]       = { ADAPTER_txtWake, ADAPTER_STEP_NO_ANSWER },
+	[ADAPTER_STEP_TEXT]       = { ADAPTER_txtText, ADAPTER_STEP_OPTIONAL },
+	[ADAPTER_STEP_CLOSE]      = { ADAPTER_txtClose, ADAPTER_STEP_OPTIONAL },
+	[ADAPTER_STEP_VERSION]    = { ADAPTER_txtVersion, 0x00 },
+	[ADAPTER_STEP_BAUD]       = { ADAPTER_txtBaud, ADAPTER_STEP_OPTIONAL | ADAPTER_STEP_FAST_BAUD },
+	[ADAPTER_STEP_AUTO_POLL]  = { ADAPTER_txtAutoPoll, ADAPTER_STEP_OPTIONAL },
+	[ADAPTER_STEP_TIMESTAMPS] = { ADAPTER_txtTimestamps, ADAPTER_STEP_OPTIONAL },
+	[ADAPTER_STEP_BITRATE]    = { ADAPTER_txtBitrate, 0x00 },
+	[ADAPTER_STEP_CODE]       = { ADAPTER_txtCode, ADAPTER_STEP_OPTIONAL | ADAPTER_STEP_PUT_CODE },
+	[ADAPTER_STEP_MASK]       = { ADAPTER_txtMask, ADAPTER_STEP_OPTIONAL | ADAPTER_STEP_PUT_MASK },
+	[ADAPTER_STEP_OPEN]       = { ADAPTER_txtOpen, 0x00 },
+	[ADAPTER_STEP_RECORDS]    = { ADAPTER_txtRecords, ADAPTER_STEP_OPTIONAL | ADAPTER_STEP_BINARY }
+};
+
+static SLCAN_parser_t ADAPTER_slcanParser;  //!< Parser for SLCAN lines.
+static CANBIN_parser_t ADAPTER_canbinParser;  //!< Parser for binary records.
+static bool ADAPTER_binary;  //!< True if frames arrive as binary records.
+
+static ADAPTER_state_t ADAPTER_state;  //!< Link state.
+static uint8_t ADAPTER_step;  //!< Bring-up step to send or being answered.
+static TIMING_time_t ADAPTER_deadline;  //!< When to send, or when the answer is late.
+static TIMING_time_t ADAPTER_backoff;  //!< Delay before next attempt after a failure.
+static TIMING_time_t ADAPTER_lastFrame;  //!< Time of last frame or of channel open.
+static bool ADAPTER_statusPending;  //!< Waiting for answer to status poll.
+static ADAPTER_stats_t ADAPTER_stats;  //!< Link statistics.
+
+
+
+/*******************************
+ * Internal function prototypes
+ *******************************/
+
+//! Return true if the deadline has passed.
+static bool ADAPTER_IsDue( TIMING_time_t now );
+//! Send a command line from flash.
+static void ADAPTER_Send( char const CAL_PGM(* command) );
+//! Send a 32-bit value as hex digits.
+static void ADAPTER_SendHex( uint32_t value );
+//! Start bring-up at the given step, now.
+static void ADAPTER_Start( uint8_t step );
+//! Send the current bring-up step.
+static void ADAPTER_SendStep( TIMING_time_t now );
+//! Handle an answer from the adapter.
+static void ADAPTER_Answer( SLCAN_result_t result );
+//! Go on with the next bring-up step, or start running after the last.
+static void ADAPTER_NextStep( void );
+//! Give up this attempt and try again after the back-off delay.
+static void ADAPTER_Fail( bool answered );
+//! Note a received frame and hand it to its handler.
+static void ADAPTER_Frame( uint8_t route, CAN_frame_t const * frame );
+//! Add one to a statistics counter without wrapping.
+static void ADAPTER_Count( uint16_t * counter );
+
+
+
+/***************************
+ * Function implementations
+ ***************************/
+
+void ADAPTER_Init( void )
+{
+	UART_Init( ADAPTER_BAUD );
+	SLCAN_Init( &ADAPTER_slcanParser );
+	SLCAN_SetRouteFinder( &ADAPTER_slcanParser, CAN_FindRoute );
+	CANBIN_Init( &ADAPTER_canbinParser );
+	CANBIN_SetRouteFinder( &ADAPTER_canbinParser, CAN_FindRoute );
+
+	memset( &ADAPTER_stats, 0x00, sizeof(ADAPTER_stats) );
+	CAN_ComputeFilter( &ADAPTER_stats.filter );
+	CANSTAT_Init( ADAPTER_BITRATE, ADAPTER_GetMilliseconds() );
+	ADAPTER_backoff = ADAPTER_MIN_BACKOFF;
+	ADAPTER_Start( ADAPTER_STEP_WAKE );
+}
+
+
+/*!
+ *  Frames are handed to their handler in the CAN dispatch table as soon as
+ *  they are complete. Frames may arrive during bring-up too, e.g. from an
+ *  adapter that opened the channel by itself at power up. Every complete
+ *  line or record is counted in the traffic statistics.
+ *
+ * \param  data  Byte received from the adapter
+ */
+void ADAPTER_ProcessByte( uint8_t data )
+{
+	if (ADAPTER_binary) {
+		switch (CANBIN_ProcessByte( &ADAPTER_canbinParser, data )) {
+			case CANBIN_FRAME:
+				ADAPTER_Frame( ADAPTER_canbinParser.route, &ADAPTER_canbinParser.frame );
+				break;
+
+			case CANBIN_ERROR:
+				CANSTAT_ParseError();
+				break;
+
+			case CANBIN_FILTERED:
+				CANSTAT_Unknown( &ADAPTER_canbinParser.frame, ADAPTER_GetMilliseconds() );
+				break;
+
+			default:
+				break;
+		}
+		return;
+	}
+
+	SLCAN_result_t const result = SLCAN_ProcessByte( &ADAPTER_slcanParser, data );
+	switch (result) {
+		case SLCAN_FRAME:
+			ADAPTER_Frame( ADAPTER_slcanParser.route, &ADAPTER_slcanParser.frame );
+			break;
+
+		case SLCAN_OK:
+		case SLCAN_NACK:
+		case SLCAN_RESPONSE:
+			CANSTAT_Response();
+			ADAPTER_Answer( result );
+			break;
+
+		case SLCAN_ERROR:
+			CANSTAT_ParseError();
+			break;
+
+		case SLCAN_FILTERED:
+			CANSTAT_Unknown( &ADAPTER_slcanParser.frame, ADAPTER_GetMilliseconds() );
+			break;
+
+		default:
+			break;
+	}
+}
+
+
+void ADAPTER_Task( void )
+{
+	TIMING_time_t const now = TIMING_GetTime();
+
+	switch (ADAPTER_state) {
+		case ADAPTER_STATE_WAIT:
+			if (ADAPTER_IsDue( now )) {
+				ADAPTER_SendStep( now );
+			}
+			break;
+
+		case ADAPTER_STATE_ANSWER:
+			if (ADAPTER_IsDue( now )) {
+				ADAPTER_Count( &ADAPTER_stats.timeouts );
+				ADAPTER_Fail( false );
+			}
+			break;
+
+		default:
+			// Binary records carry no status, so only silence tells the link is gone.
+			if (ADAPTER_binary) {
+				if ((now - ADAPTER_lastFrame) > ADAPTER_SILENCE_TIMEOUT) {
+					ADAPTER_Count( &ADAPTER_stats.silences );
+					ADAPTER_Start( ADAPTER_STEP_WAKE );
+				}
+			} else if (ADAPTER_IsDue( now )) {
+				if (ADAPTER_statusPending) {
+					ADAPTER_Count( &ADAPTER_stats.timeouts );
+					ADAPTER_Start( ADAPTER_STEP_WAKE );
+				} else {
+					ADAPTER_Send( ADAPTER_txtStatus );
+					ADAPTER_statusPending = true;
+					ADAPTER_deadline = now + ADAPTER_ANSWER_TIMEOUT;
+				}
+			}
+			break;
+	}
+}
+
+
+ADAPTER_state_t ADAPTER_GetState( void )
+{
+	return ADAPTER_state;
+}
+
+
+bool ADAPTER_IsBinary( void )
+{
+	return ADAPTER_binary;
+}
+
+
+void ADAPTER_GetStats( ADAPTER_stats_t * stats )
+{
+	*stats = ADAPTER_stats;
+}
+
+
+/*!
+ *  With RTC_TICKS_PER_SECOND at 128, a tick is 125 / 16 ms. The ticks are
+ *  split into 16s and the rest, so the product loses no bits and the
+ *  result wraps at 2^32 ms, about 49 days, which statistics built on
+ *  differences do not notice. Only the wrap of the ticks themselves,
+ *  after about a year, makes the result jump.
+ */
+uint32_t ADAPTER_GetMilliseconds( void )
+{
+	TIMING_time_t const ticks = TIMING_GetTime();
+	return (ticks >> 4) * 125 + (((ticks & 0x0F) * 125) >> 4);
+}
+
+
+static bool ADAPTER_IsDue( TIMING_time_t now )
+{
+	return (int32_t) (now - ADAPTER_deadline) >= 0;
+}
+
+
+static void ADAPTER_Send( char const CAL_PGM(* command) )
+{
+	char ch;
+	while ((ch = CAL_pgm_read_char( command++ )) != '\0') {
+		UART_PutChar( ch );
+	}
+}
+
+
+static void ADAPTER_SendHex( uint32_t value )
+{
+	for (uint8_t digit = ADAPTER_FILTER_DIGITS; digit != 0; --digit) {
+		uint8_t const nibble = (value >> 28) & 0x0F;
+		UART_PutChar( (nibble < 10) ? ('0' + nibble) : ('A' - 10 + nibble) );
+		value <<= 4;
+	}
+}
+
+
+/*!
+ *  Frames are taken as SLCAN lines again until binary records have been
+ *  asked for, and the link counts as silent until the channel is open.
+ */
+static void ADAPTER_Start( uint8_t step )
+{
+	ADAPTER_Count( &ADAPTER_stats.attempts );
+	ADAPTER_binary = false;
+	ADAPTER_statusPending = false;
+	ADAPTER_step = step;
+	ADAPTER_state = ADAPTER_STATE_WAIT;
+	ADAPTER_deadline = TIMING_GetTime();
+}
+
+
+static void ADAPTER_SendStep( TIMING_time_t now )
+{
+	ADAPTER_step_t const CAL_PGM(* step) = &ADAPTER_steps[ADAPTER_step];
+	uint8_t const flags = CAL_pgm_read_byte( &step->flags );
+	ADAPTER_Send( (char const CAL_PGM(*)) CAL_pgm_read_pvoid( &step->command ) );
+	if ((flags & (ADAPTER_STEP_PUT_CODE | ADAPTER_STEP_PUT_MASK)) != 0x00) {
+		ADAPTER_SendHex( ((flags & ADAPTER_STEP_PUT_CODE) != 0x00) ? ADAPTER_stats.filter.code : ADAPTER_stats.filter.mask );
+		UART_PutChar( SLCAN_CR );
+	}
+
+	if ((flags & ADAPTER_STEP_NO_ANSWER) != 0x00) {
+		++ADAPTER_step;
+		ADAPTER_deadline = now + ADAPTER_WAKE_TIME;
+		return;
+	}
+	ADAPTER_state = ADAPTER_STATE_ANSWER;
+	ADAPTER_deadline = now + ADAPTER_ANSWER_TIMEOUT;
+}
+
+
+/*!
+ *  OK and response lines are positive answers, BELL negative. While
+ *  running, only the answer to the status poll is expected.
+ */
+static void ADAPTER_Answer( SLCAN_result_t result )
+{
+	if (ADAPTER_state == ADAPTER_STATE_RUNNING) {
+		if (ADAPTER_statusPending && (result == SLCAN_RESPONSE) && (ADAPTER_slcanParser.command == 'F')) {
+			ADAPTER_statusPending = false;
+			ADAPTER_deadline = TIMING_GetTime() + ADAPTER_STATUS_PERIOD;
+			if ((ADAPTER_slcanParser.value & ADAPTER_STATUS_BUS_ERROR) != 0x00) {
+				ADAPTER_Count( &ADAPTER_stats.reopens );
+				ADAPTER_Start( ADAPTER_STEP_CLOSE );
+			}
+		}
+		return;
+	}
+	if (ADAPTER_state != ADAPTER_STATE_ANSWER) {
+		return;
+	}
+
+	uint8_t const flags = CAL_pgm_read_byte( &ADAPTER_steps[ADAPTER_step].flags );
+	if (result == SLCAN_NACK) {
+		if ((flags & ADAPTER_STEP_OPTIONAL) == 0x00) {
+			ADAPTER_Count( &ADAPTER_stats.nacks );
+			ADAPTER_Fail( true );
+			return;
+		}
+	} else {
+		if (ADAPTER_step == ADAPTER_STEP_VERSION) {
+			ADAPTER_stats.version = ADAPTER_slcanParser.value;
+		}
+		if ((flags & ADAPTER_STEP_FAST_BAUD) != 0x00) {
+			UART_SetBaud( ADAPTER_FAST_BAUD );
+		}
+		if ((flags & ADAPTER_STEP_BINARY) != 0x00) {
+			CANBIN_Init( &ADAPTER_canbinParser );
+			CANBIN_SetRouteFinder( &ADAPTER_canbinParser, CAN_FindRoute );
+			ADAPTER_binary = true;
+		}
+	}
+	ADAPTER_NextStep();
+}
+
+
+static void ADAPTER_NextStep( void )
+{
+	TIMING_time_t const now = TIMING_GetTime();
+	ADAPTER_deadline = now;
+
+	if (++ADAPTER_step < ADAPTER_STEP_COUNT) {
+		ADAPTER_state = ADAPTER_STATE_WAIT;
+		return;
+	}
+
+	ADAPTER_state = ADAPTER_STATE_RUNNING;
+	ADAPTER_backoff = ADAPTER_MIN_BACKOFF;
+	ADAPTER_lastFrame = now;
+	ADAPTER_deadline = now + ADAPTER_STATUS_PERIOD;
+	if (ADAPTER_stats.openTime == 0) {
+		ADAPTER_stats.openTime = (now != 0) ? now : 1;
+	}
+	DASHBOARD_SetStatus( ICON_FAULT, ICON_HIDDEN );
+}
+
+
+/*!
+ *  The fault icon stays up until a bring-up succeeds.
+ *
+ * \param  answered  False if the adapter did not answer at all
+ */
+static void ADAPTER_Fail( bool answered )
+{
+	if (answered == false) {
+		UART_SetBaud( (UART_GetBaud() == ADAPTER_FAST_BAUD) ? ADAPTER_BAUD : ADAPTER_FAST_BAUD );
+	}
+	DASHBOARD_SetStatus( ICON_FAULT, ICON_SHOWN );
+
+	ADAPTER_Start( ADAPTER_STEP_WAKE );
+	ADAPTER_deadline += ADAPTER_backoff;
+	ADAPTER_backoff *= 2;
+	if (ADAPTER_backoff > ADAPTER_MAX_BACKOFF) {
+		ADAPTER_backoff = ADAPTER_MAX_BACKOFF;
+	}
+}
+
+
+static void ADAPTER_Frame( uint8_t route, CAN_frame_t const * frame )
+{
+	TIMING_time_t const now = TIMING_GetTime();
+	ADAPTER_lastFrame = now;
+	if (ADAPTER_stats.firstFrameTime == 0) {
+		ADAPTER_stats.firstFrameTime = (now != 0) ? now : 1;
+	}
+	CANSTAT_Frame( route, frame, ADAPTER_GetMilliseconds() );
+	CAN_Dispatch( route, frame );
+}
+
+
+static void ADAPTER_Count( uint16_t * counter )
+{
+	if (*counter != UINT16_MAX) {
+		++(*counter);
+	}
+}
+
+
+// end of file
@@ -0,0 +1,114 @@
+// This file has been prepared for Doxygen automatic documentation generation.
+/*! \file *********************************************************************
+ *
+ * \brief  CAN adapter link header file
+ *
+ *         Brings up the SLCAN adapter and feeds its frames to the CAN
+ *         dispatch table. Bring-up sends one command at a time from a table
+ *         in flash and checks the answer: wake up, leave binary records,
+ *         close, version, link speed, auto poll, timestamps, bit rate,
+ *         acceptance filter, open and binary records. A missing answer, or
+ *         BELL to a command that must succeed, starts again from the top
+ *         after a back-off delay that doubles with each failure. Nothing
+ *         waits, the main loop calls ADAPTER_Task and drawing goes on
+ *         meanwhile.
+ *
+ *         Once open, the adapter status flags are polled and the channel
+ *         is closed and opened again after a bus error. Since binary
+ *         records carry no status, a link that has been silent too long is
+ *         brought up again from the top.
+ *
+ *         The acceptance filter is computed from the CAN dispatch table by
+ *         CAN_ComputeFilter, so the adapter drops frames without a handler
+ *         before they take time on the serial link. How many IDs it lets
+ *         through against how many are handled is kept in the statistics.
+ *
+ *         The time of the first frame after power on is kept in the
+ *         statistics, to measure cold start latency. Every line or record
+ *         from the adapter is also counted by canstat_lib, per route for
+ *         frames, for the diagnostics page.
+ *
+ *****************************************************************************/
+#ifndef ADAPTER_H
+#define ADAPTER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <timing_lib.h>
+#include <rtc_driver.h>
+#include <uart_driver.h>
+#include <can_lib.h>
+
+
+
+/************************
+ * Constants and defines
+ ************************/
+
+#define ADAPTER_BAUD UART_BAUD_57600  //!< Adapter link speed at power up.
+#define ADAPTER_FAST_BAUD UART_BAUD_115200  //!< Adapter link speed asked for during bring-up.
+#define ADAPTER_BITRATE 500  //!< CAN bit rate set during bring-up, kbit/s.
+
+#define ADAPTER_ANSWER_TIMEOUT (RTC_TICKS_PER_SECOND / 4)  //!< Ticks to wait for an answer.
+#define ADAPTER_WAKE_TIME (RTC_TICKS_PER_SECOND / 10)  //!< Ticks for wake-up answers to arrive.
+#define ADAPTER_MIN_BACKOFF (RTC_TICKS_PER_SECOND / 4)  //!< Ticks before first retry.
+#define ADAPTER_MAX_BACKOFF (RTC_TICKS_PER_SECOND * 8)  //!< Longest ticks between retries.
+#define ADAPTER_STATUS_PERIOD RTC_TICKS_PER_SECOND  //!< Ticks between status polls.
+#define ADAPTER_SILENCE_TIMEOUT (RTC_TICKS_PER_SECOND * 5)  //!< Ticks without frames before bringing up again.
+
+#define ADAPTER_STATUS_BUS_ERROR (1<<7)  //!< Bus error bit in Lawicell status flags.
+
+//! Link states.
+enum ADAPTER_state_enum
+{
+	ADAPTER_STATE_WAIT,  //!< Waiting to send next bring-up command.
+	ADAPTER_STATE_ANSWER,  //!< Waiting for answer to bring-up command.
+	ADAPTER_STATE_RUNNING  //!< Channel open, frames flowing.
+};
+
+
+
+/*********************
+ * Types and typedefs
+ *********************/
+
+typedef uint8_t ADAPTER_state_t;  //!< One of ADAPTER_STATE_* states.
+
+//! Link statistics. Counters saturate instead of wrapping.
+typedef struct ADAPTER_stats_struct
+{
+	uint16_t attempts;  //!< Bring-ups started, including reopens.
+	uint16_t timeouts;  //!< Commands without answer.
+	uint16_t nacks;  //!< Commands that must succeed answered with BELL.
+	uint16_t reopens;  //!< Channel reopened after a bus error.
+	uint16_t silences;  //!< Bring-ups after binary records went silent.
+	uint16_t version;  //!< Adapter hardware and software version, 0 if unknown.
+	TIMING_time_t openTime;  //!< Ticks from timing start until channel first opened, 0 if not yet.
+	TIMING_time_t firstFrameTime;  //!< Ticks from timing start until first frame, 0 if none yet.
+	CAN_filter_t filter;  //!< Acceptance filter and its efficiency.
+} ADAPTER_stats_t;
+
+
+
+/**********************
+ * Function prototypes
+ **********************/
+
+//! Initialize link at ADAPTER_BAUD and start bring-up. Select the CAN dispatch table first.
+void ADAPTER_Init( void );
+//! Feed one byte received from the adapter.
+void ADAPTER_ProcessByte( uint8_t data );
+//! Send next command or handle timeouts when due. Call from main loop.
+void ADAPTER_Task( void );
+//! Get link state.
+ADAPTER_state_t ADAPTER_GetState( void );
+//! Return true if frames arrive as binary records.
+bool ADAPTER_IsBinary( void );
+//! Copy link statistics.
+void ADAPTER_GetStats( ADAPTER_stats_t * stats );
+//! Get local time in ms, as used for CAN traffic statistics.
+uint32_t ADAPTER_GetMilliseconds( void );
+
+
+#endif
+// end of file
@@ -52,7 +52,6 @@
  * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  *****************************************************************************/
 
-#include <math.h>
 #include <stdint.h>
 
 #include <cal.h>
@@ -60,6 +59,7 @@
 
 #include <lcd_lib.h>
 #include <gfx_lib.h>
+#include <gauge_lib.h>
 #include <joystick_driver.h>
 #include <termfont_lib.h>
 #include <rtc_driver.h>
@@ -81,17 +81,15 @@ static char const CAL_PGM_DEF(Clock_Text2[]) = "Clock Demo";
 
 
 
-static void Clock_ComputeDial( float angle, float iRadius, float oRadius, uint8_t * ixp, uint8_t * iyp, uint8_t * oxp, uint8_t * oyp )
+// Angle is a binary angle, 256 per full turn, see gauge_lib.h.
+static void Clock_ComputeDial( uint8_t angle, uint8_t iRadius, uint8_t oRadius, uint8_t * ixp, uint8_t * iyp, uint8_t * oxp, uint8_t * oyp )
 {
-	float radians = angle * 3.141592654 / 180;
-	float ix = (LCD_HEIGHT / 2)  + sin( radians ) * iRadius;
-	float iy = (LCD_HEIGHT / 2) - cos( radians ) * iRadius;
-	float ox = (LCD_HEIGHT / 2)  + sin( radians ) * oRadius;
-	float oy = (LCD_HEIGHT / 2) - cos( radians ) * oRadius;
-	*ixp = ix;
-	*iyp = iy;
-	*oxp = ox;
-	*oyp = oy;
+	int16_t sine = GAUGE_Sin( angle );
+	int16_t cosine = GAUGE_Cos( angle );
+	*ixp = (LCD_HEIGHT / 2) + ((iRadius * sine) >> 8);
+	*iyp = (LCD_HEIGHT / 2) - ((iRadius * cosine) >> 8);
+	*oxp = (LCD_HEIGHT / 2) + ((oRadius * sine) >> 8);
+	*oyp = (LCD_HEIGHT / 2) - ((oRadius * cosine) >> 8);
 }
 
 
@@ -107,7 +105,7 @@ static void Clock_UpdateAnalogSecond( uint8_t second )
 	uint8_t newox;
 	uint8_t newoy;
 
-	Clock_ComputeDial( second * 360 / 60, 0, 25, &newix, &newiy, &newox, &newoy );
+	Clock_ComputeDial( ((uint16_t) second << 8) / 60, 0, 25, &newix, &newiy, &newox, &newoy );
 
 	LCD_ClrLine( oldix, oldiy, oldox, oldoy );
 	LCD_SetLine( newix, newiy, newox, newoy );
@@ -119,7 +117,7 @@ static void Clock_UpdateAnalogSecond( uint8_t second )
 }	
 
 
-static void Clock_UpdateAnalogMinute( float minute, float second )
+static void Clock_UpdateAnalogMinute( uint8_t minute, uint8_t second )
 {
 	static uint8_t oldix = 0;
 	static uint8_t oldiy = 0;
@@ -131,7 +129,7 @@ static void Clock_UpdateAnalogMinute( float minute, float second )
 	uint8_t newox;
 	uint8_t newoy;
 
-	Clock_ComputeDial( (minute * 360 / 60) + (second * (360 / 60) / 60), 0, 20, &newix, &newiy, &newox, &newoy );
+	Clock_ComputeDial( (((uint32_t) minute * 60 + second) << 8) / 3600, 0, 20, &newix, &newiy, &newox, &newoy );
 
 	LCD_ClrLine( oldix, oldiy, oldox, oldoy );
 	LCD_SetLine( newix, newiy, newox, newoy );
@@ -143,7 +141,7 @@ static void Clock_UpdateAnalogMinute( float minute, float second )
 }
 
 
-static void Clock_UpdateAnalogHour( float hour, float minute )
+static void Clock_UpdateAnalogHour( uint8_t hour, uint8_t minute )
 {
 	static uint8_t oldix = 0;
 	static uint8_t oldiy = 0;
@@ -155,7 +153,7 @@ static void Clock_UpdateAnalogHour( float hour, float minute )
 	uint8_t newox;
 	uint8_t newoy;
 
-	Clock_ComputeDial( (hour * 360 / 12) + (minute * (360 / 12) / 60), 0, 15, &newix, &newiy, &newox, &newoy );
+	Clock_ComputeDial( (((uint32_t) (hour % 12) * 60 + minute) << 8) / 720, 0, 15, &newix, &newiy, &newox, &newoy );
 
 	LCD_ClrLine( oldix, oldiy, oldox, oldoy );
 	LCD_SetLine( newix, newiy, newox, newoy );
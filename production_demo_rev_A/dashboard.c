@@ -0,0 +1,467 @@
+// This file has been prepared for Doxygen automatic documentation generation.
+/*! \file *********************************************************************
+ *
+ * \brief  Multi-page driving dashboard source file
+ *
+ *         Static layers are allocated from the 1024 byte memory blocks, but
+ *         one block is left for message overlays. Pages without a layer are
+ *         drawn directly instead, which is slower but looks the same.
+ *
+ *         Render time is measured in timing_lib ticks, so frames drawn
+ *         faster than one tick show up as zero.
+ *
+ *****************************************************************************/
+
+#include "dashboard.h"
+#include <cal.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <string.h>
+#include <lcd_lib.h>
+#include <joystick_driver.h>
+#include <memblock_lib.h>
+#include <rtc_driver.h>
+#include <layout_lib.h>
+#include <popup_lib.h>
+#include <alert_lib.h>
+#include <icon_lib.h>
+#include <sigstore_lib.h>
+
+#include "layout_drive.h"
+#include "layout_cells.h"
+#include "layout_temps.h"
+#include "layout_trip.h"
+#include "diagnostics.h"
+
+
+
+/********************
+ * Private variables
+ ********************/
+
+//! Page layouts in joystick order.
+static LAYOUT_layout_t const CAL_PGM_DEF(* const DASHBOARD_pages[DASHBOARD_LAYOUT_COUNT]) = {
+	&LAYOUT_drive,
+	&LAYOUT_cells,
+	&LAYOUT_temps,
+	&LAYOUT_trip
+};
+
+static char const CAL_PGM_DEF(DASHBOARD_txtOverTemp[]) = "OVER TEMPERATURE";  //!< Over temperature alert text.
+static char const CAL_PGM_DEF(DASHBOARD_txtLowVolt[]) = "LOW CELL VOLTAGE";  //!< Low cell voltage alert text.
+
+static uint8_t * DASHBOARD_layers[DASHBOARD_LAYOUT_COUNT];  //!< Static layer of each page, NULL if not cached.
+static uint8_t DASHBOARD_page;  //!< Visible page.
+static int8_t volatile DASHBOARD_pageStep;  //!< Pages to move, set by joystick handler.
+static int8_t volatile DASHBOARD_scrollStep;  //!< Rows to scroll the diagnostics page, set by joystick handler.
+
+static bool DASHBOARD_tripStarted;  //!< True when first SOC value has been received.
+static int16_t DASHBOARD_socStart;  //!< SOC at start of trip.
+
+static SIGSTORE_slot_t DASHBOARD_slots[DASHBOARD_SIGNAL_COUNT];  //!< Latest value of each signal.
+static uint8_t volatile DASHBOARD_pending[SIGSTORE_MAP_SIZE( DASHBOARD_SIGNAL_COUNT )];  //!< Bitmap of signals not drawn yet.
+static SIGSTORE_store_t DASHBOARD_store;  //!< Signal store of the slots above.
+static bool DASHBOARD_frameRequested;  //!< Draw pending updates without waiting for a frame slot.
+
+static ICON_strip_t DASHBOARD_icons;  //!< Status icons on summary page.
+
+static POPUP_overlay_t * DASHBOARD_message;  //!< Open message overlay, or NULL.
+
+static TIMING_event_t DASHBOARD_frameEvent;  //!< Periodic frame slot event.
+static TIMING_counter_t volatile DASHBOARD_frameSlots;  //!< Frame slots passed since last frame.
+static DASHBOARD_stats_t DASHBOARD_stats;  //!< Render statistics.
+
+
+
+/*******************************
+ * Internal function prototypes
+ *******************************/
+
+//! Get layout of a page.
+static LAYOUT_layout_t const CAL_PGM(* DASHBOARD_GetLayout( uint8_t page ));
+//! Update one signal on all pages, drawing it on the visible page if requested.
+static void DASHBOARD_SetSignal( uint8_t signal, int16_t value, bool draw );
+//! Hand all pending signal values to the pages.
+static void DASHBOARD_ApplyPending( bool draw );
+//! Return true if the visible page has status icons to draw.
+static bool DASHBOARD_IconsChanged( void );
+//! Raise or clear alerts for a new signal value.
+static void DASHBOARD_CheckAlerts( uint8_t signal, int16_t value );
+//! Add to a statistics counter without wrapping.
+static void DASHBOARD_Count( uint16_t * counter, uint8_t amount );
+//! Joystick event handler, only records the requested page change.
+static void DASHBOARD_JoystickHandler( JOYSTICK_event_t const * event );
+
+
+
+/***************************
+ * Function implementations
+ ***************************/
+
+void DASHBOARD_Init( void )
+{
+	for (uint8_t page = 0; page < DASHBOARD_LAYOUT_COUNT; ++page) {
+		LAYOUT_layout_t const CAL_PGM(* layout) = DASHBOARD_GetLayout( page );
+		LAYOUT_Init( layout );
+		DASHBOARD_layers[page] = NULL;
+		if (page < DASHBOARD_MAX_LAYERS) {
+			DASHBOARD_layers[page] = MEM_ALLOC_ARRAY( uint8_t, LCD_BUF_SIZE );
+		}
+		if (DASHBOARD_layers[page] != NULL) {
+			LAYOUT_DrawStatic( layout, DASHBOARD_layers[page] );
+		}
+	}
+
+	DIAG_Init();
+
+	ICON_Init( &DASHBOARD_icons, DASHBOARD_ICON_ROW, 0, 0, ICON_COUNT );
+	DASHBOARD_message = NULL;
+	DASHBOARD_tripStarted = false;
+	DASHBOARD_pageStep = 0;
+	DASHBOARD_scrollStep = 0;
+	SIGSTORE_Init( &DASHBOARD_store, DASHBOARD_slots, DASHBOARD_pending, DASHBOARD_SIGNAL_COUNT );
+	DASHBOARD_frameRequested = false;
+	DASHBOARD_ResetStats();
+
+	CAL_disable_interrupt();
+	JOYSTICK_SetEventHandler( DASHBOARD_JoystickHandler );
+	CAL_enable_interrupt();
+
+	ALERT_Init( DASHBOARD_ALERT_PAGE, 0, LCD_WIDTH );
+	DASHBOARD_SetMaxRate( DASHBOARD_DEFAULT_RATE );
+	DASHBOARD_page = 0;
+	DASHBOARD_ShowPage( 0 );
+}
+
+
+/*!
+ *  Values only go into the signal store here, so frames can arrive much
+ *  faster than the frame rate. SOC also drives the trip signals. The first
+ *  SOC value received marks the start of the trip, and charging during the
+ *  trip is not counted as negative usage.
+ *
+ * \param  signal  One of DASHBOARD_SIGNAL_*, others are ignored
+ * \param  value   New value
+ */
+void DASHBOARD_Update( uint8_t signal, int16_t value )
+{
+	if (signal >= DASHBOARD_SIGNAL_COUNT) {
+		return;
+	}
+
+	uint16_t const now = (uint16_t) TIMING_GetTime();
+	DASHBOARD_Count( &DASHBOARD_stats.updates, 1 );
+	if (SIGSTORE_Write( &DASHBOARD_store, signal, value, now )) {
+		DASHBOARD_Count( &DASHBOARD_stats.coalesced, 1 );
+	}
+	DASHBOARD_CheckAlerts( signal, value );
+
+	if (signal == DASHBOARD_SIGNAL_SOC) {
+		if (DASHBOARD_tripStarted == false) {
+			DASHBOARD_tripStarted = true;
+			DASHBOARD_socStart = value;
+			SIGSTORE_Write( &DASHBOARD_store, DASHBOARD_SIGNAL_SOC_START, value, now );
+		}
+		int16_t const used = DASHBOARD_socStart - value;
+		SIGSTORE_Write( &DASHBOARD_store, DASHBOARD_SIGNAL_SOC_USED, (used < 0) ? 0 : used, now );
+	}
+}
+
+
+/*!
+ *  A page switch applies pending updates without drawing and then shows
+ *  the new page, which draws everything anyway. Otherwise pending updates
+ *  are drawn when a frame slot has passed or a frame was requested.
+ *
+ *  No frames are drawn while a message is shown. Updates are collected as
+ *  usual and drawn in the first frame after the message has been closed
+ *  and the area under it restored. The alert banner is taken off while
+ *  a frame or message is drawn, and blinks only between frames.
+ *
+ *  While the diagnostics page is shown, updates still go to the hidden
+ *  layouts, and the diagnostics page redraws its own changed values.
+ */
+void DASHBOARD_Task( void )
+{
+	if (DASHBOARD_message != NULL) {
+		if (POPUP_ServiceOverlay( DASHBOARD_message ) == false) {
+			return;
+		}
+		DASHBOARD_message = NULL;
+		ALERT_Resume();
+	}
+
+	CAL_disable_interrupt();
+	int8_t const step = DASHBOARD_pageStep;
+	DASHBOARD_pageStep = 0;
+	int8_t const scroll = DASHBOARD_scrollStep;
+	DASHBOARD_scrollStep = 0;
+	TIMING_counter_t const slots = DASHBOARD_frameSlots;
+	if (slots != 0) {
+		DASHBOARD_frameSlots = 0;
+	}
+	CAL_enable_interrupt();
+
+	if (slots > 1) {
+		DASHBOARD_Count( &DASHBOARD_stats.skipped, slots - 1 );
+	}
+
+	if (step != 0) {
+		int8_t page = (int8_t) DASHBOARD_page + (step % DASHBOARD_PAGE_COUNT);
+		if (page < 0) {
+			page += DASHBOARD_PAGE_COUNT;
+		} else if (page >= DASHBOARD_PAGE_COUNT) {
+			page -= DASHBOARD_PAGE_COUNT;
+		}
+		DASHBOARD_ApplyPending( false );
+		DASHBOARD_ShowPage( page );
+	} else if ((SIGSTORE_HasChanged( &DASHBOARD_store ) || DASHBOARD_IconsChanged()) && ((slots != 0) || DASHBOARD_frameRequested)) {
+		TIMING_time_t const start = TIMING_GetTime();
+		ALERT_Suspend();
+		DASHBOARD_ApplyPending( true );
+		if (DASHBOARD_page == DASHBOARD_ICON_PAGE) {
+			ICON_Update( &DASHBOARD_icons );
+		}
+		ALERT_Resume();
+		TIMING_time_t const renderTime = TIMING_GetTime() - start;
+
+		DASHBOARD_Count( &DASHBOARD_stats.frames, 1 );
+		DASHBOARD_stats.lastRenderTime = renderTime;
+		if (renderTime > DASHBOARD_stats.maxRenderTime) {
+			DASHBOARD_stats.maxRenderTime = renderTime;
+		}
+	}
+
+	if (DASHBOARD_page == DASHBOARD_DIAG_PAGE) {
+		DIAG_Scroll( scroll );
+		DIAG_Task();
+	}
+
+	DASHBOARD_frameRequested = false;
+	ALERT_Task();
+}
+
+
+/*!
+ *  The rate is limited by the timing_lib tick rate. Rates above it give
+ *  one frame slot per tick.
+ */
+void DASHBOARD_SetMaxRate( uint8_t framesPerSecond )
+{
+	TIMING_time_t period = RTC_TICKS_PER_SECOND;
+	if (framesPerSecond > 1) {
+		period /= framesPerSecond;
+	}
+	if (period == 0) {
+		period = 1;
+	}
+
+	TIMING_RemoveEvent( &DASHBOARD_frameEvent );
+	TIMING_AddRepCounterEvent( TIMING_INFINITE_REPEAT, period, &DASHBOARD_frameSlots, &DASHBOARD_frameEvent );
+}
+
+
+/*!
+ *  An open message is closed first, so the new one goes on top of the
+ *  page and not of the old message.
+ *
+ * \param  str      Message text, at most DASHBOARD_MESSAGE_WIDTH characters per line
+ * \param  timeout  Ticks until the message goes away, 0 to wait for joystick
+ */
+void DASHBOARD_ShowMessage( char const * str, TIMING_time_t timeout )
+{
+	if (DASHBOARD_message != NULL) {
+		POPUP_CloseOverlay( DASHBOARD_message );
+	} else {
+		ALERT_Suspend();
+	}
+	DASHBOARD_message = POPUP_OpenOverlay( DASHBOARD_MESSAGE_WIDTH, DASHBOARD_MESSAGE_PAGES, DASHBOARD_MESSAGE_MARGIN, str, timeout );
+	if (DASHBOARD_message == NULL) {
+		ALERT_Resume();
+	}
+}
+
+
+/*!
+ *  Icons keep their state while the summary page is hidden and are all
+ *  drawn when it is shown again.
+ */
+void DASHBOARD_SetStatus( uint8_t icon, uint8_t state )
+{
+	ICON_SetState( &DASHBOARD_icons, icon, state );
+}
+
+
+void DASHBOARD_RequestFrame( void )
+{
+	DASHBOARD_frameRequested = true;
+}
+
+
+void DASHBOARD_GetStats( DASHBOARD_stats_t * stats )
+{
+	*stats = DASHBOARD_stats;
+}
+
+
+void DASHBOARD_ResetStats( void )
+{
+	memset( &DASHBOARD_stats, 0x00, sizeof(DASHBOARD_stats) );
+}
+
+
+/*!
+ *  Alerts are held from entering the diagnostics page until leaving it,
+ *  since its hardware scrolling moves the rows the banner is drawn on.
+ *
+ * \param  page  Page number, DASHBOARD_DIAG_PAGE for the diagnostics page
+ */
+void DASHBOARD_ShowPage( uint8_t page )
+{
+	if (page >= DASHBOARD_PAGE_COUNT) {
+		return;
+	}
+	bool const wasDiag = (DASHBOARD_page == DASHBOARD_DIAG_PAGE);
+	bool const isDiag = (page == DASHBOARD_DIAG_PAGE);
+	if (isDiag && (wasDiag == false)) {
+		ALERT_Suspend();
+	} else if (wasDiag && (isDiag == false)) {
+		DIAG_Hide();
+	}
+
+	DASHBOARD_page = page;
+	DASHBOARD_Redraw();
+
+	if (wasDiag && (isDiag == false)) {
+		ALERT_Resume();
+	}
+}
+
+
+/*!
+ *  A cached page costs one frame buffer write and the widgets. Widgets
+ *  draw their last known value, which hidden pages have kept up to date.
+ */
+void DASHBOARD_Redraw( void )
+{
+	if (DASHBOARD_page == DASHBOARD_DIAG_PAGE) {
+		DIAG_Draw();
+		return;
+	}
+
+	LAYOUT_layout_t const CAL_PGM(* layout) = DASHBOARD_GetLayout( DASHBOARD_page );
+	uint8_t const * layer = DASHBOARD_layers[DASHBOARD_page];
+
+	ALERT_Suspend();
+	if (layer != NULL) {
+		LCD_WriteFrameBuffer( layer );
+		LAYOUT_DrawDynamic( layout );
+	} else {
+		LCD_SetScreen( 0x00 );
+		LAYOUT_Draw( layout );
+	}
+	if (DASHBOARD_page == DASHBOARD_ICON_PAGE) {
+		ICON_Draw( &DASHBOARD_icons );
+	}
+	ALERT_Resume();
+}
+
+
+static LAYOUT_layout_t const CAL_PGM(* DASHBOARD_GetLayout( uint8_t page ))
+{
+	return (LAYOUT_layout_t const CAL_PGM(*)) CAL_pgm_read_pvoid( &DASHBOARD_pages[page] );
+}
+
+
+static bool DASHBOARD_IconsChanged( void )
+{
+	return (DASHBOARD_page == DASHBOARD_ICON_PAGE) && ICON_IsChanged( &DASHBOARD_icons );
+}
+
+
+static void DASHBOARD_SetSignal( uint8_t signal, int16_t value, bool draw )
+{
+	for (uint8_t page = 0; page < DASHBOARD_LAYOUT_COUNT; ++page) {
+		if (draw && (page == DASHBOARD_page)) {
+			LAYOUT_Update( DASHBOARD_GetLayout( page ), signal, value );
+		} else {
+			LAYOUT_Store( DASHBOARD_GetLayout( page ), signal, value );
+		}
+	}
+}
+
+
+/*!
+ *  Only signals marked in the changed bitmap are visited, each with its
+ *  latest value however many updates it got since the last frame.
+ */
+static void DASHBOARD_ApplyPending( bool draw )
+{
+	for (uint8_t group = 0; group < SIGSTORE_MAP_SIZE( DASHBOARD_SIGNAL_COUNT ); ++group) {
+		uint8_t changed = SIGSTORE_TakeChanged( &DASHBOARD_store, group );
+		for (uint8_t signal = group * 8; changed != 0x00; ++signal, changed >>= 1) {
+			if ((changed & 0x01) != 0x00) {
+				DASHBOARD_SetSignal( signal, SIGSTORE_GetValue( &DASHBOARD_store, signal ), draw );
+			}
+		}
+	}
+}
+
+
+/*!
+ *  Alerts are raised when a limit is crossed and cleared only when the
+ *  value is back inside the limit by the hysteresis, so a value sitting
+ *  on the limit does not make the alert come and go. A new alert gets a
+ *  frame at once, so the banner is not held up behind the frame rate.
+ */
+static void DASHBOARD_CheckAlerts( uint8_t signal, int16_t value )
+{
+	if (signal == DASHBOARD_SIGNAL_MAX_TEMP) {
+		if (value >= DASHBOARD_TEMP_LIMIT) {
+			if (ALERT_IsActive( DASHBOARD_ALERT_TEMP ) == false) {
+				ALERT_Raise( DASHBOARD_ALERT_TEMP, 1, ALERT_FLAG_SOUND, DASHBOARD_txtOverTemp );
+				DASHBOARD_RequestFrame();
+			}
+		} else if (value < DASHBOARD_TEMP_LIMIT - DASHBOARD_TEMP_HYSTERESIS) {
+			ALERT_Clear( DASHBOARD_ALERT_TEMP );
+		}
+	} else if (signal == DASHBOARD_SIGNAL_MIN_VOLT) {
+		if (value < DASHBOARD_VOLT_LIMIT) {
+			if (ALERT_IsActive( DASHBOARD_ALERT_VOLT ) == false) {
+				ALERT_Raise( DASHBOARD_ALERT_VOLT, 2, ALERT_FLAG_SOUND | ALERT_FLAG_BACKLIGHT, DASHBOARD_txtLowVolt );
+				DASHBOARD_RequestFrame();
+			}
+		} else if (value >= DASHBOARD_VOLT_LIMIT + DASHBOARD_VOLT_HYSTERESIS) {
+			ALERT_Clear( DASHBOARD_ALERT_VOLT );
+		}
+	}
+}
+
+
+static void DASHBOARD_Count( uint16_t * counter, uint8_t amount )
+{
+	uint16_t const sum = *counter + amount;
+	*counter = (sum < *counter) ? UINT16_MAX : sum;
+}
+
+
+/*!
+ *  Called from the joystick polling interrupt, so no drawing here. The
+ *  page is switched and scrolled by DASHBOARD_Task in the main loop, which
+ *  drops scroll steps unless the diagnostics page is shown.
+ */
+static void DASHBOARD_JoystickHandler( JOYSTICK_event_t const * event )
+{
+	if ((event->clicked & JOYSTICK_LEFT) != 0x00) {
+		--DASHBOARD_pageStep;
+	} else if ((event->clicked & JOYSTICK_RIGHT) != 0x00) {
+		++DASHBOARD_pageStep;
+	} else if ((event->clicked & JOYSTICK_UP) != 0x00) {
+		--DASHBOARD_scrollStep;
+	} else if ((event->clicked & JOYSTICK_DOWN) != 0x00) {
+		++DASHBOARD_scrollStep;
+	}
+}
+
+
+// end of file
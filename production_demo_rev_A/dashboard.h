@@ -0,0 +1,122 @@
+// This file has been prepared for Doxygen automatic documentation generation.
+/*! \file *********************************************************************
+ *
+ * \brief  Multi-page driving dashboard header file
+ *
+ *         The dashboard shows one of several layouts (summary, cells,
+ *         temperatures and trip), or the CAN diagnostics page, selected with
+ *         joystick left and right. Joystick up and down scroll the
+ *         diagnostics page.
+ *         The labels of each page are composed once into a frame buffer,
+ *         so switching pages is one LCD_WriteFrameBuffer plus drawing the
+ *         widgets. Pages that are not on screen keep receiving signal
+ *         updates without touching the LCD, so they are current when shown.
+ *
+ *         Signal updates are not drawn when they arrive. They are collected,
+ *         newer values replacing older ones, and drawn together in the next
+ *         frame. Frames are paced by a timing_lib event at a configurable
+ *         max rate, so a burst of CAN frames costs one redraw. Alerts that
+ *         cannot wait for the next frame slot can ask for a frame at once.
+ *
+ *         Over temperature and low cell voltage raise blinking alert
+ *         banners at the bottom of the screen, which stay up on every page
+ *         until the value is back inside its limit plus some hysteresis.
+ *
+ *         The summary page also has a strip of status icons. Icon states
+ *         are drawn with the next frame, and only the icons that changed.
+ *
+ *         The diagnostics page scrolls with the LCD hardware scrolling,
+ *         which would move the alert banner, so alerts are held while it is
+ *         shown. They come back as soon as a layout is shown again.
+ *
+ *****************************************************************************/
+#ifndef DASHBOARD_H
+#define DASHBOARD_H
+
+#include <stdint.h>
+#include <timing_lib.h>
+
+
+
+/************************
+ * Constants and defines
+ ************************/
+
+#define DASHBOARD_LAYOUT_COUNT 4  //!< Number of pages with a layout.
+#define DASHBOARD_DIAG_PAGE 4  //!< Page number of the CAN diagnostics page.
+#define DASHBOARD_PAGE_COUNT 5  //!< Number of pages.
+#define DASHBOARD_DEFAULT_RATE 16  //!< Default max frame rate, frames per second.
+#define DASHBOARD_MAX_LAYERS 2  //!< Pages with cached static layer, leaving a 1024 byte block for overlays.
+
+#define DASHBOARD_MESSAGE_WIDTH  14  //!< Message box width in characters.
+#define DASHBOARD_MESSAGE_PAGES  2  //!< Message box height in pages.
+#define DASHBOARD_MESSAGE_MARGIN 3  //!< Pixels between message box frame and text.
+
+#define DASHBOARD_ICON_PAGE 0  //!< Dashboard page showing the status icons.
+#define DASHBOARD_ICON_ROW 4  //!< LCD page of the status icon strip.
+
+#define DASHBOARD_ALERT_PAGE 7  //!< LCD page of alert banner.
+#define DASHBOARD_ALERT_TEMP 0  //!< Alert slot for over temperature.
+#define DASHBOARD_ALERT_VOLT 1  //!< Alert slot for low cell voltage.
+#define DASHBOARD_TEMP_LIMIT 55  //!< Max pack temperature before alert, C.
+#define DASHBOARD_TEMP_HYSTERESIS 3  //!< Degrees below limit to clear alert, C.
+#define DASHBOARD_VOLT_LIMIT 300  //!< Min cell voltage before alert, 0.01 V.
+#define DASHBOARD_VOLT_HYSTERESIS 10  //!< Voltage above limit to clear alert, 0.01 V.
+
+//! Signal IDs, must match dashboard.signals used by the page layouts.
+#define DASHBOARD_SIGNAL_SOC       0  //!< State of charge, %.
+#define DASHBOARD_SIGNAL_MAX_TEMP  1  //!< Max pack temperature, C.
+#define DASHBOARD_SIGNAL_MIN_VOLT  2  //!< Min cell voltage, 0.01 V.
+#define DASHBOARD_SIGNAL_SOC_START 3  //!< State of charge at start of trip, derived from SOC.
+#define DASHBOARD_SIGNAL_SOC_USED  4  //!< State of charge used on this trip, derived from SOC.
+#define DASHBOARD_SIGNAL_COUNT     5  //!< Number of signals.
+
+
+
+/*********************
+ * Types and typedefs
+ *********************/
+
+//! Render statistics. Counters saturate instead of wrapping.
+typedef struct DASHBOARD_stats_struct
+{
+	uint16_t updates;  //!< Signal updates received.
+	uint16_t coalesced;  //!< Updates replaced by a newer value before being drawn.
+	uint16_t frames;  //!< Frames drawn.
+	uint16_t skipped;  //!< Frame slots that passed while the main loop was busy.
+	TIMING_time_t lastRenderTime;  //!< Ticks spent drawing the last frame.
+	TIMING_time_t maxRenderTime;  //!< Most ticks spent drawing one frame.
+} DASHBOARD_stats_t;
+
+
+
+/**********************
+ * Function prototypes
+ **********************/
+
+//! Initialize all pages, cache their static layers, install joystick handler and show first page. Select the CAN dispatch table first.
+void DASHBOARD_Init( void );
+//! Give a signal a new value, to be drawn in the next frame.
+void DASHBOARD_Update( uint8_t signal, int16_t value );
+//! Draw a frame or switch page when due. Call from main loop.
+void DASHBOARD_Task( void );
+//! Set max frame rate in frames per second.
+void DASHBOARD_SetMaxRate( uint8_t framesPerSecond );
+//! Set state of a status icon, one of ICON_* from icon_lib.h, to be drawn in the next frame.
+void DASHBOARD_SetStatus( uint8_t icon, uint8_t state );
+//! Show a message over the visible page until joystick click or timeout.
+void DASHBOARD_ShowMessage( char const * str, TIMING_time_t timeout );
+//! Draw pending updates on next DASHBOARD_Task without waiting for a frame slot.
+void DASHBOARD_RequestFrame( void );
+//! Copy render statistics.
+void DASHBOARD_GetStats( DASHBOARD_stats_t * stats );
+//! Clear render statistics.
+void DASHBOARD_ResetStats( void );
+//! Show given page.
+void DASHBOARD_ShowPage( uint8_t page );
+//! Draw visible page again, e.g. after something else has drawn on the screen.
+void DASHBOARD_Redraw( void );
+
+
+#endif
+// end of file
@@ -0,0 +1,508 @@
+// This file has been prepared for Doxygen automatic documentation generation.
+/*! \file *********************************************************************
+ *
+ * \brief  CAN bus diagnostics page source file
+ *
+ *         The statistics are one form element with a row per LCD page. The
+ *         rows are described by a table in flash: a label and up to
+ *         DIAG_CELLS_PER_ROW value cells, each with its column and width.
+ *         Route rows use three template rows, repeated for each route.
+ *
+ *         The last value drawn in each cell is kept per physical LCD page.
+ *         Hardware scrolling leaves rows on the LCD page they were drawn
+ *         on, so the cache stays valid while scrolling, and rows scrolled
+ *         into view fill in their own entries when forms_lib draws them.
+ *
+ *****************************************************************************/
+
+#include "diagnostics.h"
+#include <cal.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <lcd_lib.h>
+#include <termfont_lib.h>
+#include <forms_lib.h>
+#include <widgets_lib.h>
+#include <timing_lib.h>
+#include <rtc_driver.h>
+#include <uart_driver.h>
+#include <can_lib.h>
+#include <canstat_lib.h>
+
+#include "adapter.h"
+
+
+
+/********************************
+ * Private constants and defines
+ ********************************/
+
+#define DIAG_CELLS_PER_ROW 4  //!< Max value cells in one row.
+#define DIAG_MAX_WIDTH 8  //!< Max characters in one cell.
+#define DIAG_NONE 0xFFFFFFFFUL  //!< Cell value shown as '-'.
+#define DIAG_GLOBAL_ROWS 9  //!< Rows before the first route row, headers included.
+#define DIAG_ROUTE_ROWS 3  //!< Rows per route.
+#define DIAG_REFRESH_PERIOD (RTC_TICKS_PER_SECOND / DIAG_REFRESH_RATE)  //!< Ticks between refreshes.
+
+//! Values that can be shown in a cell.
+enum DIAG_value_enum
+{
+	DIAG_VALUE_UNUSED,  //!< No cell.
+	DIAG_VALUE_LINES,  //!< Lines and records received.
+	DIAG_VALUE_PARSE_ERRORS,  //!< Malformed lines and records.
+	DIAG_VALUE_UNKNOWN_IDS,  //!< Frames without a route.
+	DIAG_VALUE_OVERRUNS,  //!< Bytes lost in the UART receive ring or the USART.
+	DIAG_VALUE_LOAD,  //!< Bus load, 0.1 %.
+	DIAG_VALUE_STARTS,  //!< Adapter bring-ups.
+	DIAG_VALUE_FILTER_ACCEPTED,  //!< IDs let through the adapter filter.
+	DIAG_VALUE_FILTER_NEEDED,  //!< IDs with a route.
+	DIAG_VALUE_COUNT,  //!< Frames of route.
+	DIAG_VALUE_DLC_ERRORS,  //!< Frames of route with an unexpected DLC.
+	DIAG_VALUE_MIN,  //!< Shortest interval of route, ms.
+	DIAG_VALUE_AVERAGE,  //!< Averaged interval of route, ms.
+	DIAG_VALUE_MAX,  //!< Longest interval of route, ms.
+	DIAG_VALUE_AGE,  //!< Seconds since last frame of route.
+	DIAG_VALUE_LATENCY  //!< Latency of last frame of route, ms.
+};
+
+
+
+/*********************
+ * Types and typedefs
+ *********************/
+
+//! One value cell of a row, stored in flash.
+typedef struct DIAG_cell_struct
+{
+	uint8_t value;  //!< One of DIAG_VALUE_* values.
+	uint8_t column;  //!< First character column.
+	uint8_t width;  //!< Characters, value right aligned.
+	uint8_t decimals;  //!< Digits after the decimal point.
+} DIAG_cell_t;
+
+//! One row of the statistics, stored in flash.
+typedef struct DIAG_row_struct
+{
+	char const CAL_PGM(* label);  //!< Text from column 0, or NULL for the route ID.
+	DIAG_cell_t cells[DIAG_CELLS_PER_ROW];  //!< Value cells, unused ones last.
+} DIAG_row_t;
+
+//! Statistics read once per refresh.
+typedef struct DIAG_sample_struct
+{
+	uint32_t now;  //!< Time of sample, ms.
+	CANSTAT_totals_t totals;  //!< Traffic totals.
+	uint16_t overruns;  //!< UART receive overruns and data overruns.
+	uint16_t starts;  //!< Adapter bring-ups.
+	uint16_t accepted;  //!< IDs let through the adapter filter.
+	uint16_t needed;  //!< IDs with a route.
+} DIAG_sample_t;
+
+
+
+/********************
+ * Private variables
+ ********************/
+
+static char const CAL_PGM_DEF(DIAG_txtTitle[]) = "CAN diagnostics";  //!< Page title.
+static char const CAL_PGM_DEF(DIAG_txtLines[]) = "Lines";  //!< Lines label.
+static char const CAL_PGM_DEF(DIAG_txtParseErrors[]) = "Parse errors";  //!< Parse errors label.
+static char const CAL_PGM_DEF(DIAG_txtUnknownIds[]) = "Unknown IDs";  //!< Unknown IDs label.
+static char const CAL_PGM_DEF(DIAG_txtOverruns[]) = "UART overruns";  //!< UART overruns label.
+static char const CAL_PGM_DEF(DIAG_txtLoad[]) = "Bus load %";  //!< Bus load label.
+static char const CAL_PGM_DEF(DIAG_txtStarts[]) = "Link starts";  //!< Adapter bring-ups label.
+static char const CAL_PGM_DEF(DIAG_txtFilter[]) = "Filter IDs     /";  //!< Filter efficiency label.
+static char const CAL_PGM_DEF(DIAG_txtRouteHeader[]) = "ID        frames err";  //!< Header of first route row.
+static char const CAL_PGM_DEF(DIAG_txtTimeHeader[]) = " min  avg  max   age";  //!< Header of second route row.
+static char const CAL_PGM_DEF(DIAG_txtEmpty[]) = "";  //!< Label of rows with values only.
+static char const CAL_PGM_DEF(DIAG_txtLatency[]) = "     latency";  //!< Label of third route row.
+
+//! Rows before the route rows, then the three route template rows.
+static DIAG_row_t const CAL_PGM_DEF(DIAG_rows[DIAG_GLOBAL_ROWS + DIAG_ROUTE_ROWS]) = {
+	{ DIAG_txtLines,        { { DIAG_VALUE_LINES, 12, 8, 0 } } },
+	{ DIAG_txtParseErrors,  { { DIAG_VALUE_PARSE_ERRORS, 13, 7, 0 } } },
+	{ DIAG_txtUnknownIds,   { { DIAG_VALUE_UNKNOWN_IDS, 13, 7, 0 } } },
+	{ DIAG_txtOverruns,     { { DIAG_VALUE_OVERRUNS, 14, 6, 0 } } },
+	{ DIAG_txtLoad,         { { DIAG_VALUE_LOAD, 13, 7, 1 } } },
+	{ DIAG_txtStarts,       { { DIAG_VALUE_STARTS, 13, 7, 0 } } },
+	{ DIAG_txtFilter,       { { DIAG_VALUE_FILTER_ACCEPTED, 11, 4, 0 }, { DIAG_VALUE_FILTER_NEEDED, 16, 4, 0 } } },
+	{ DIAG_txtRouteHeader,  { { DIAG_VALUE_UNUSED } } },
+	{ DIAG_txtTimeHeader,   { { DIAG_VALUE_UNUSED } } },
+	{ NULL,                 { { DIAG_VALUE_COUNT, 9, 7, 0 }, { DIAG_VALUE_DLC_ERRORS, 17, 3, 0 } } },
+	{ DIAG_txtEmpty,        { { DIAG_VALUE_MIN, 0, 4, 0 }, { DIAG_VALUE_AVERAGE, 5, 4, 0 }, { DIAG_VALUE_MAX, 10, 4, 0 }, { DIAG_VALUE_AGE, 15, 5, 0 } } },
+	{ DIAG_txtLatency,      { { DIAG_VALUE_LATENCY, 15, 5, 0 } } }
+};
+
+static FORMS_form_t DIAG_form;  //!< Diagnostics form.
+static WIDGETS_StaticText_t DIAG_title;  //!< Page title.
+static WIDGETS_Separator_t DIAG_separator;  //!< Line under the title.
+static FORMS_element_t DIAG_table;  //!< Statistics rows.
+static uint8_t DIAG_routeCount;  //!< Routes with rows.
+static uint32_t DIAG_cache[LCD_PAGE_COUNT][DIAG_CELLS_PER_ROW];  //!< Value drawn in each cell, per physical LCD page.
+static TIMING_time_t DIAG_deadline;  //!< Time of next refresh.
+
+
+
+/*******************************
+ * Internal function prototypes
+ *******************************/
+
+//! Draw one row of the statistics table. Called by forms_lib.
+static void DIAG_DrawRow( FORMS_element_t const * element, FORMS_size_t internalPage, uint8_t lcdPage );
+//! Draw the cells of one row whose value changed.
+static void DIAG_RefreshRow( FORMS_size_t internalPage, uint8_t lcdPage, DIAG_sample_t const * sample, bool drawAll );
+//! Get the table row describing a row of the element, and the route it shows.
+static DIAG_row_t const CAL_PGM(* DIAG_GetRow( FORMS_size_t internalPage, uint8_t * route ));
+//! Read statistics shown on the page.
+static void DIAG_Sample( DIAG_sample_t * sample );
+//! Get the value of a cell.
+static uint32_t DIAG_GetValue( uint8_t value, uint8_t route, DIAG_sample_t const * sample );
+//! Draw a value right aligned in a cell.
+static void DIAG_DrawValue( DIAG_cell_t const CAL_PGM(* cell), uint32_t value, uint8_t lcdPage );
+//! Draw the ID of a route from column 0.
+static void DIAG_DrawRouteId( uint8_t route, uint8_t lcdPage );
+//! Draw a character at a form column.
+static void DIAG_DrawChar( char ch, uint8_t column, uint8_t lcdPage );
+
+
+
+/*************************
+ * Internal constant data
+ *************************/
+
+//! Statistics table element, never focused so only drawing is handled.
+static FORMS_elementTraits_t const CAL_PGM_DEF(DIAG_tableTraits) = {
+	NULL,
+	NULL,
+	NULL,
+	NULL,
+	DIAG_DrawRow
+};
+
+
+
+/***************************
+ * Function implementations
+ ***************************/
+
+/*!
+ *  Routes beyond CANSTAT_MAX_ROUTES have no statistics and get no rows.
+ */
+void DIAG_Init( void )
+{
+	DIAG_routeCount = CAN_GetRouteCount();
+	if (DIAG_routeCount > CANSTAT_MAX_ROUTES) {
+		DIAG_routeCount = CANSTAT_MAX_ROUTES;
+	}
+
+	FORMS_Init( &DIAG_form, true );
+
+	WIDGETS_StaticText_Init( &DIAG_title, 0, 1, false, true );
+	FORMS_SetCaption_F( &DIAG_title.element, DIAG_txtTitle );
+	FORMS_AddBottomElement( &DIAG_form, &DIAG_title.element );
+
+	WIDGETS_Separator_Init( &DIAG_separator );
+	FORMS_AddBottomElement( &DIAG_form, &DIAG_separator.element );
+
+	FORMS_InitElement( &DIAG_table, DIAG_GLOBAL_ROWS + DIAG_ROUTE_ROWS * DIAG_routeCount, 0, false, NULL, &DIAG_tableTraits );
+	FORMS_AddBottomElement( &DIAG_form, &DIAG_table );
+
+	DIAG_deadline = TIMING_GetTime();
+}
+
+
+void DIAG_Draw( void )
+{
+	FORMS_Draw( &DIAG_form );
+	DIAG_deadline = TIMING_GetTime() + DIAG_REFRESH_PERIOD;
+}
+
+
+void DIAG_Hide( void )
+{
+	FORMS_CleanUp();
+}
+
+
+void DIAG_Scroll( int8_t step )
+{
+	if (step > 0) {
+		FORMS_ScrollUp( &DIAG_form, step );
+	} else if (step < 0) {
+		FORMS_ScrollDown( &DIAG_form, -step );
+	}
+}
+
+
+/*!
+ *  Statistics are read once, then each visible row compares its cells
+ *  with what was drawn. Cells that did not change cost one compare.
+ */
+void DIAG_Task( void )
+{
+	TIMING_time_t const now = TIMING_GetTime();
+	if ((int32_t) (now - DIAG_deadline) < 0) {
+		return;
+	}
+	DIAG_deadline = now + DIAG_REFRESH_PERIOD;
+
+	FORMS_elementVisibility_t visibility;
+	FORMS_CalculateVisibility( &DIAG_form, &DIAG_table, &visibility );
+	if (visibility.firstPage >= DIAG_table.height) {
+		return;
+	}
+
+	DIAG_sample_t sample;
+	DIAG_Sample( &sample );
+	uint8_t lcdPage = visibility.firstLCDPage;
+	for (FORMS_size_t page = visibility.firstPage; page <= visibility.lastPage; ++page) {
+		DIAG_RefreshRow( page, lcdPage, &sample, false );
+		if (++lcdPage >= LCD_PAGE_COUNT) {
+			lcdPage = 0;
+		}
+	}
+}
+
+
+/*!
+ *  forms_lib has cleared the page before calling this.
+ */
+static void DIAG_DrawRow( FORMS_element_t const * element, FORMS_size_t internalPage, uint8_t lcdPage )
+{
+	uint8_t route;
+	DIAG_row_t const CAL_PGM(* row) = DIAG_GetRow( internalPage, &route );
+	char const CAL_PGM(* label) = (char const CAL_PGM(*)) CAL_pgm_read_pvoid( &row->label );
+
+	if (label == NULL) {
+		DIAG_DrawRouteId( route, lcdPage );
+	} else {
+		uint8_t column = 0;
+		char ch;
+		while ((ch = CAL_pgm_read_char( label++ )) != 0) {
+			DIAG_DrawChar( ch, column++, lcdPage );
+		}
+	}
+
+	DIAG_sample_t sample;
+	DIAG_Sample( &sample );
+	DIAG_RefreshRow( internalPage, lcdPage, &sample, true );
+}
+
+
+/*!
+ * \param  internalPage  Row of the table element
+ * \param  lcdPage       Physical LCD page the row is on
+ * \param  sample        Statistics to show
+ * \param  drawAll       Draw every cell, not only the changed ones
+ */
+static void DIAG_RefreshRow( FORMS_size_t internalPage, uint8_t lcdPage, DIAG_sample_t const * sample, bool drawAll )
+{
+	uint8_t route;
+	DIAG_row_t const CAL_PGM(* row) = DIAG_GetRow( internalPage, &route );
+
+	for (uint8_t index = 0; index < DIAG_CELLS_PER_ROW; ++index) {
+		DIAG_cell_t const CAL_PGM(* cell) = &row->cells[index];
+		uint8_t const valueId = CAL_pgm_read_byte( &cell->value );
+		if (valueId == DIAG_VALUE_UNUSED) {
+			break;
+		}
+		uint32_t const value = DIAG_GetValue( valueId, route, sample );
+		if (drawAll || (value != DIAG_cache[lcdPage][index])) {
+			DIAG_DrawValue( cell, value, lcdPage );
+			DIAG_cache[lcdPage][index] = value;
+		}
+	}
+}
+
+
+/*!
+ * \param  internalPage  Row of the table element
+ * \param  route         Set to route number of route rows
+ */
+static DIAG_row_t const CAL_PGM(* DIAG_GetRow( FORMS_size_t internalPage, uint8_t * route ))
+{
+	if (internalPage < DIAG_GLOBAL_ROWS) {
+		*route = CAN_NO_ROUTE;
+		return &DIAG_rows[internalPage];
+	}
+	internalPage -= DIAG_GLOBAL_ROWS;
+	*route = internalPage / DIAG_ROUTE_ROWS;
+	return &DIAG_rows[DIAG_GLOBAL_ROWS + internalPage % DIAG_ROUTE_ROWS];
+}
+
+
+static void DIAG_Sample( DIAG_sample_t * sample )
+{
+	sample->now = ADAPTER_GetMilliseconds();
+	CANSTAT_GetTotals( &sample->totals, sample->now );
+
+	UART_stats_t uart;
+	UART_GetStats( &uart );
+	sample->overruns = uart.overruns + uart.dataOverruns;
+	if (sample->overruns < uart.overruns) {
+		sample->overruns = 0xFFFF;
+	}
+
+	ADAPTER_stats_t adapter;
+	ADAPTER_GetStats( &adapter );
+	sample->starts = adapter.attempts;
+	sample->accepted = adapter.filter.accepted;
+	sample->needed = adapter.filter.needed;
+}
+
+
+/*!
+ *  Route values are read from canstat_lib for each cell, which is a copy
+ *  of a few bytes. Intervals before the second frame, the latency before
+ *  the first timestamped one and the age before the first are DIAG_NONE.
+ *
+ * \param  value   One of DIAG_VALUE_* values
+ * \param  route   Route number for route values
+ * \param  sample  Statistics read for this refresh
+ */
+static uint32_t DIAG_GetValue( uint8_t value, uint8_t route, DIAG_sample_t const * sample )
+{
+	switch (value) {
+		case DIAG_VALUE_LINES:
+			return sample->totals.lines;
+
+		case DIAG_VALUE_PARSE_ERRORS:
+			return sample->totals.parseErrors;
+
+		case DIAG_VALUE_UNKNOWN_IDS:
+			return sample->totals.unknownIds;
+
+		case DIAG_VALUE_OVERRUNS:
+			return sample->overruns;
+
+		case DIAG_VALUE_LOAD:
+			return sample->totals.load;
+
+		case DIAG_VALUE_STARTS:
+			return sample->starts;
+
+		case DIAG_VALUE_FILTER_ACCEPTED:
+			return sample->accepted;
+
+		case DIAG_VALUE_FILTER_NEEDED:
+			return sample->needed;
+
+		default:
+			break;
+	}
+
+	CANSTAT_route_t stats;
+	if (CANSTAT_GetRoute( route, &stats ) == false) {
+		return DIAG_NONE;
+	}
+	uint16_t interval;
+	switch (value) {
+		case DIAG_VALUE_COUNT:
+			return stats.count;
+
+		case DIAG_VALUE_DLC_ERRORS:
+			return stats.dlcErrors;
+
+		case DIAG_VALUE_MIN:
+			interval = stats.minInterval;
+			break;
+
+		case DIAG_VALUE_AVERAGE:
+			interval = CANSTAT_GetInterval( &stats );
+			break;
+
+		case DIAG_VALUE_MAX:
+			interval = stats.maxInterval;
+			break;
+
+		case DIAG_VALUE_LATENCY:
+			interval = CANSTAT_GetLatency( &stats );
+			break;
+
+		case DIAG_VALUE_AGE:
+			if ((stats.flags & CANSTAT_FLAG_SEEN) == 0x00) {
+				return DIAG_NONE;
+			}
+			return (sample->now - stats.lastSeen) / 1000;
+
+		default:
+			return DIAG_NONE;
+	}
+	return (interval == CANSTAT_NO_INTERVAL) ? DIAG_NONE : interval;
+}
+
+
+/*!
+ *  Values that do not fit are shown as '#' across the cell, so a wrong
+ *  number is never on screen.
+ */
+static void DIAG_DrawValue( DIAG_cell_t const CAL_PGM(* cell), uint32_t value, uint8_t lcdPage )
+{
+	uint8_t const column = CAL_pgm_read_byte( &cell->column );
+	uint8_t const width = CAL_pgm_read_byte( &cell->width );
+	uint8_t const decimals = CAL_pgm_read_byte( &cell->decimals );
+	char text[DIAG_MAX_WIDTH];
+	uint8_t position = width;
+	bool fits = true;
+
+	if (value == DIAG_NONE) {
+		text[--position] = '-';
+	} else {
+		uint8_t digits = 0;
+		do {
+			if ((decimals != 0) && (digits == decimals) && (position != 0)) {
+				text[--position] = '.';
+			}
+			if (position == 0) {
+				fits = false;
+				break;
+			}
+			text[--position] = '0' + (value % 10);
+			value /= 10;
+			++digits;
+		} while ((value != 0) || (digits <= decimals));
+	}
+
+	for (uint8_t index = 0; index < width; ++index) {
+		char ch = text[index];
+		if (fits == false) {
+			ch = '#';
+		} else if (index < position) {
+			ch = ' ';
+		}
+		DIAG_DrawChar( ch, column + index, lcdPage );
+	}
+}
+
+
+/*!
+ *  29-bit IDs take 8 hex digits, 11-bit IDs 3. Routes for a range of IDs
+ *  are marked with '*' after the first ID of the range.
+ */
+static void DIAG_DrawRouteId( uint8_t route, uint8_t lcdPage )
+{
+	uint32_t key;
+	uint32_t mask;
+	if (CAN_GetRouteKey( route, &key, &mask ) == false) {
+		return;
+	}
+
+	uint8_t const digits = ((key & CAN_KEY_EXTENDED) != 0x00) ? 8 : 3;
+	uint32_t const id = key & ~CAN_KEY_EXTENDED;
+	for (uint8_t column = 0; column < digits; ++column) {
+		uint8_t const nibble = (id >> (4 * (digits - 1 - column))) & 0x0F;
+		DIAG_DrawChar( (nibble < 10) ? ('0' + nibble) : ('A' - 10 + nibble), column, lcdPage );
+	}
+	if (mask != 0xFFFFFFFFUL) {
+		DIAG_DrawChar( '*', digits, lcdPage );
+	}
+}
+
+
+static void DIAG_DrawChar( char ch, uint8_t column, uint8_t lcdPage )
+{
+	TERMFONT_DisplayChar( ch, lcdPage, FORMS_FIRST_COLUMN + column * TERMFONT_CHAR_WIDTH );
+}
+
+
+// end of file
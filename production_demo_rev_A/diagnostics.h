@@ -0,0 +1,55 @@
+// This file has been prepared for Doxygen automatic documentation generation.
+/*! \file *********************************************************************
+ *
+ * \brief  CAN bus diagnostics page header file
+ *
+ *         A scrollable forms_lib page with the traffic statistics of
+ *         canstat_lib: lines, parse errors, unknown IDs, UART overruns,
+ *         bus load and the adapter filter, then three rows per route of the
+ *         CAN dispatch table with frame count, DLC errors, min, average and
+ *         max interval in ms, seconds since the last frame, and latency of
+ *         the last frame in ms from adapter timestamps.
+ *
+ *         Values are shown right aligned, '-' when there is none yet and
+ *         '#' when they do not fit. DIAG_Task compares each value on screen
+ *         with the value last drawn, and redraws only the cells that
+ *         changed, at most DIAG_REFRESH_RATE times a second.
+ *
+ *         The form scrolls with the LCD hardware scrolling, so nothing else
+ *         should draw on the screen while it is shown. DIAG_Hide puts the
+ *         hardware scrolling back.
+ *
+ *****************************************************************************/
+#ifndef DIAGNOSTICS_H
+#define DIAGNOSTICS_H
+
+#include <stdint.h>
+
+
+
+/************************
+ * Constants and defines
+ ************************/
+
+#define DIAG_REFRESH_RATE 4  //!< Max refreshes per second.
+
+
+
+/**********************
+ * Function prototypes
+ **********************/
+
+//! Build the page for the routes of the selected CAN dispatch table.
+void DIAG_Init( void );
+//! Draw the whole page, keeping its scroll position.
+void DIAG_Draw( void );
+//! Clear the screen and restore LCD hardware scrolling.
+void DIAG_Hide( void );
+//! Scroll the page, positive steps show lower rows.
+void DIAG_Scroll( int8_t step );
+//! Redraw values that changed, when due. Call from main loop while the page is shown.
+void DIAG_Task( void );
+
+
+#endif
+// end of file
@@ -52,8 +52,8 @@
  * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  *****************************************************************************/
 
-#include <math.h>
 #include <stdint.h>
+#include <stddef.h>
 
 #include <cal.h>
 #include <common.h>
@@ -0,0 +1,33 @@
+// Generated by utils/layout/layout2c.rb from cells.layout, do not edit.
+
+#include "layout_cells.h"
+#include <stddef.h>
+#include <numfield_lib.h>
+#include <bar_lib.h>
+#include <gauge_lib.h>
+#include <chart_lib.h>
+
+static char const CAL_PGM_DEF(layout_cells_text0[]) = "CELLS";
+static char const CAL_PGM_DEF(layout_cells_text1[]) = "Min Volt:";
+static char const CAL_PGM_DEF(layout_cells_text2[]) = "V";
+static NUMFIELD_field_t layout_cells_state2;
+static CHART_chart_t layout_cells_state3;
+static CHART_column_t layout_cells_buffer3[96];
+static char const CAL_PGM_DEF(layout_cells_text4[]) = "history";
+static char const CAL_PGM_DEF(layout_cells_text5[]) = "2 s/px";
+
+static LAYOUT_item_t const CAL_PGM_DEF(layout_cells_items[6]) = {
+	{ LAYOUT_TYPE_LABEL, LAYOUT_NO_SIGNAL, 0, 0, 0, 0, 0, { 0, 0, 0, 0 }, 0, layout_cells_text0, NULL, NULL },  // cells.layout:6
+	{ LAYOUT_TYPE_LABEL, LAYOUT_NO_SIGNAL, 0, 2, 0, 0, 0, { 0, 0, 0, 0 }, 0, layout_cells_text1, NULL, NULL },  // cells.layout:8
+	{ LAYOUT_TYPE_NUMBER, LAYOUT_CELLS_SIGNAL_MIN_VOLT, 60, 2, 5, 0, NUMFIELD_ALIGN_RIGHT, { 2, 0, 0, 0 }, 1, layout_cells_text2, &layout_cells_state2, NULL },  // cells.layout:9
+	{ LAYOUT_TYPE_CHART, LAYOUT_CELLS_SIGNAL_MIN_VOLT, 0, 4, 64, 2, 0, { 2, 0, 0, 0 }, 0, NULL, &layout_cells_state3, layout_cells_buffer3 },  // cells.layout:12
+	{ LAYOUT_TYPE_LABEL, LAYOUT_NO_SIGNAL, 70, 4, 0, 0, 0, { 0, 0, 0, 0 }, 0, layout_cells_text4, NULL, NULL },  // cells.layout:13
+	{ LAYOUT_TYPE_LABEL, LAYOUT_NO_SIGNAL, 70, 5, 0, 0, 0, { 0, 0, 0, 0 }, 0, layout_cells_text5, NULL, NULL },  // cells.layout:14
+};
+
+static uint8_t const CAL_PGM_DEF(layout_cells_signalStart[6]) = { 0, 0, 0, 2, 2, 2 };
+static uint8_t const CAL_PGM_DEF(layout_cells_signalItems[2]) = { 2, 3 };
+
+LAYOUT_layout_t const CAL_PGM_DEF(LAYOUT_cells) = {
+	layout_cells_items, 6, 5, layout_cells_signalStart, layout_cells_signalItems
+};
@@ -0,0 +1,33 @@
+// Generated by utils/layout/layout2c.rb from drive.layout, do not edit.
+
+#include "layout_drive.h"
+#include <stddef.h>
+#include <numfield_lib.h>
+#include <bar_lib.h>
+#include <gauge_lib.h>
+#include <chart_lib.h>
+
+static uint8_t layout_drive_state0;
+static uint8_t layout_drive_state1;
+static char const CAL_PGM_DEF(layout_drive_text2[]) = "Max Temp:";
+static char const CAL_PGM_DEF(layout_drive_text3[]) = "C";
+static NUMFIELD_field_t layout_drive_state3;
+static char const CAL_PGM_DEF(layout_drive_text4[]) = "Min Volt:";
+static char const CAL_PGM_DEF(layout_drive_text5[]) = "V";
+static NUMFIELD_field_t layout_drive_state5;
+
+static LAYOUT_item_t const CAL_PGM_DEF(layout_drive_items[6]) = {
+	{ LAYOUT_TYPE_BIGNUMBER, LAYOUT_DRIVE_SIGNAL_SOC, 0, 0, 0, 0, 0, { 0, 0, 0, 0 }, 0, NULL, &layout_drive_state0, NULL },  // drive.layout:6
+	{ LAYOUT_TYPE_BATTERY, LAYOUT_DRIVE_SIGNAL_SOC, 96, 0, 0, 0, 0, { 0, 0, 0, 0 }, 0, NULL, &layout_drive_state1, NULL },  // drive.layout:7
+	{ LAYOUT_TYPE_LABEL, LAYOUT_NO_SIGNAL, 0, 5, 0, 0, 0, { 0, 0, 0, 0 }, 0, layout_drive_text2, NULL, NULL },  // drive.layout:9
+	{ LAYOUT_TYPE_NUMBER, LAYOUT_DRIVE_SIGNAL_MAX_TEMP, 66, 5, 3, 0, NUMFIELD_ALIGN_RIGHT, { 0, 0, 0, 0 }, 1, layout_drive_text3, &layout_drive_state3, NULL },  // drive.layout:10
+	{ LAYOUT_TYPE_LABEL, LAYOUT_NO_SIGNAL, 0, 7, 0, 0, 0, { 0, 0, 0, 0 }, 0, layout_drive_text4, NULL, NULL },  // drive.layout:12
+	{ LAYOUT_TYPE_NUMBER, LAYOUT_DRIVE_SIGNAL_MIN_VOLT, 60, 7, 5, 0, NUMFIELD_ALIGN_RIGHT, { 2, 0, 0, 0 }, 1, layout_drive_text5, &layout_drive_state5, NULL },  // drive.layout:13
+};
+
+static uint8_t const CAL_PGM_DEF(layout_drive_signalStart[6]) = { 0, 2, 3, 4, 4, 4 };
+static uint8_t const CAL_PGM_DEF(layout_drive_signalItems[4]) = { 0, 1, 3, 5 };
+
+LAYOUT_layout_t const CAL_PGM_DEF(LAYOUT_drive) = {
+	layout_drive_items, 6, 5, layout_drive_signalStart, layout_drive_signalItems
+};
@@ -0,0 +1,36 @@
+// Generated by utils/layout/layout2c.rb from temps.layout, do not edit.
+
+#include "layout_temps.h"
+#include <stddef.h>
+#include <numfield_lib.h>
+#include <bar_lib.h>
+#include <gauge_lib.h>
+#include <chart_lib.h>
+
+static char const CAL_PGM_DEF(layout_temps_text0[]) = "TEMPERATURE";
+static GAUGE_gauge_t layout_temps_state1;
+static uint8_t layout_temps_buffer1[GAUGE_PAGEBUFFER_SIZE( 48, 4 )];
+static char const CAL_PGM_DEF(layout_temps_text2[]) = "Max:";
+static char const CAL_PGM_DEF(layout_temps_text3[]) = "C";
+static NUMFIELD_field_t layout_temps_state3;
+static CHART_chart_t layout_temps_state4;
+static CHART_column_t layout_temps_buffer4[96];
+static char const CAL_PGM_DEF(layout_temps_text5[]) = "0-80 C";
+static char const CAL_PGM_DEF(layout_temps_text6[]) = "history";
+
+static LAYOUT_item_t const CAL_PGM_DEF(layout_temps_items[7]) = {
+	{ LAYOUT_TYPE_LABEL, LAYOUT_NO_SIGNAL, 0, 0, 0, 0, 0, { 0, 0, 0, 0 }, 0, layout_temps_text0, NULL, NULL },  // temps.layout:6
+	{ LAYOUT_TYPE_GAUGE, LAYOUT_TEMPS_SIGNAL_MAX_TEMP, 0, 2, 48, 4, GAUGE_STYLE_ARC | GAUGE_STYLE_PIVOT, { 24, 18, 15, 5 }, 80, NULL, &layout_temps_state1, layout_temps_buffer1 },  // temps.layout:8
+	{ LAYOUT_TYPE_LABEL, LAYOUT_NO_SIGNAL, 56, 2, 0, 0, 0, { 0, 0, 0, 0 }, 0, layout_temps_text2, NULL, NULL },  // temps.layout:11
+	{ LAYOUT_TYPE_NUMBER, LAYOUT_TEMPS_SIGNAL_MAX_TEMP, 86, 2, 3, 0, NUMFIELD_ALIGN_RIGHT, { 0, 0, 0, 0 }, 1, layout_temps_text3, &layout_temps_state3, NULL },  // temps.layout:12
+	{ LAYOUT_TYPE_CHART, LAYOUT_TEMPS_SIGNAL_MAX_TEMP, 56, 4, 64, 2, 0, { 2, 0, 0, 0 }, 0, NULL, &layout_temps_state4, layout_temps_buffer4 },  // temps.layout:14
+	{ LAYOUT_TYPE_LABEL, LAYOUT_NO_SIGNAL, 0, 7, 0, 0, 0, { 0, 0, 0, 0 }, 0, layout_temps_text5, NULL, NULL },  // temps.layout:9
+	{ LAYOUT_TYPE_LABEL, LAYOUT_NO_SIGNAL, 56, 7, 0, 0, 0, { 0, 0, 0, 0 }, 0, layout_temps_text6, NULL, NULL },  // temps.layout:15
+};
+
+static uint8_t const CAL_PGM_DEF(layout_temps_signalStart[6]) = { 0, 0, 3, 3, 3, 3 };
+static uint8_t const CAL_PGM_DEF(layout_temps_signalItems[3]) = { 1, 3, 4 };
+
+LAYOUT_layout_t const CAL_PGM_DEF(LAYOUT_temps) = {
+	layout_temps_items, 7, 5, layout_temps_signalStart, layout_temps_signalItems
+};
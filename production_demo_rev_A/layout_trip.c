@@ -0,0 +1,38 @@
+// Generated by utils/layout/layout2c.rb from trip.layout, do not edit.
+
+#include "layout_trip.h"
+#include <stddef.h>
+#include <numfield_lib.h>
+#include <bar_lib.h>
+#include <gauge_lib.h>
+#include <chart_lib.h>
+
+static char const CAL_PGM_DEF(layout_trip_text0[]) = "TRIP";
+static char const CAL_PGM_DEF(layout_trip_text1[]) = "Start SOC:";
+static char const CAL_PGM_DEF(layout_trip_text2[]) = "%";
+static NUMFIELD_field_t layout_trip_state2;
+static char const CAL_PGM_DEF(layout_trip_text3[]) = "SOC now:";
+static char const CAL_PGM_DEF(layout_trip_text4[]) = "%";
+static NUMFIELD_field_t layout_trip_state4;
+static char const CAL_PGM_DEF(layout_trip_text5[]) = "Used:";
+static char const CAL_PGM_DEF(layout_trip_text6[]) = "%";
+static NUMFIELD_field_t layout_trip_state6;
+static BAR_bar_t layout_trip_state7;
+
+static LAYOUT_item_t const CAL_PGM_DEF(layout_trip_items[8]) = {
+	{ LAYOUT_TYPE_LABEL, LAYOUT_NO_SIGNAL, 0, 0, 0, 0, 0, { 0, 0, 0, 0 }, 0, layout_trip_text0, NULL, NULL },  // trip.layout:6
+	{ LAYOUT_TYPE_LABEL, LAYOUT_NO_SIGNAL, 0, 2, 0, 0, 0, { 0, 0, 0, 0 }, 0, layout_trip_text1, NULL, NULL },  // trip.layout:8
+	{ LAYOUT_TYPE_NUMBER, LAYOUT_TRIP_SIGNAL_SOC_START, 72, 2, 3, 0, NUMFIELD_ALIGN_RIGHT, { 0, 0, 0, 0 }, 1, layout_trip_text2, &layout_trip_state2, NULL },  // trip.layout:9
+	{ LAYOUT_TYPE_LABEL, LAYOUT_NO_SIGNAL, 0, 3, 0, 0, 0, { 0, 0, 0, 0 }, 0, layout_trip_text3, NULL, NULL },  // trip.layout:11
+	{ LAYOUT_TYPE_NUMBER, LAYOUT_TRIP_SIGNAL_SOC, 72, 3, 3, 0, NUMFIELD_ALIGN_RIGHT, { 0, 0, 0, 0 }, 1, layout_trip_text4, &layout_trip_state4, NULL },  // trip.layout:12
+	{ LAYOUT_TYPE_LABEL, LAYOUT_NO_SIGNAL, 0, 4, 0, 0, 0, { 0, 0, 0, 0 }, 0, layout_trip_text5, NULL, NULL },  // trip.layout:14
+	{ LAYOUT_TYPE_NUMBER, LAYOUT_TRIP_SIGNAL_SOC_USED, 72, 4, 3, 0, NUMFIELD_ALIGN_RIGHT, { 0, 0, 0, 0 }, 1, layout_trip_text6, &layout_trip_state6, NULL },  // trip.layout:15
+	{ LAYOUT_TYPE_BAR, LAYOUT_TRIP_SIGNAL_SOC_USED, 2, 50, 100, 8, BAR_STYLE_FRAME, { 5, 0, 0, 0 }, 100, NULL, &layout_trip_state7, NULL },  // trip.layout:17
+};
+
+static uint8_t const CAL_PGM_DEF(layout_trip_signalStart[6]) = { 0, 1, 1, 1, 2, 4 };
+static uint8_t const CAL_PGM_DEF(layout_trip_signalItems[4]) = { 4, 2, 6, 7 };
+
+LAYOUT_layout_t const CAL_PGM_DEF(LAYOUT_trip) = {
+	layout_trip_items, 8, 5, layout_trip_signalStart, layout_trip_signalItems
+};
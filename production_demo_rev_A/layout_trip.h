@@ -0,0 +1,15 @@
+// Generated by utils/layout/layout2c.rb from trip.layout, do not edit.
+#ifndef LAYOUT_TRIP_H
+#define LAYOUT_TRIP_H
+
+#include <layout_lib.h>
+
+#define LAYOUT_TRIP_SIGNAL_SOC 0
+#define LAYOUT_TRIP_SIGNAL_MAX_TEMP 1
+#define LAYOUT_TRIP_SIGNAL_MIN_VOLT 2
+#define LAYOUT_TRIP_SIGNAL_SOC_START 3
+#define LAYOUT_TRIP_SIGNAL_SOC_USED 4
+
+extern LAYOUT_layout_t const CAL_PGM(LAYOUT_trip);
+
+#endif
@@ -57,7 +57,8 @@
 #include <termfont_lib.h>
 #include <popup_lib.h>
 #include <s6b1713_driver.h>
-#include <avr/eeprom.h>
+#include <config_lib.h>
+#include <stddef.h>
 
 #define BUTTON_COUNT 1
 
@@ -88,28 +89,28 @@ void SetLcdRegister(WIDGETS_id_t userId, WIDGETS_integer_t const * data )
 {
 	uint8_t value = *data;
 	S6B1713_SetReferenceVoltage(value);
-	eeprom_write_word(8,value);
+	CONFIG_Set( CONFIG_CONTRAST, value );
 }
 
 void SetRedRegister(WIDGETS_id_t userId, WIDGETS_integer_t const * data )
 {
 	uint8_t value = *data;
 	BACKLIGHT_SetRed(value);
-	eeprom_write_word(10,value);
+	CONFIG_Set( CONFIG_RED, value );
 }
 
 void SetGreenRegister(WIDGETS_id_t userId, WIDGETS_integer_t const * data )
 {
 	uint8_t value = *data;
 	BACKLIGHT_SetGreen(value);
-	eeprom_write_word(12,value);
+	CONFIG_Set( CONFIG_GREEN, value );
 }
 
 void SetBlueRegister(WIDGETS_id_t userId, WIDGETS_integer_t const * data )
 {
 	uint8_t value = *data;
 	BACKLIGHT_SetBlue(value);
-	eeprom_write_word(14,value);
+	CONFIG_Set( CONFIG_BLUE, value );
 }
 
 void SetIntensityRegister(WIDGETS_id_t userId, WIDGETS_integer_t const * data )
@@ -117,7 +118,7 @@ void SetIntensityRegister(WIDGETS_id_t userId, WIDGETS_integer_t const * data )
 	uint8_t value = *data;
 	BACKLIGHT_Init();
 	BACKLIGHT_SetIntensity(value);
-	eeprom_write_word(16,value);
+	CONFIG_Set( CONFIG_INTENSITY, value );
 }
 
 
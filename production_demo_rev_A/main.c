@@ -61,9 +61,15 @@
 #include <picture_lib.h>
 #include <popup_lib.h>
 #include <power_driver.h>
+#include <uart_driver.h>
+#include <can_lib.h>
+#include <cansig_lib.h>
+#include <config_lib.h>
 
 #include "flashpics.h"
 #include "logo.h"
+#include "dashboard.h"
+#include "adapter.h"
 
 #include <stdio.h>
 #include <ctype.h>
@@ -79,12 +85,10 @@
 #define TERMINAL_TXBUFSIZE 16
 #define wdt_enable(WDTO_1S)
 
-#define BAUD 57600 
+#define RX_BATCH_SIZE 32  //!< Bytes taken from the UART per main loop pass.
 
 TIMING_event_t joystickCallbackEvent;
 
-volatile uint8_t urx;
-volatile uint8_t urx_recv;
 int Red=50;
 int Green=50;
 int Blue=50;
@@ -166,8 +170,7 @@ char const CAL_PGM_DEF(xpmHeader[]) =
 
 void SendChar( char ch )
 {
-	do { /* nothing */ } while ((UCSR1A & (1 << UDRE1)) == 0);
-	UDR1 = ch;
+	UART_PutChar( ch );
 }
 
 void DumpHeader( void )
@@ -211,42 +214,16 @@ void DumpScreen( void )
 }
 */
 
+// stdout goes through the transmit ring, printf only waits when it is full
 static int uart_putchar(char c, FILE *stream)
     {
 
       if (c == '\n')
         uart_putchar('\r', stream);
-      while(!(UCSR1A & (1<<UDRE1)));
-      UDR1 = c;
+      UART_PutChar( c );
       return 0;
     }
 
-SIGNAL(USART1_RX_vect)
-{
-  uint8_t s;
-
-  s = UCSR1A;
-  urx = UDR1;
-//  if (bit_is_clear(s, FE1)) {
-    urx_recv = 1;
-//  }
-}
-
-
-void USART_Init(void)
- {
-	
-  /* Enable receiver, transmitter and receive interrupt. */
-	UCSR1B = (1<<RXEN1)|(1<<TXEN1)|(1<<RXCIE1);
-//  UCSR1B |= 1<<RXCIE1;  // receive interrupt enabled
-
-//  UCSR1C |= 1<<1;
-//  UCSR1C |= 1<<2;
-  UBRR1H = 0x00;
-  UBRR1L = ((CPU_F/16)/BAUD)-1; // calculates the speed of serial transmission
-  
- }
-
 unsigned char ReceiveCharUart1(void) {
         
         // wait for data to be received
@@ -268,332 +245,121 @@ unsigned char ReceiveCharUart1_nonstop(void) {
 
 }
 
-char xtod(char c) {
- if (c>='0' && c<='9') return c-'0';
- if (c>='A' && c<='F') return c-'A'+10;
- if (c>='a' && c<='f') return c-'a'+10;
- return c=0;        // not Hex digit
-}
- 
-int HextoDec(char *hex, int l)
-{
-    if (*hex==0) return(l);
-    return HextoDec(hex+1, l*16+xtod(*hex)); // hex+1?
-}
- 
-int xstrtoi(char *hex)      // hex string to integer
-{
-    return HextoDec(hex,0);
-}
-
-char *substring(size_t start, size_t stop, const char *src, char *dst, size_t size)
-{
-   int count = stop - start;
-   if ( count >= --size )
-   {
-      count = size;
-   }
-   sprintf(dst, "%.*s", count, src + start);
-   return dst;
-}
-
-char *substr_NOT(const char *pstr, int start, int numchars)
-{
-	char *pnew;
-	int i;
-	for (i=start;i<start+numchars;i++)
-	{
-		strcat(pnew, pstr[i]);
-	}
-	strcat(pnew, '\n');
-
-	return pnew;
-}
-
-char *sort_of_works_substr(const char *pstr, int start, int numchars)
-{
-	char *pnew; // = malloc(numchars+1);
-	strncpy(pnew, pstr + start, numchars);
-	pnew[numchars] = '\0';
-	return pnew;
-}
-
-substr(const char *pstr, int start, int numchars, char *pnew)
-{
-	strncpy(pnew, pstr + start, numchars);
-	pnew[numchars] = '\0';
-	return pnew;
-}
- 
-/* parse an integer from a string */
-uint16_t get_num(char * s, char ** next, int8_t * err)
-{
-  char * e;
-  uint16_t n;
-
-  n = strtoul(s, &e, 0);
-  if (e == s) {
-    //printf("error: get_num(): can't scan arg: \"%s\"\n", s);
-    *next = s;
-    if (err)
-      *err = 1;
-    return 0xffff;
-  }
-
-  while (*e == '=')
-    e++;
-
-  *next = e;
-
-  if (err)
-    *err = 0;
-  
-  return n;
-}
 /*
- * decode and execute simple commands
+ * The CAN adapter is brought up and its frames decoded by adapter.c, and
+ * each complete frame is handed to its handler in the dispatch table.
+ * Frames with other IDs are dropped as soon as their ID has been read.
  */
-static char do_cmdbuf[20];
 int la=0;
 
-static __inline__ void do_cmd(char * s)
+// Layout of normal driving screen:
+// 
+//  |----------------|---------|
+//  | BIG NUMBERS    | BATTERY |
+//  |--------|-------|  ICON   |
+//  |3.45 V  | 31 C  |         |
+//  |--------------------------|
+// 
+// All this information is extracted right here from single CAN-frame with address 630h
+//
+// Summary values of interest @ CAN ID 630h
+//
+// Byte Type 			Desc 								Units per lsb
+// 0	unsigned char	Pack State of Charge				0.5%
+// 1	unsigned char	Pack State of Function (not in use)	n/a
+// 2	unsigned char	Pack State of Health				0.5%
+// 3	unsigned char	Max Pack Temperature				1 deg C
+// 4-5	short			Min Pack Voltage					1mV
+// 6-7	short			Max Pack Voltage					1mV
+//
+// Signals are decoded straight into dashboard signals. Min Pack Voltage
+// is big endian and passed on unscaled.
+static CANSIG_signal_t const CAL_PGM_DEF(summarySignals[]) = {
+	// Bit layout                      Mul Shift Offset Min  Max    Target
+	{ CANSIG_INTEL( 0, 8, 0 ),          1,  1,    0,     0,   100,   DASHBOARD_SIGNAL_SOC },
+	{ CANSIG_INTEL( 24, 8, 0 ),         1,  0,    0,     0,   255,   DASHBOARD_SIGNAL_MAX_TEMP },
+	{ CANSIG_MOTOROLA( 39, 16, 0 ),     1,  0,    0,     0,   32767, DASHBOARD_SIGNAL_MIN_VOLT }
+};
+
+static CANSIG_message_t const CAL_PGM_DEF(summaryMessage) = {
+	summarySignals, sizeof(summarySignals) / sizeof(summarySignals[0]), 6
+};
+
+static void HandleSummaryFrame( CAN_frame_t const * frame )
 {
-  static char * cmd = do_cmdbuf;
-  uint8_t       index;
-  char        * args, * p;
-  static char * can_addr;
-  int8_t rc;
-  int16_t value=0;
-  char * raw_byte;
-  short * raw_short;
-
-  if (s[0] == 0)
-    return;
-
-  /* parse the command line, seperating the command from arguments */
-  cmd[0] = 0;
-  index = 0;
-  while ((index < sizeof(do_cmdbuf)) && s[index] && (s[index] != '=')) {
-    cmd[index] = s[index];
-    index++;
-  }
-  if (index < sizeof(do_cmdbuf)) {
-    cmd[index] = 0;
-    args = &s[index];
-    while (*args && (*args == '='))
-      args++;
-    if (*args == 0)
-      args = NULL;
-  }
-  else {
-    cmd[sizeof(do_cmdbuf)-1] = 0;
-    args = NULL;
-  }
-
-  if (cmd[0] == 0) {
-    return;
-  }
-
-  // 11bit CAN frame ?
-  if (strcmp(cmd[0],'t') == 0) {
-	//char *pnew = malloc(4);
-	
-	char *pnew = MEM_ALLOC(4);
-
-	can_addr = substr(cmd, 1, 3, pnew);
+	if (frame->dlc < 6) {
+		return;
+	}
+	wdt_reset();
 
-//	printf("pnew: %s\n", pnew);
-//	printf("CMD: %s\n", cmd);
-//	printf("CAN ADDR: %s\n", can_addr);
-	
-	MEM_FREE(pnew);
-	
-	//can_addr = substring(1, 4, cmd, can_addr, sizeof can_addr);
+	CANSIG_Decode( &summaryMessage, frame, DASHBOARD_Update );
 
-	//can_addr = sort_of_works_substr(cmd, 1, 3);
-	
-	//free(pnew);
-
-
-	// Layout of normal driving screen:
-	// 
-	//  |----------------|---------|
-	//  | BIG NUMBERS    | BATTERY |
-	//  |--------|-------|  ICON   |
-	//  |3.45 V  | 31 C  |         |
-	//  |--------------------------|
-	// 
-	// All this information is extracted right here from single CAN-frame with address 630h
-	//
-	// Summary values of interest @ CAN ID 630h
-	//
-	// Byte Type 			Desc 								Units per lsb
-	// 0	unsigned char	Pack State of Charge				0.5%
-	// 1	unsigned char	Pack State of Function (not in use)	n/a
-	// 2	unsigned char	Pack State of Health				0.5%
-	// 3	unsigned char	Max Pack Temperature				1 deg C
-	// 4-5	short			Min Pack Voltage					1mV
-	// 6-7	short			Max Pack Voltage					1mV
-	 
-	if (strcmp(can_addr, "630") == 0) {
-		wdt_reset();
-		// SOC is byte 0 in 0.5% per LSB
-		// CAN-message is formatted as
-
-		// t63080011223344556677		
-		// ---------------------
-		//          111111111122
-		// 123456789012345678901
-		
-		// 
-		//printf("630!\n");
-		//char *pnew2 = malloc(3);
-		//raw_byte = substring(5, 7, cmd, raw_byte, sizeof raw_byte);
-		*pnew = MEM_ALLOC(3);
-
-		// SOC, byte 0
-		raw_byte = substr(cmd, 5, 2,pnew);
-		MEM_FREE(pnew);
-		value = xstrtoi(raw_byte);
-		value = value/2;	// 0.5 % per LSB
-		LCD_UpdateSOC(value);
-
-
-		// Max Pack temp, byte 3
-		raw_byte = substr(cmd, 11, 2,pnew);
-		MEM_FREE(pnew);
-		value = xstrtoi(raw_byte);
-		LCD_UpdateMaxTemp(value);
-		
-		char *spnew = MEM_ALLOC(6);
+	// Small status line for each frame received. Since ID 630 should
+	// be transmitted once per second, there should be small but visible
+	// blinking of few pixels in one of the corners of the display. 		
+	if (la == 0)
+	{
+			LCD_ClrLine(1,63,2,63);
+			la = 1;
+	} else {
+			LCD_SetLine(1,63,2,63);
+			la = 0;
+	}
+}
 
-		// Min Pack Voltage, byte 4-5
-		raw_short = substr(cmd, 13, 4,spnew);
-		MEM_FREE(spnew);
-		value = xstrtoi(raw_short);
-		LCD_UpdateMinVolt(value);
-		
-		// Small status line for each frame received. Since ID 630 should
-		// be transmitted once per second, there should be small but visible
-		// blinking of few pixels in one of the corners of the display. 		
-		if (la == 0)
-		{
-				LCD_ClrLine(1,63,2,63);
-				la = 1;
-		} else {
-				LCD_SetLine(1,63,2,63);
-				la = 0;
-		}
-		
-	} // Summary values end	
+// Screen contrast and color @ CAN ID 7DDh
+//
+// byte 0 contrast
+// byte 1 red
+// byte 2 green
+// byte 3 blue
+// byte 4 intensity
+static void HandleDisplayFrame( CAN_frame_t const * frame )
+{
+	if (frame->dlc < 5) {
+		return;
+	}
 
-	
-	// Screen contrast and color
-	if (strcmp(can_addr, "7DD") == 0) {
-		// CAN-message is formatted as
-
-		// t88050011223344		
-		// ---------------
-		//           11111
-		// 012345678901234
-
-		// byte 0 contrast
-		// byte 1 red
-		// byte 2 green
-		// byte 3 blue
-		// byte 4 intensity
-
-		// byte 0 contrast
-		*pnew = MEM_ALLOC(3);
-		raw_byte = substr(cmd, 5, 2,pnew);
-		MEM_FREE(pnew);
-		value = xstrtoi(raw_byte);		
-		eeprom_write_word(8, value);
-
-		// byte 1 red
-		*pnew = MEM_ALLOC(3);
-		raw_byte = substr(cmd, 7, 2,pnew);
-		MEM_FREE(pnew);
-		value = xstrtoi(raw_byte);		
-		eeprom_write_word(10, value);
-
-		// byte 2 green
-		*pnew = MEM_ALLOC(3);
-		raw_byte = substr(cmd, 9, 2,pnew);
-		MEM_FREE(pnew);
-		value = xstrtoi(raw_byte);		
-		eeprom_write_word(12, value);
-
-		// byte 3 blue
-		*pnew = MEM_ALLOC(3);
-		raw_byte = substr(cmd, 11, 2,pnew);
-		MEM_FREE(pnew);
-		value = xstrtoi(raw_byte);		
-		eeprom_write_word(14, value);
-
-		// byte 3 blue
-		*pnew = MEM_ALLOC(3);
-		raw_byte = substr(cmd, 13, 2,pnew);
-		MEM_FREE(pnew);
-		value = xstrtoi(raw_byte);		
-		eeprom_write_word(16, value);
-		
-		Contrast = eeprom_read_word((uint16_t*)8);
-		Red = eeprom_read_word((uint16_t*)10);
-		Green = eeprom_read_word((uint16_t*)12);
-		Blue = eeprom_read_word((uint16_t*)14);
-		Intensity = eeprom_read_word((uint16_t*)16);
+	// Settings are in config store order. The store commits them to
+	// EEPROM later, and a frame repeating the current settings is ignored.
+	bool changed = false;
+	for (uint8_t i = 0; i < 5; ++i) {
+		changed |= CONFIG_Set( CONFIG_CONTRAST + i, frame->data[i] );
+	}
+	if (changed == false) {
+		return;
+	}
 
-		BACKLIGHT_SetRGB( Red, Green, Blue );
-		BACKLIGHT_SetIntensity(Intensity);
+	Contrast = CONFIG_Get( CONFIG_CONTRAST );
+	Red = CONFIG_Get( CONFIG_RED );
+	Green = CONFIG_Get( CONFIG_GREEN );
+	Blue = CONFIG_Get( CONFIG_BLUE );
+	Intensity = CONFIG_Get( CONFIG_INTENSITY );
 
-		TERMFONT_DisplayString(".Display adjusted.", 7, 0);
-		
-		DELAY_MS(500);
-		
-		LCD_ClrBox(0,0,128,64);
+	BACKLIGHT_SetRGB( Red, Green, Blue );
+	BACKLIGHT_SetIntensity(Intensity);
 
-	} // Summary values end	
+	DASHBOARD_ShowMessage("Display\r\nadjusted", RTC_TICKS_PER_SECOND);
+}
 
-  }
+// Frame handlers by CAN ID, must be sorted by ID.
+static CAN_route_t const CAL_PGM_DEF(canRoutes[]) = {
+	{ CAN_STD(0x630), HandleSummaryFrame },
+	{ CAN_STD(0x7DD), HandleDisplayFrame }
+};
 
-  return;
-}
+static CAN_dispatch_t const CAL_PGM_DEF(canDispatch) = {
+	canRoutes, sizeof(canRoutes) / sizeof(canRoutes[0]),
+	NULL, 0
+};
 
 /*
- * accept characters and build a command line, when return is pressed,
- * pass the command to 'do_cmd()' 
+ * accept characters from the CAN adapter, frames are handled the moment
+ * they are complete
  */
-#define CMD_BUF_LEN 128
-static char recv_input_cmdbuf[CMD_BUF_LEN];
-
 void recv_input(uint8_t ch)
 {
-  static uint8_t idx=0;
-
-  if ((ch == '\r')||(ch == '\n')) {
-    //uart_putc('\n');
-    recv_input_cmdbuf[idx] = 0;
-    do_cmd(recv_input_cmdbuf);
-    //printf_P(s_prompt);
-    idx = 0;
-  }
-//  else if ((ch == '\b') && idx) {
-//    printf_P(s_bksp);
-//    if (idx > 0)
-//      idx--;
-//    recv_input_cmdbuf[idx] = 0;
-//  }
-  else {
-    //uart_putc(ch); // if we want echo, uncomment this
-    recv_input_cmdbuf[idx++] = ch;
-    if (idx == CMD_BUF_LEN) {
-      idx = 0;
-      recv_input_cmdbuf[idx] = 0;
-      //printf_P(s_invalid);
-      //printf_P(s_prompt);
-    }
-  }
+	ADAPTER_ProcessByte( ch );
 }
 	
 unsigned char USART_Receive( void ) 
@@ -625,9 +391,7 @@ CAL_MAIN()
 
 	DDRD |= (1 << PD4); PORTD &= ~(1 << PD4); // Turn on RS232.
 
-	USART_Init();
-
-	uint8_t ch;
+	uint8_t rxBatch[RX_BATCH_SIZE];
 
 	LCD_UpdateSOC(2);
         
@@ -673,22 +437,8 @@ CAL_MAIN()
 
 	LCD_UpdateSOC(9);
 
-	// Init CAN-adapter
-	// few returns to wake up the device
-	/*
-	printf("\r\r");
-	
-	// version query
-	printf("V\r");
-	
-	// auto poll/send = ON
-	printf("X1\r");
-	
-	printf("S6\r");	// (S)peed 500 kBit
-	
-	// Open the CAN channel
-	printf("O\r");	// (O)pen the CAN-bus
-	*/
+	// The CAN adapter is brought up by ADAPTER_Task from the main loop,
+	// without waiting here, see adapter.h.
 
 	LCD_UpdateSOC(10);
 
@@ -704,11 +454,18 @@ CAL_MAIN()
 
 	// init backlight
 	BACKLIGHT_Init();
-	Contrast = eeprom_read_word((uint16_t*)8);
-	Red = eeprom_read_word((uint16_t*)10);
-	Green = eeprom_read_word((uint16_t*)12);
-	Blue = eeprom_read_word((uint16_t*)14);
-	Intensity = eeprom_read_word((uint16_t*)16);
+	if (CONFIG_Init() == false) {
+		// No config record yet, take over the settings stored as words
+		// from EEPROM address 8 on by earlier firmware.
+		for (uint8_t i = 0; i < 5; ++i) {
+			CONFIG_Set( CONFIG_CONTRAST + i, eeprom_read_word((uint16_t*)(8 + 2 * i)) );
+		}
+	}
+	Contrast = CONFIG_Get( CONFIG_CONTRAST );
+	Red = CONFIG_Get( CONFIG_RED );
+	Green = CONFIG_Get( CONFIG_GREEN );
+	Blue = CONFIG_Get( CONFIG_BLUE );
+	Intensity = CONFIG_Get( CONFIG_INTENSITY );
 
 	BACKLIGHT_SetRGB( Red, Green, Blue );
 	BACKLIGHT_SetIntensity(Intensity);
@@ -731,7 +488,9 @@ CAL_MAIN()
 
 	DELAY_MS(500);
 */
-	LCD_ClrBox(0,0,128,64);
+	if (CAN_SetDispatchTable( &canDispatch ) == false) { UnknownError(); }
+	ADAPTER_Init();
+	DASHBOARD_Init();
 
 //	exit = false;	
 	/*
@@ -763,15 +522,15 @@ CAL_MAIN()
 
 	while (1)
  	{
-		if (urx_recv) 
-		{	
-			cli();
-            urx_recv = 0;
-            ch = urx;
-            sei();
+		// Drain received bytes in batches, the ring keeps filling
+		// from the interrupt while the dashboard draws.
+		FIFO_size_t const rxCount = UART_Read( rxBatch, RX_BATCH_SIZE );
+		for (FIFO_size_t i = 0; i < rxCount; ++i) {
             /* build a command line and execute commands when complete */
-            recv_input(ch);
+            recv_input(rxBatch[i]);
 		}
+		ADAPTER_Task();
+		DASHBOARD_Task();
 	}
 
 	CAL_MAIN_LAST();
@@ -0,0 +1,408 @@
+// This file has been prepared for Doxygen automatic documentation generation.
+/*! \file *********************************************************************
+ *
+ * \brief  Interrupt driven USART1 driver source file
+ *
+ *         The interrupt handler is the only producer of the receive ring
+ *         and the main loop the only consumer, so neither side disables
+ *         interrupts to move data. Only the statistics, which the handler
+ *         updates, are copied with interrupts disabled.
+ *
+ *         The transmit ring works the other way round, the writer being the
+ *         producer and the data register empty interrupt the consumer. The
+ *         interrupt is enabled after each write and disables itself when
+ *         the ring is empty. Dropping the oldest byte moves the consumer's
+ *         tail, so that alone is done with interrupts disabled.
+ *
+ *         The baud rate table is built by the preprocessor from the rates
+ *         themselves, and the build fails if CPU_F gives any of them only
+ *         approximately.
+ *
+ *****************************************************************************/
+
+#include "uart_driver.h"
+#include <string.h>
+#include <cal.h>
+#include <common.h>
+
+
+
+/********************************
+ * Private constants and defines
+ ********************************/
+
+#define UART_SREG_I 7  //!< Global interrupt enable bit in SREG.
+
+//! Baud rate table entry for a rate.
+#define UART_BAUD_SETTING(rate) { UART_BAUD_UBRR(rate), UART_BAUD_U2X(rate) ? (1 << U2X1) : 0x00 }
+
+#if !UART_BAUD_EXACT(2400) || !UART_BAUD_EXACT(9600) || !UART_BAUD_EXACT(19200) || \
+    !UART_BAUD_EXACT(38400) || !UART_BAUD_EXACT(57600) || !UART_BAUD_EXACT(115200) || \
+    !UART_BAUD_EXACT(230400) || !UART_BAUD_EXACT(460800) || !UART_BAUD_EXACT(921600)
+#error "CPU_F does not give exact divisors for all UART baud rates"
+#endif
+
+
+
+/*********************
+ * Types and typedefs
+ *********************/
+
+//! Register settings for one baud rate.
+typedef struct UART_baudSetting_struct
+{
+	uint16_t ubrr;  //!< Baud rate register value.
+	uint8_t u2x;  //!< UCSR1A value, U2X1 set for double speed.
+} UART_baudSetting_t;
+
+
+
+/********************
+ * Private variables
+ ********************/
+
+//! Register settings, in UART_baud_t order.
+static UART_baudSetting_t const CAL_PGM_DEF(UART_baudTable[UART_BAUD_COUNT]) = {
+	UART_BAUD_SETTING(2400),
+	UART_BAUD_SETTING(9600),
+	UART_BAUD_SETTING(19200),
+	UART_BAUD_SETTING(38400),
+	UART_BAUD_SETTING(57600),
+	UART_BAUD_SETTING(115200),
+	UART_BAUD_SETTING(230400),
+	UART_BAUD_SETTING(460800),
+	UART_BAUD_SETTING(921600)
+};
+
+static FIFO_ring_t UART_rxRing;  //!< Receive ring.
+static FIFO_data_t UART_rxBuffer[UART_RX_BUFFER_SIZE];  //!< Receive ring memory.
+static FIFO_ring_t UART_txRing;  //!< Transmit ring.
+static FIFO_data_t UART_txBuffer[UART_TX_BUFFER_SIZE];  //!< Transmit ring memory.
+static UART_txPolicy_t UART_txPolicy;  //!< What to do when transmit ring is full.
+static UART_baud_t UART_baud;  //!< Current baud rate.
+static bool volatile UART_txStarted;  //!< True once a byte has been sent, so TXC1 will be set again.
+static UART_stats_t volatile UART_stats;  //!< Driver statistics.
+static uint32_t volatile UART_baudReceived;  //!< Bytes received since the baud rate was set.
+static uint16_t volatile UART_baudErrors;  //!< Framing errors and data overruns since the baud rate was set.
+
+
+
+/*******************************
+ * Internal function prototypes
+ *******************************/
+
+//! Add one to a statistics counter without wrapping.
+static void UART_Count( uint16_t volatile * counter );
+//! Send next byte from transmit ring, disabling the interrupt when it is empty.
+static void UART_SendNext( void );
+//! Send by polling if interrupts are disabled, since the interrupt cannot.
+static void UART_PollTx( void );
+//! Program baud rate registers.
+static void UART_WriteBaud( UART_baud_t baud );
+
+
+
+/***************************
+ * Function implementations
+ ***************************/
+
+/*!
+ *  Both rings are emptied and the statistics cleared. Unknown baud rates
+ *  give 57600 baud.
+ *
+ * \param  baud  Baud rate
+ */
+void UART_Init( UART_baud_t baud )
+{
+	PRR1 &= ~(1 << PRUSART1);
+	UCSR1B = 0x00;
+
+	FIFO_RingInit( &UART_rxRing, UART_rxBuffer, UART_RX_BUFFER_SIZE );
+	FIFO_RingInit( &UART_txRing, UART_txBuffer, UART_TX_BUFFER_SIZE );
+	UART_txPolicy = UART_TX_BLOCK;
+	UART_txStarted = false;
+	UART_ResetStats();
+	UART_baudReceived = 0;
+	UART_baudErrors = 0;
+
+	UART_WriteBaud( (baud < UART_BAUD_COUNT) ? baud : UART_BAUD_57600 );
+	UCSR1C = (1 << UCSZ11) | (1 << UCSZ10);
+	UCSR1B = (1 << RXEN1) | (1 << TXEN1) | (1 << RXCIE1);
+}
+
+
+/*!
+ *  Waits until all queued bytes have been sent at the old rate. A byte
+ *  being received during the change is lost. The statistics keep counting,
+ *  only the error rate starts again, so UART_GetErrorRate tells how well
+ *  the new rate works.
+ *
+ * \param  baud  New baud rate
+ *
+ * \return  False if the baud rate is unknown and nothing was changed
+ */
+bool UART_SetBaud( UART_baud_t baud )
+{
+	if (baud >= UART_BAUD_COUNT) {
+		return false;
+	}
+
+	UART_Flush();
+	uint8_t const storedSREG = SREG;
+	CAL_disable_interrupt();
+	UART_WriteBaud( baud );
+	UART_baudReceived = 0;
+	UART_baudErrors = 0;
+	SREG = storedSREG;
+	return true;
+}
+
+
+UART_baud_t UART_GetBaud( void )
+{
+	return UART_baud;
+}
+
+
+uint32_t UART_GetBaudRate( UART_baud_t baud )
+{
+	if (baud >= UART_BAUD_COUNT) {
+		return 0;
+	}
+	uint32_t const divisor = ((CAL_pgm_read_byte( &UART_baudTable[baud].u2x ) != 0x00) ? 8UL : 16UL)
+	                       * (CAL_pgm_read_word( &UART_baudTable[baud].ubrr ) + 1UL);
+	return CPU_F / divisor;
+}
+
+
+/*!
+ *  Call often enough that the ring never fills, e.g. once per main loop
+ *  pass. At 57600 baud a full ring lasts about 22 ms, at 115200 baud 11 ms.
+ *
+ * \param  data     Where to save the bytes
+ * \param  maxSize  Max number of bytes to take
+ *
+ * \return  Number of bytes saved
+ */
+FIFO_size_t UART_Read( uint8_t * data, FIFO_size_t maxSize )
+{
+	return FIFO_RingGetBlock( &UART_rxRing, data, maxSize );
+}
+
+
+FIFO_size_t UART_GetRxCount( void )
+{
+	return FIFO_RingGetItemsUsed( &UART_rxRing );
+}
+
+
+void UART_SetTxPolicy( UART_txPolicy_t policy )
+{
+	UART_txPolicy = policy;
+}
+
+
+/*!
+ *  Must not be called from interrupt handlers that can interrupt another
+ *  writer, there is only one producer.
+ *
+ * \param  data  Byte to send
+ *
+ * \return  False if this byte or an older one was dropped because the ring was full
+ */
+bool UART_PutChar( uint8_t data )
+{
+	bool queued = true;
+	if (FIFO_RingIsFull( &UART_txRing )) {
+		if (UART_txPolicy == UART_TX_BLOCK) {
+			do {
+				UART_PollTx();
+			} while (FIFO_RingIsFull( &UART_txRing ));
+		} else if (UART_txPolicy == UART_TX_DROP) {
+			UART_Count( &UART_stats.txDropped );
+			return false;
+		} else {
+			uint8_t const storedSREG = SREG;
+			CAL_disable_interrupt();
+			if (FIFO_RingIsFull( &UART_txRing )) {
+				++UART_txRing.tail;
+				UART_Count( &UART_stats.txDropped );
+				queued = false;
+			}
+			SREG = storedSREG;
+		}
+	}
+
+	FIFO_RingQuickPut( &UART_txRing, data );
+	UART_Count( &UART_stats.txQueued );
+	UCSR1B |= (1 << UDRIE1);
+	return queued;
+}
+
+
+bool UART_Write( uint8_t const * data, FIFO_size_t size )
+{
+	bool queued = true;
+	while (size-- != 0) {
+		queued &= UART_PutChar( *data++ );
+	}
+	return queued;
+}
+
+
+FIFO_size_t UART_GetTxCount( void )
+{
+	return FIFO_RingGetItemsUsed( &UART_txRing );
+}
+
+
+/*!
+ *  Also waits for the last byte to leave the shift register, so the USART
+ *  can be reconfigured or powered down afterwards.
+ */
+void UART_Flush( void )
+{
+	while (FIFO_RingIsEmpty( &UART_txRing ) == false) {
+		UART_PollTx();
+	}
+	if (UART_txStarted) {
+		do { /* nothing */ } while ((UCSR1A & (1 << TXC1)) == 0x00);
+	}
+}
+
+
+void UART_GetStats( UART_stats_t * stats )
+{
+	uint8_t const storedSREG = SREG;
+	CAL_disable_interrupt();
+	*stats = UART_stats;
+	SREG = storedSREG;
+}
+
+
+void UART_ResetStats( void )
+{
+	uint8_t const storedSREG = SREG;
+	CAL_disable_interrupt();
+	memset( (void *) &UART_stats, 0x00, sizeof(UART_stats) );
+	SREG = storedSREG;
+}
+
+
+/*!
+ *  Data overruns are counted once per event, though several bytes may
+ *  have been lost, so the rate is a lower bound.
+ *
+ * \return  Error rate in 0.01 %, 0 if nothing has been received at this rate
+ */
+uint16_t UART_GetErrorRate( void )
+{
+	uint8_t const storedSREG = SREG;
+	CAL_disable_interrupt();
+	uint32_t const received = UART_baudReceived;
+	uint16_t const errors = UART_baudErrors;
+	SREG = storedSREG;
+	if (received == 0) {
+		return 0;
+	}
+
+	uint32_t const rate = (uint32_t) errors * 10000UL / received;
+	return (rate > UINT16_MAX) ? UINT16_MAX : (uint16_t) rate;
+}
+
+
+/*!
+ *  The status flags belong to the byte in UDR1, so they are read first.
+ *  A data overrun means earlier bytes were lost, but this one is good.
+ */
+CAL_ISR( USART1_RX_vect )
+{
+	uint8_t const status = UCSR1A;
+	uint8_t const data = UDR1;
+
+	if (UART_stats.received != UINT32_MAX) {
+		++UART_stats.received;
+	}
+	if (UART_baudReceived != UINT32_MAX) {
+		++UART_baudReceived;
+	}
+	if ((status & (1 << DOR1)) != 0x00) {
+		UART_Count( &UART_stats.dataOverruns );
+		UART_Count( &UART_baudErrors );
+	}
+	if ((status & (1 << FE1)) != 0x00) {
+		UART_Count( &UART_stats.frameErrors );
+		UART_Count( &UART_baudErrors );
+		return;
+	}
+
+	if (FIFO_RingIsFull( &UART_rxRing )) {
+		UART_Count( &UART_stats.overruns );
+		return;
+	}
+	FIFO_RingQuickPut( &UART_rxRing, data );
+
+	FIFO_size_t const used = FIFO_RingGetItemsUsed( &UART_rxRing );
+	if (used > UART_stats.highWater) {
+		UART_stats.highWater = used;
+	}
+}
+
+
+/*!
+ *  Enabling the interrupt is not atomic, so it can be enabled again just
+ *  after the interrupt disabled itself. It then runs once more, finds the
+ *  ring empty and disables itself again.
+ */
+CAL_ISR( USART1_UDRE_vect )
+{
+	UART_SendNext();
+}
+
+
+static void UART_SendNext( void )
+{
+	if (FIFO_RingIsEmpty( &UART_txRing )) {
+		UCSR1B &= ~(1 << UDRIE1);
+		return;
+	}
+
+	uint8_t data;
+	FIFO_RingQuickGet( &UART_txRing, data );
+	// Clear transmit complete, for UART_Flush. Writing back the other flags
+	// would clear them too, so keep only U2X1.
+	UCSR1A = (UCSR1A & (1 << U2X1)) | (1 << TXC1);
+	UDR1 = data;
+	UART_txStarted = true;
+}
+
+
+static void UART_PollTx( void )
+{
+	if (((SREG & (1 << UART_SREG_I)) == 0x00) && ((UCSR1A & (1 << UDRE1)) != 0x00)) {
+		UART_SendNext();
+	}
+}
+
+
+/*!
+ *  Call with interrupts disabled or the USART idle, the two bytes of UBRR1
+ *  are written separately.
+ */
+static void UART_WriteBaud( UART_baud_t baud )
+{
+	UBRR1 = CAL_pgm_read_word( &UART_baudTable[baud].ubrr );
+	UCSR1A = CAL_pgm_read_byte( &UART_baudTable[baud].u2x );
+	UART_baud = baud;
+}
+
+
+static void UART_Count( uint16_t volatile * counter )
+{
+	if (*counter != UINT16_MAX) {
+		++(*counter);
+	}
+}
+
+
+// end of file
@@ -0,0 +1,140 @@
+// This file has been prepared for Doxygen automatic documentation generation.
+/*! \file *********************************************************************
+ *
+ * \brief  Interrupt driven USART1 driver header file
+ *
+ *         Received bytes are put into a lock-free ring buffer by the receive
+ *         interrupt, so nothing is lost while the main loop is busy drawing,
+ *         as long as it drains the ring before it fills up. The main loop
+ *         takes the bytes out in batches with UART_Read.
+ *
+ *         Bytes to send are put into a second ring and sent by the data
+ *         register empty interrupt, so writing returns at once unless the
+ *         ring is full. What happens then is set with UART_SetTxPolicy:
+ *         wait for space, drop the new byte, or drop the oldest queued byte.
+ *         With interrupts disabled, waiting sends bytes by polling instead.
+ *
+ *         The driver counts bytes dropped because the ring was full, bytes
+ *         lost in the USART itself (data overrun) and bytes with framing
+ *         errors, and keeps the highest ring fill level seen, so the ring
+ *         size and main loop latency can be checked on a running system.
+ *
+ *         Baud rates are taken from a table of divisors that give the rate
+ *         exactly, checked at compile time against CPU_F. Double speed mode
+ *         (U2X) is only used for rates the normal mode cannot reach, since
+ *         it samples each bit less often and tolerates less clock error.
+ *         The rate can be changed at run time, e.g. after telling the other
+ *         end to change it too, and the error rate at the new speed is then
+ *         available from UART_GetErrorRate. The statistics are not cleared
+ *         by a change, so they cover all rates used.
+ *
+ *****************************************************************************/
+#ifndef UART_DRIVER_H
+#define UART_DRIVER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <fifo_lib.h>
+
+
+
+/************************
+ * Constants and defines
+ ************************/
+
+#define UART_RX_BUFFER_SIZE 128  //!< Receive ring size, a power of two, at most 128.
+#define UART_TX_BUFFER_SIZE 128  //!< Transmit ring size, a power of two, at most 128.
+
+//! Baud rates with exact divisors, see UART_BAUD_EXACT.
+enum UART_baud_enum
+{
+	UART_BAUD_2400,
+	UART_BAUD_9600,
+	UART_BAUD_19200,
+	UART_BAUD_38400,
+	UART_BAUD_57600,
+	UART_BAUD_115200,
+	UART_BAUD_230400,
+	UART_BAUD_460800,
+	UART_BAUD_921600,
+	UART_BAUD_COUNT  //!< Number of baud rates, not a baud rate.
+};
+
+//! True if the baud rate needs double speed mode to be reached exactly.
+#define UART_BAUD_U2X(rate) ((CPU_F % (16UL * (rate))) != 0)
+//! Divisor per bit, 8 in double speed mode and 16 otherwise.
+#define UART_BAUD_DIVISOR(rate) (UART_BAUD_U2X(rate) ? 8UL : 16UL)
+//! Baud rate register value for a baud rate.
+#define UART_BAUD_UBRR(rate) (CPU_F / (UART_BAUD_DIVISOR(rate) * (rate)) - 1)
+//! True if the baud rate can be reached exactly with a valid register value.
+#define UART_BAUD_EXACT(rate) (((CPU_F % (UART_BAUD_DIVISOR(rate) * (rate))) == 0) && \
+                               (CPU_F / (UART_BAUD_DIVISOR(rate) * (rate)) >= 1) && \
+                               (UART_BAUD_UBRR(rate) <= 4095))
+
+//! What to do when writing to a full transmit ring.
+enum UART_txPolicy_enum
+{
+	UART_TX_BLOCK,  //!< Wait until there is space, nothing is lost.
+	UART_TX_DROP,  //!< Drop the byte being written.
+	UART_TX_DROP_OLDEST  //!< Drop the oldest queued byte to make space.
+};
+
+
+
+/*********************
+ * Types and typedefs
+ *********************/
+
+typedef uint8_t UART_baud_t;  //!< One of UART_BAUD_* baud rates.
+typedef uint8_t UART_txPolicy_t;  //!< One of UART_TX_* policies.
+
+//! Driver statistics. Counters saturate instead of wrapping.
+typedef struct UART_stats_struct
+{
+	uint16_t overruns;  //!< Bytes dropped because the receive ring was full.
+	uint16_t dataOverruns;  //!< Times the USART lost bytes before the interrupt ran (DOR1).
+	uint16_t frameErrors;  //!< Bytes dropped because of a framing error (FE1).
+	uint32_t received;  //!< Bytes received by the USART, including those with errors.
+	FIFO_size_t highWater;  //!< Most bytes waiting in the receive ring at once.
+	uint16_t txQueued;  //!< Bytes put into the transmit ring.
+	uint16_t txDropped;  //!< Bytes dropped because the transmit ring was full.
+} UART_stats_t;
+
+
+
+/**********************
+ * Function prototypes
+ **********************/
+
+//! Set up USART1 for 8N1 at the given baud rate, with receive interrupt enabled and blocking transmit.
+void UART_Init( UART_baud_t baud );
+//! Change baud rate after sending all queued bytes. Returns false for unknown baud rates.
+bool UART_SetBaud( UART_baud_t baud );
+//! Get current baud rate.
+UART_baud_t UART_GetBaud( void );
+//! Get baud rate in bits per second.
+uint32_t UART_GetBaudRate( UART_baud_t baud );
+//! Select what writing to a full transmit ring does.
+void UART_SetTxPolicy( UART_txPolicy_t policy );
+//! Queue one byte for sending. Returns false if a byte was dropped.
+bool UART_PutChar( uint8_t data );
+//! Queue bytes for sending. Returns false if any byte was dropped.
+bool UART_Write( uint8_t const * data, FIFO_size_t size );
+//! Get number of bytes waiting to be sent.
+FIFO_size_t UART_GetTxCount( void );
+//! Wait until all queued bytes have been sent.
+void UART_Flush( void );
+//! Take up to maxSize received bytes. Returns number of bytes taken.
+FIFO_size_t UART_Read( uint8_t * data, FIFO_size_t maxSize );
+//! Get number of received bytes waiting.
+FIFO_size_t UART_GetRxCount( void );
+//! Copy driver statistics.
+void UART_GetStats( UART_stats_t * stats );
+//! Clear driver statistics. The error rate is kept.
+void UART_ResetStats( void );
+//! Get framing errors and data overruns per 10000 received bytes since the baud rate was set.
+uint16_t UART_GetErrorRate( void );
+
+
+#endif
+// end of file
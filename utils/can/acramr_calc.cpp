@@ -0,0 +1,627 @@
+/*
+ * Acceptance filter calculator for SJA1000 based adapters (Lawicell CAN232
+ * and CANUSB), replacing the combination walk of the old acramr_calc.c.
+ *
+ * Finds the acceptance code and mask (ACR/AMR) that let through all wanted
+ * 11-bit IDs and as few other IDs seen on the bus as possible. The result
+ * is optimal, not a heuristic.
+ *
+ * Build: c++ -O2 -std=c++17 -pthread acramr_calc.cpp -o acramr_calc
+ *
+ * usage: acramr_calc [options] id...
+ *
+ *   -b <file>  IDs on the bus, numbers or SLCAN frame lines, e.g. a log of
+ *              the adapter output. IDs not on the bus cost nothing when let
+ *              through. Without it every other ID counts as on the bus.
+ *   -1         Single filter mode.
+ *   -2         Dual filter mode, the default. Lawicell adapters use it.
+ *   -j <n>     Worker threads, default one per core.
+ *   -q         Print only the registers.
+ *   -x         Benchmark on synthetic 100, 500 and 2000 ID buses.
+ *
+ * IDs are 0x prefixed hex or decimal, as before. Example, same IDs as the
+ * old tool:
+ *
+ *   acramr_calc 0x3cb 0x3ca 0x3c8 0x348 0x3b
+ *
+ *   Dual filter, 5 IDs wanted, 2048 on bus
+ *     ACR = 07606900    AMR = 001F107F    (M07606900 m001F107F)
+ *     9 IDs accepted, 4 not wanted
+ *     accepted :: 03B  348  349  34A  34B  3C8  3C9  3CA  3CB
+ *     not wanted :: 349  34A  34B  3C9
+ *
+ * The registers can be checked with acramr_rev_calc. Like CAN_ComputeFilter
+ * in can_lib, RTR and data bits are don't care, so remote frames and all
+ * data pass.
+ *
+ * Search: a filter matches a cube, the IDs that agree with a code on the
+ * bits not masked. In single mode the only choice is the smallest cube
+ * holding the wanted IDs. In dual mode every cube that is the smallest one
+ * holding the wanted IDs inside it is tried as the first filter, 3^11 cubes
+ * at most, and the second filter is then the smallest cube holding the rest.
+ * IDs are kept as 2048-bit sets, so cubes are counted with a few popcounts
+ * whatever the number of IDs. A first filter that alone lets through more
+ * unwanted IDs than the best pair found so far is dropped before the second
+ * is built. Masks are shared out to the worker threads, which share the
+ * best cost for pruning.
+ *
+ * Ties go to the pair accepting fewer IDs in total, so new IDs appearing on
+ * the bus are less likely to pass, then to the lower registers, so the
+ * answer does not depend on the number of threads.
+ */
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cctype>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+const int ID_BITS = 11;
+const int ID_COUNT = 1 << ID_BITS;
+const int WORD_BITS = 64;
+const int LOW_BITS = 6;  // ID bits inside a word.
+const int WORDS = ID_COUNT / WORD_BITS;
+const uint32_t ID_MASK = ID_COUNT - 1;
+const uint32_t LOW_MASK = WORD_BITS - 1;
+
+// Register layout, see the SJA1000 data sheet. The ID is followed by RTR
+// and data bits, all don't care here.
+const int SINGLE_ID_SHIFT = 21;
+const uint32_t SINGLE_DONT_CARE = 0x001FFFFFUL;
+const int DUAL_ID_SHIFT = 5;  // Within each 16-bit half.
+const uint32_t DUAL_DONT_CARE = 0x1F;
+
+typedef std::array<uint64_t, WORDS> IdSet;
+
+// A filter: IDs with (id & ~dontCare) == code.
+struct Cube
+{
+	uint32_t code = 0;
+	uint32_t dontCare = 0;
+};
+
+struct Problem
+{
+	IdSet wanted{};
+	IdSet bus{};  // Includes the wanted IDs.
+	int wantedCount = 0;
+	int busCount = 0;
+};
+
+struct Solution
+{
+	Cube filter[2];
+	long rejected = 0;  // Unwanted bus IDs let through, the cost.
+	long accepted = 0;  // All IDs let through, on the bus or not.
+	uint64_t key = 0;  // Registers, for tie-breaking.
+	bool valid = false;
+};
+
+struct Stats
+{
+	long cubes = 0;  // First filter candidates holding wanted IDs.
+	long pruned = 0;  // Candidates dropped on their own cost.
+};
+
+// Bits of a word that match a cube in the low ID bits, by low code and
+// low don't care bits.
+uint64_t lowPattern[WORD_BITS][WORD_BITS];
+// Bits of a word that have a low ID bit set.
+uint64_t lowBit[LOW_BITS];
+
+void InitTables()
+{
+	for (uint32_t dontCare = 0; dontCare < WORD_BITS; ++dontCare) {
+		for (uint32_t code = 0; code < WORD_BITS; ++code) {
+			uint64_t pattern = 0;
+			for (uint32_t id = 0; id < WORD_BITS; ++id) {
+				if ((id & ~dontCare) == (code & ~dontCare)) {
+					pattern |= 1ULL << id;
+				}
+			}
+			lowPattern[dontCare][code] = pattern;
+		}
+	}
+	for (int bit = 0; bit < LOW_BITS; ++bit) {
+		lowBit[bit] = 0;
+		for (uint32_t id = 0; id < WORD_BITS; ++id) {
+			if ((id & (1U << bit)) != 0) {
+				lowBit[bit] |= 1ULL << id;
+			}
+		}
+	}
+}
+
+[[noreturn]] void Fail( const std::string & where, const std::string & text )
+{
+	std::fprintf( stderr, "%s: %s\n", where.c_str(), text.c_str() );
+	std::exit( 1 );
+}
+
+void Add( IdSet & set, uint32_t id )
+{
+	set[id / WORD_BITS] |= 1ULL << (id % WORD_BITS);
+}
+
+bool Has( const IdSet & set, uint32_t id )
+{
+	return (set[id / WORD_BITS] & (1ULL << (id % WORD_BITS))) != 0;
+}
+
+int Count( const IdSet & set )
+{
+	int count = 0;
+	for (uint64_t word : set) {
+		count += __builtin_popcountll( word );
+	}
+	return count;
+}
+
+long CubeSize( const Cube & cube )
+{
+	return 1L << __builtin_popcount( cube.dontCare );
+}
+
+// Calls visit( word, pattern ) for each word of the set a cube touches.
+template <typename Visit>
+void ForEachWord( const Cube & cube, Visit visit )
+{
+	uint64_t const pattern = lowPattern[cube.dontCare & LOW_MASK][cube.code & LOW_MASK];
+	uint32_t const highDontCare = cube.dontCare >> LOW_BITS;
+	uint32_t const highCode = cube.code >> LOW_BITS;
+	uint32_t high = 0;
+	do {
+		visit( highCode | high, pattern );
+		high = (high - highDontCare) & highDontCare;  // Next subset of the don't care bits.
+	} while (high != 0);
+}
+
+int CountIn( const IdSet & set, const Cube & cube )
+{
+	int count = 0;
+	ForEachWord( cube, [&]( uint32_t word, uint64_t pattern ) {
+		count += __builtin_popcountll( set[word] & pattern );
+	} );
+	return count;
+}
+
+bool Intersect( const Cube & a, const Cube & b, Cube & both )
+{
+	if (((a.code ^ b.code) & ~a.dontCare & ~b.dontCare) != 0) {
+		return false;
+	}
+	both.code = (a.code | b.code) & ~(a.dontCare & b.dontCare);
+	both.dontCare = a.dontCare & b.dontCare;
+	return true;
+}
+
+// Smallest cube holding the IDs of a set, false if there are none.
+bool Bound( const IdSet & set, Cube & cube )
+{
+	uint32_t andIds = ID_MASK;
+	uint32_t orIds = 0;
+	bool found = false;
+	for (uint32_t word = 0; word < WORDS; ++word) {
+		uint64_t const ids = set[word];
+		if (ids == 0) {
+			continue;
+		}
+		uint32_t andLow = 0;
+		uint32_t orLow = 0;
+		for (int bit = 0; bit < LOW_BITS; ++bit) {
+			if ((ids & ~lowBit[bit]) == 0) {
+				andLow |= 1U << bit;
+			}
+			if ((ids & lowBit[bit]) != 0) {
+				orLow |= 1U << bit;
+			}
+		}
+		found = true;
+		andIds &= (word << LOW_BITS) | andLow;
+		orIds |= (word << LOW_BITS) | orLow;
+	}
+	if (!found) {
+		return false;
+	}
+	cube.code = andIds;
+	cube.dontCare = andIds ^ orIds;
+	return true;
+}
+
+uint32_t SingleCode( const Cube & cube )
+{
+	return cube.code << SINGLE_ID_SHIFT;
+}
+
+uint32_t SingleMask( const Cube & cube )
+{
+	return (cube.dontCare << SINGLE_ID_SHIFT) | SINGLE_DONT_CARE;
+}
+
+uint32_t DualCode( const Solution & solution )
+{
+	return (solution.filter[0].code << (16 + DUAL_ID_SHIFT)) | (solution.filter[1].code << DUAL_ID_SHIFT);
+}
+
+uint32_t DualMask( const Solution & solution )
+{
+	return (((solution.filter[0].dontCare << DUAL_ID_SHIFT) | DUAL_DONT_CARE) << 16) | (solution.filter[1].dontCare << DUAL_ID_SHIFT) | DUAL_DONT_CARE;
+}
+
+// Fills in the cost of a filter pair, lower of the two first.
+Solution MakeSolution( const Problem & problem, Cube first, Cube second )
+{
+	uint32_t const firstKey = (first.code << ID_BITS) | first.dontCare;
+	uint32_t const secondKey = (second.code << ID_BITS) | second.dontCare;
+	if (secondKey < firstKey) {
+		std::swap( first, second );
+	}
+
+	Solution solution;
+	solution.filter[0] = first;
+	solution.filter[1] = second;
+	solution.valid = true;
+	solution.key = ((uint64_t) DualCode( solution ) << 32) | DualMask( solution );
+
+	long onBus = CountIn( problem.bus, first );
+	solution.accepted = CubeSize( first );
+	if (firstKey != secondKey) {
+		onBus += CountIn( problem.bus, second );
+		solution.accepted += CubeSize( second );
+		Cube both;
+		if (Intersect( first, second, both )) {
+			onBus -= CountIn( problem.bus, both );
+			solution.accepted -= CubeSize( both );
+		}
+	}
+	solution.rejected = onBus - problem.wantedCount;
+	return solution;
+}
+
+bool Better( const Solution & a, const Solution & b )
+{
+	if (!b.valid) {
+		return a.valid;
+	}
+	if (a.rejected != b.rejected) {
+		return a.rejected < b.rejected;
+	}
+	if (a.accepted != b.accepted) {
+		return a.accepted < b.accepted;
+	}
+	return a.key < b.key;
+}
+
+Solution SolveSingle( const Problem & problem )
+{
+	Cube cube;
+	Bound( problem.wanted, cube );
+	return MakeSolution( problem, cube, cube );
+}
+
+// Tries every first filter with the given don't care bits.
+void SearchMask( const Problem & problem, uint32_t dontCare, std::atomic<long> & bestRejected, Solution & best, Stats & stats )
+{
+	uint32_t const fixed = ID_MASK & ~dontCare;
+	uint32_t code = 0;
+	do {
+		Cube const first = { code, dontCare };
+		code = (code - fixed) & fixed;  // Next code, subsets of the fixed bits.
+
+		IdSet inside{};
+		IdSet outside = problem.wanted;
+		int wantedInside = 0;
+		ForEachWord( first, [&]( uint32_t word, uint64_t pattern ) {
+			inside[word] = problem.wanted[word] & pattern;
+			outside[word] &= ~pattern;
+			wantedInside += __builtin_popcountll( inside[word] );
+		} );
+		if (wantedInside == 0) {
+			continue;
+		}
+		++stats.cubes;
+
+		// A cube larger than its wanted IDs need is never better than the
+		// smallest one, which is tried on its own.
+		Cube tight;
+		Bound( inside, tight );
+		if (tight.dontCare != dontCare) {
+			continue;
+		}
+
+		long const firstRejected = CountIn( problem.bus, first ) - wantedInside;
+		if (firstRejected > bestRejected.load( std::memory_order_relaxed )) {
+			++stats.pruned;
+			continue;
+		}
+
+		Cube second = first;
+		Bound( outside, second );
+		Solution const solution = MakeSolution( problem, first, second );
+		if (Better( solution, best )) {
+			best = solution;
+			long current = bestRejected.load( std::memory_order_relaxed );
+			while (solution.rejected < current && !bestRejected.compare_exchange_weak( current, solution.rejected )) {
+			}
+		}
+	} while (code != 0);
+}
+
+Solution SolveDual( const Problem & problem, int threads, Stats & stats )
+{
+	// Both filters on the smallest cube holding all is a start for pruning.
+	Solution const single = SolveSingle( problem );
+	std::atomic<long> bestRejected( single.rejected );
+	std::atomic<uint32_t> nextMask( 0 );
+
+	// Small masks first, they give low costs early.
+	std::vector<uint32_t> masks( ID_COUNT );
+	for (uint32_t mask = 0; mask < ID_COUNT; ++mask) {
+		masks[mask] = mask;
+	}
+	std::stable_sort( masks.begin(), masks.end(), []( uint32_t a, uint32_t b ) {
+		return __builtin_popcount( a ) < __builtin_popcount( b );
+	} );
+
+	std::vector<Solution> bests( threads, single );
+	std::vector<Stats> workerStats( threads );
+	std::vector<std::thread> workers;
+	for (int worker = 0; worker < threads; ++worker) {
+		workers.emplace_back( [&, worker]() {
+			for (uint32_t index = nextMask++; index < ID_COUNT; index = nextMask++) {
+				SearchMask( problem, masks[index], bestRejected, bests[worker], workerStats[worker] );
+			}
+		} );
+	}
+
+	Solution best = single;
+	for (int worker = 0; worker < threads; ++worker) {
+		workers[worker].join();
+		if (Better( bests[worker], best )) {
+			best = bests[worker];
+		}
+		stats.cubes += workerStats[worker].cubes;
+		stats.pruned += workerStats[worker].pruned;
+	}
+	return best;
+}
+
+bool ParseId( const std::string & text, uint32_t & id )
+{
+	char * end = nullptr;
+	bool const hex = text.size() > 2 && text[0] == '0' && (text[1] == 'x' || text[1] == 'X');
+	unsigned long const value = std::strtoul( text.c_str(), &end, hex ? 16 : 10 );
+	if (text.empty() || *end != '\0') {
+		return false;
+	}
+	id = value;
+	return value <= ID_MASK;
+}
+
+// Reads bus IDs: numbers, or SLCAN lines of which only 't' and 'r' frames
+// are used.
+void ReadBus( const std::string & fileName, Problem & problem )
+{
+	std::ifstream file( fileName );
+	if (!file) {
+		Fail( fileName, "cannot open" );
+	}
+	std::string line;
+	int lineNumber = 0;
+	while (std::getline( file, line, '\n' )) {
+		++lineNumber;
+		std::istringstream words( line );
+		std::string word;
+		while (words >> word) {
+			// SLCAN lines may be CR separated on one line.
+			for (size_t start = 0; start < word.size(); ) {
+				size_t end = word.find( '\r', start );
+				if (end == std::string::npos) {
+					end = word.size();
+				}
+				std::string const token = word.substr( start, end - start );
+				start = end + 1;
+				uint32_t id;
+				if (token.empty() || token[0] == 'T' || token[0] == 'R') {
+					continue;
+				}
+				if (token[0] == 't' || token[0] == 'r') {
+					if (token.size() < 4 || !ParseId( "0x" + token.substr( 1, 3 ), id )) {
+						Fail( fileName + ":" + std::to_string( lineNumber ), "bad frame '" + token + "'" );
+					}
+				} else if (!ParseId( token, id )) {
+					if (!std::isdigit( (unsigned char) token[0] )) {
+						continue;  // Adapter answers and other text.
+					}
+					Fail( fileName + ":" + std::to_string( lineNumber ), "bad ID '" + token + "', 11-bit IDs only" );
+				}
+				Add( problem.bus, id );
+			}
+		}
+	}
+}
+
+void PrintIds( const char * title, const Problem & problem, const Solution & solution, bool unwantedOnly )
+{
+	std::printf( "  %s ::", title );
+	for (uint32_t id = 0; id < ID_COUNT; ++id) {
+		bool const inside = ((id & ~solution.filter[0].dontCare) == solution.filter[0].code) || ((id & ~solution.filter[1].dontCare) == solution.filter[1].code);
+		if (inside && Has( problem.bus, id ) && (!unwantedOnly || !Has( problem.wanted, id ))) {
+			std::printf( " %03X ", (unsigned) id );
+		}
+	}
+	std::printf( "\n" );
+}
+
+void Print( const Problem & problem, const Solution & solution, bool dual, bool quiet )
+{
+	uint32_t const code = dual ? DualCode( solution ) : SingleCode( solution.filter[0] );
+	uint32_t const mask = dual ? DualMask( solution ) : SingleMask( solution.filter[0] );
+	if (quiet) {
+		std::printf( "ACR = %08lX    AMR = %08lX\n", (unsigned long) code, (unsigned long) mask );
+		return;
+	}
+	std::printf( "%s filter, %d IDs wanted, %d on bus\n", dual ? "Dual" : "Single", problem.wantedCount, problem.busCount );
+	std::printf( "  ACR = %08lX    AMR = %08lX    (M%08lX m%08lX)\n", (unsigned long) code, (unsigned long) mask, (unsigned long) code, (unsigned long) mask );
+	std::printf( "  %ld IDs accepted, %ld not wanted\n", solution.rejected + problem.wantedCount, solution.rejected );
+	PrintIds( "accepted", problem, solution, false );
+	if (solution.rejected > 0) {
+		PrintIds( "not wanted", problem, solution, true );
+	}
+}
+
+double Milliseconds( std::chrono::steady_clock::time_point start )
+{
+	return std::chrono::duration<double, std::milli>( std::chrono::steady_clock::now() - start ).count();
+}
+
+// Random buses with a tenth of the IDs wanted, either scattered over the
+// bus or in two runs of neighbouring bus IDs, as from two devices. Solved
+// with one thread and with all, checking both give the same answer.
+void Benchmark( int threads )
+{
+	std::mt19937 random( 2011 );
+	std::printf( "  bus  wanted  single  dual    cubes  pruned   1 thread  %2d threads\n", threads );
+	for (int busCount : { 100, 500, 2000 }) {
+		for (bool scattered : { true, false }) {
+			std::vector<uint32_t> ids( ID_COUNT );
+			for (uint32_t id = 0; id < ID_COUNT; ++id) {
+				ids[id] = id;
+			}
+			std::shuffle( ids.begin(), ids.end(), random );
+			ids.resize( busCount );
+
+			int const wantedCount = busCount / 10;
+			std::vector<uint32_t> wanted( ids.begin(), ids.begin() + wantedCount );
+			if (!scattered) {
+				std::sort( ids.begin(), ids.end() );
+				int const run = wantedCount / 2;
+				int const first = random() % (busCount - run);
+				int const second = random() % (busCount - run);
+				wanted.assign( ids.begin() + first, ids.begin() + first + run );
+				wanted.insert( wanted.end(), ids.begin() + second, ids.begin() + second + run );
+			}
+
+			Problem problem;
+			for (uint32_t id : ids) {
+				Add( problem.bus, id );
+			}
+			for (uint32_t id : wanted) {
+				Add( problem.wanted, id );
+			}
+			problem.wantedCount = Count( problem.wanted );
+			problem.busCount = Count( problem.bus );
+
+			Stats stats;
+			auto start = std::chrono::steady_clock::now();
+			Solution const one = SolveDual( problem, 1, stats );
+			double const oneTime = Milliseconds( start );
+
+			Stats allStats;
+			start = std::chrono::steady_clock::now();
+			Solution const all = SolveDual( problem, threads, allStats );
+			double const allTime = Milliseconds( start );
+
+			if (one.key != all.key || one.rejected != all.rejected) {
+				Fail( "benchmark", "thread results differ" );
+			}
+			std::printf( "%5d  %6d  %6ld  %4ld  %7ld  %6ld  %7.1f ms  %7.1f ms  %s\n",
+			             busCount, problem.wantedCount, SolveSingle( problem ).rejected, one.rejected,
+			             stats.cubes, stats.pruned, oneTime, allTime, scattered ? "scattered" : "two runs" );
+		}
+	}
+	std::printf( "single and dual are IDs accepted but not wanted\n" );
+}
+
+void Usage()
+{
+	std::fprintf( stderr, "usage: acramr_calc [-1|-2] [-b bus_ids] [-j threads] [-q] id...\n"
+	                      "       acramr_calc -x [-j threads]\n" );
+	std::exit( 2 );
+}
+
+} // namespace
+
+int main( int argc, char ** argv )
+{
+	auto const startTime = std::chrono::steady_clock::now();
+
+	Problem problem;
+	std::string busFile;
+	bool dual = true;
+	bool quiet = false;
+	bool benchmark = false;
+	int threads = std::max( 1U, std::thread::hardware_concurrency() );
+
+	for (int arg = 1; arg < argc; ++arg) {
+		std::string const option = argv[arg];
+		auto value = [&]() -> std::string {
+			if (arg + 1 >= argc) {
+				Usage();
+			}
+			return argv[++arg];
+		};
+		uint32_t id;
+		if (option == "-1") {
+			dual = false;
+		} else if (option == "-2") {
+			dual = true;
+		} else if (option == "-b") {
+			busFile = value();
+		} else if (option == "-j") {
+			threads = std::atoi( value().c_str() );
+			if (threads < 1) {
+				Usage();
+			}
+		} else if (option == "-q") {
+			quiet = true;
+		} else if (option == "-x") {
+			benchmark = true;
+		} else if (option[0] == '-') {
+			Usage();
+		} else if (ParseId( option, id )) {
+			Add( problem.wanted, id );
+		} else {
+			Fail( option, "bad ID, 11-bit IDs only" );
+		}
+	}
+
+	InitTables();
+	if (benchmark) {
+		Benchmark( threads );
+		return 0;
+	}
+	problem.wantedCount = Count( problem.wanted );
+	if (problem.wantedCount == 0) {
+		Usage();
+	}
+
+	if (busFile.empty()) {
+		problem.bus.fill( ~0ULL );
+	} else {
+		ReadBus( busFile, problem );
+		for (uint32_t word = 0; word < WORDS; ++word) {
+			problem.bus[word] |= problem.wanted[word];
+		}
+	}
+	problem.busCount = Count( problem.bus );
+
+	Stats stats;
+	Solution const solution = dual ? SolveDual( problem, threads, stats ) : SolveSingle( problem );
+	Print( problem, solution, dual, quiet );
+	if (dual && !quiet) {
+		std::fprintf( stderr, "%ld cubes tried, %ld pruned, %d threads, %.1f ms\n", stats.cubes, stats.pruned, threads, Milliseconds( startTime ) );
+	}
+	return 0;
+}
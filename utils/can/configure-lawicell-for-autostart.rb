@@ -65,6 +65,9 @@ send_nowait(sp,"C")     # closing the CAN-bus if active
 puts "Setting auto transmit (X1)..."
 send(sp,"X1")
 
+puts "Setting timestamps ON (Z1)..."
+send(sp,"Z1")
+
 puts "Setting speed to 500 Kbit ..."
 send(sp,"S6")
 
@@ -0,0 +1,917 @@
+/*
+ * DBC to signal table compiler for can_lib/cansig_lib.
+ *
+ * Reads a DBC file and writes a C source and header file with the signal
+ * tables in flash, ready for CANSIG_Decode, and optionally a CAN dispatch
+ * table with one handler per message for CAN_SetDispatchTable.
+ *
+ * Build: c++ -O2 -std=c++17 dbc2c.cpp -o dbc2c
+ *
+ * usage: dbc2c [options] <file.dbc>
+ *
+ *   -s <spec>    Select a signal, may be repeated. <spec> is
+ *                [Message.]Signal[=TARGET][@SCALE]
+ *                TARGET is the target ID passed to the sink, a number or a
+ *                C macro name, e.g. DASHBOARD_SIGNAL_SOC. Without it the
+ *                signals are numbered and get a <PREFIX>_SIG_<name> define.
+ *                SCALE multiplies the physical value before it is turned
+ *                into an integer, e.g. @100 for volts as 0.01 V.
+ *   -a           Select all signals.
+ *   -p <prefix>  Name prefix, default DBC_<FILE NAME>.
+ *   -k <sink>    Sink function. Emits handlers and a dispatch table.
+ *   -i <header>  Include header in the C file, e.g. for the sink and target
+ *                names, may be repeated.
+ *   -v           Emit #defines for value tables of the selected signals,
+ *                named <PREFIX>_VAL_<Message>_<Signal>_<Value>.
+ *   -o <name>    Output base name, default <file name>, gives name.c, name.h.
+ *
+ * Multiplexed messages are supported, the multiplexor is emitted first in
+ * the message and other signals are flagged with their multiplexor value.
+ * Signals longer than 32 bits and float signals are skipped with a warning.
+ *
+ * Example, the 630h summary frame of production_demo_rev_A:
+ *
+ *   dbc2c -k DASHBOARD_Update -i dashboard.h -s SOC=DASHBOARD_SIGNAL_SOC \
+ *         -s MinVolt=DASHBOARD_SIGNAL_MIN_VOLT@100 bms.dbc
+ *
+ * A summary with the estimated flash use is printed to stderr. The tables
+ * need no SRAM.
+ */
+
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iterator>
+#include <map>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace {
+
+// Flash size of the on-device structures, avr-gcc packing.
+const int SIGNAL_BYTES = 19;    // CANSIG_signal_t
+const int MESSAGE_BYTES = 4;    // CANSIG_message_t
+const int ROUTE_BYTES = 6;      // CAN_route_t
+const int DISPATCH_BYTES = 6;   // CAN_dispatch_t
+const int HANDLER_BYTES = 14;   // One generated handler function, approximately.
+
+const uint32_t DBC_EXTENDED = 0x80000000UL;  // Extended ID flag in DBC message IDs.
+const int MAX_ROUTES = 254;  // CAN_NO_ROUTE is 255.
+const int MAX_TARGETS = 255;  // CANSIG_NO_TARGET is 255.
+
+struct Signal
+{
+	std::string name;
+	int startBit = 0;
+	int length = 0;
+	bool bigEndian = false;
+	bool isSigned = false;
+	bool isMux = false;
+	bool isMuxed = false;
+	int muxValue = 0;
+	bool isFloat = false;
+	double factor = 1.0;
+	double offset = 0.0;
+	double min = 0.0;
+	double max = 0.0;
+	std::string unit;
+	int line = 0;
+	std::vector<std::pair<long, std::string>> values;
+
+	// Selection.
+	bool selected = false;
+	std::string target;
+	double scale = 1.0;
+};
+
+struct Message
+{
+	uint32_t id = 0;  // DBC ID, DBC_EXTENDED set for 29-bit IDs.
+	std::string name;
+	int dlc = 0;
+	int line = 0;
+	std::vector<Signal> signals;
+};
+
+struct Selection
+{
+	std::string message;
+	std::string signal;
+	std::string target;
+	double scale = 1.0;
+	bool used = false;
+};
+
+[[noreturn]] void Fail( const std::string & where, const std::string & text )
+{
+	std::fprintf( stderr, "%s: %s\n", where.c_str(), text.c_str() );
+	std::exit( 1 );
+}
+
+void Warn( const std::string & where, const std::string & text )
+{
+	std::fprintf( stderr, "%s: warning: %s\n", where.c_str(), text.c_str() );
+}
+
+// Splits text into tokens: quoted strings (without quotes), numbers and
+// names, and single punctuation characters.
+class Tokenizer
+{
+public:
+	explicit Tokenizer( const std::string & text ) : text_( text ) {}
+
+	bool Next( std::string & token )
+	{
+		while (pos_ < text_.size() && std::isspace( (unsigned char) text_[pos_] )) {
+			++pos_;
+		}
+		if (pos_ >= text_.size()) {
+			return false;
+		}
+
+		char const ch = text_[pos_];
+		if (ch == '"') {
+			size_t const end = text_.find( '"', pos_ + 1 );
+			size_t const stop = (end == std::string::npos) ? text_.size() : end;
+			token = text_.substr( pos_ + 1, stop - pos_ - 1 );
+			pos_ = (end == std::string::npos) ? stop : end + 1;
+			return true;
+		}
+		if (std::isalnum( (unsigned char) ch ) || ch == '_' || ch == '-' || ch == '+' || ch == '.') {
+			size_t end = pos_ + 1;
+			while (end < text_.size()) {
+				char const c = text_[end];
+				bool const exponentSign = (c == '-' || c == '+') && (text_[end - 1] == 'e' || text_[end - 1] == 'E')
+				                          && std::isdigit( (unsigned char) text_[pos_] );
+				if (!(std::isalnum( (unsigned char) c ) || c == '_' || c == '.' || exponentSign)) {
+					break;
+				}
+				++end;
+			}
+			// A lone sign is punctuation, e.g. the '+' in "@1+".
+			if (end == pos_ + 1 && (ch == '-' || ch == '+')) {
+				token = std::string( 1, ch );
+				++pos_;
+				return true;
+			}
+			token = text_.substr( pos_, end - pos_ );
+			pos_ = end;
+			return true;
+		}
+		token = std::string( 1, ch );
+		++pos_;
+		return true;
+	}
+
+	std::string Rest() const { return pos_ < text_.size() ? text_.substr( pos_ ) : std::string(); }
+
+private:
+	const std::string & text_;
+	size_t pos_ = 0;
+};
+
+class Parser
+{
+public:
+	explicit Parser( const std::string & fileName ) : fileName_( fileName ) {}
+
+	std::vector<Message> Parse()
+	{
+		std::ifstream file( fileName_, std::ios::binary );
+		if (!file) {
+			Fail( fileName_, "cannot read file" );
+		}
+		std::stringstream buffer;
+		buffer << file.rdbuf();
+		std::string const text = buffer.str();
+
+		size_t pos = 0;
+		int lineNumber = 0;
+		Message * current = nullptr;
+		while (pos < text.size()) {
+			size_t end = text.find( '\n', pos );
+			if (end == std::string::npos) {
+				end = text.size();
+			}
+			std::string line = text.substr( pos, end - pos );
+			pos = end + 1;
+			++lineNumber;
+			if (!line.empty() && line.back() == '\r') {
+				line.pop_back();
+			}
+
+			size_t const first = line.find_first_not_of( " \t" );
+			if (first == std::string::npos) {
+				continue;
+			}
+			std::string const keyword = line.substr( first, line.find_first_of( " \t:", first ) - first );
+
+			if (keyword == "BO_") {
+				messages_.push_back( ParseMessage( line, lineNumber ) );
+				current = &messages_.back();
+			} else if (keyword == "SG_") {
+				if (current == nullptr) {
+					Fail( Where( lineNumber ), "signal outside message" );
+				}
+				current->signals.push_back( ParseSignal( line, lineNumber ) );
+			} else {
+				current = nullptr;
+				if (keyword == "VAL_" || keyword == "CM_" || keyword.compare( 0, 3, "BA_" ) == 0
+				    || keyword == "VAL_TABLE_" || keyword == "SIG_VALTYPE_" || keyword == "BO_TX_BU_"
+				    || keyword == "SIG_GROUP_" || keyword == "EV_" || keyword == "ENVVAR_DATA_") {
+					// Statements ending with ';', possibly spanning lines in strings.
+					std::string statement = line;
+					while (!StatementComplete( statement ) && pos < text.size()) {
+						end = text.find( '\n', pos );
+						if (end == std::string::npos) {
+							end = text.size();
+						}
+						statement += "\n" + text.substr( pos, end - pos );
+						pos = end + 1;
+						++lineNumber;
+					}
+					if (keyword == "VAL_") {
+						ParseValues( statement, lineNumber );
+					} else if (keyword == "SIG_VALTYPE_") {
+						ParseValueType( statement, lineNumber );
+					}
+				}
+			}
+		}
+
+		for (const auto & entry : pendingValues_) {
+			Signal * signal = Find( entry.id, entry.signal );
+			if (signal == nullptr) {
+				Warn( Where( entry.line ), "value table for unknown signal " + entry.signal );
+				continue;
+			}
+			signal->values = entry.values;
+		}
+		for (const auto & entry : floatSignals_) {
+			Signal * signal = Find( entry.first, entry.second );
+			if (signal != nullptr) {
+				signal->isFloat = true;
+			}
+		}
+
+		return std::move( messages_ );
+	}
+
+private:
+	struct PendingValues
+	{
+		uint32_t id;
+		std::string signal;
+		int line;
+		std::vector<std::pair<long, std::string>> values;
+	};
+
+	std::string Where( int line ) const { return fileName_ + ":" + std::to_string( line ); }
+
+	static bool StatementComplete( const std::string & statement )
+	{
+		bool quoted = false;
+		for (char ch : statement) {
+			if (ch == '"') {
+				quoted = !quoted;
+			} else if (ch == ';' && !quoted) {
+				return true;
+			}
+		}
+		return false;
+	}
+
+	std::string Expect( Tokenizer & tokens, int line, const char * what )
+	{
+		std::string token;
+		if (!tokens.Next( token )) {
+			Fail( Where( line ), std::string( "expected " ) + what );
+		}
+		return token;
+	}
+
+	void ExpectPunct( Tokenizer & tokens, int line, const char * punct )
+	{
+		std::string const token = Expect( tokens, line, punct );
+		if (token != punct) {
+			Fail( Where( line ), std::string( "expected '" ) + punct + "', got '" + token + "'" );
+		}
+	}
+
+	long Integer( const std::string & token, int line )
+	{
+		char * end;
+		long const value = std::strtol( token.c_str(), &end, 10 );
+		if (token.empty() || *end != '\0') {
+			Fail( Where( line ), "bad integer '" + token + "'" );
+		}
+		return value;
+	}
+
+	double Number( const std::string & token, int line )
+	{
+		char * end;
+		double const value = std::strtod( token.c_str(), &end );
+		if (token.empty() || *end != '\0') {
+			Fail( Where( line ), "bad number '" + token + "'" );
+		}
+		return value;
+	}
+
+	// BO_ <id> <name>: <dlc> <sender>
+	Message ParseMessage( const std::string & line, int lineNumber )
+	{
+		Tokenizer tokens( line );
+		Message message;
+		Expect( tokens, lineNumber, "BO_" );
+		message.id = (uint32_t) std::strtoul( Expect( tokens, lineNumber, "message ID" ).c_str(), nullptr, 10 );
+		message.name = Expect( tokens, lineNumber, "message name" );
+		ExpectPunct( tokens, lineNumber, ":" );
+		message.dlc = (int) Integer( Expect( tokens, lineNumber, "DLC" ), lineNumber );
+		message.line = lineNumber;
+		return message;
+	}
+
+	// SG_ <name> [M|m<n>] : <start>|<length>@<order><sign> (<factor>,<offset>) [<min>|<max>] "<unit>" <receivers>
+	Signal ParseSignal( const std::string & line, int lineNumber )
+	{
+		Tokenizer tokens( line );
+		Signal signal;
+		signal.line = lineNumber;
+		Expect( tokens, lineNumber, "SG_" );
+		signal.name = Expect( tokens, lineNumber, "signal name" );
+
+		std::string token = Expect( tokens, lineNumber, "':'" );
+		if (token == "M") {
+			signal.isMux = true;
+			token = Expect( tokens, lineNumber, "':'" );
+		} else if (token.size() > 1 && token[0] == 'm') {
+			if (token.back() == 'M') {
+				Fail( Where( lineNumber ), "extended multiplexing is not supported" );
+			}
+			signal.isMuxed = true;
+			signal.muxValue = (int) Integer( token.substr( 1 ), lineNumber );
+			token = Expect( tokens, lineNumber, "':'" );
+		}
+		if (token != ":") {
+			Fail( Where( lineNumber ), "expected ':', got '" + token + "'" );
+		}
+
+		signal.startBit = (int) Integer( Expect( tokens, lineNumber, "start bit" ), lineNumber );
+		ExpectPunct( tokens, lineNumber, "|" );
+		signal.length = (int) Integer( Expect( tokens, lineNumber, "length" ), lineNumber );
+		ExpectPunct( tokens, lineNumber, "@" );
+		// Byte order and sign come as one token, e.g. "1" and "+", or "0-".
+		token = Expect( tokens, lineNumber, "byte order" );
+		if (token != "0" && token != "1") {
+			Fail( Where( lineNumber ), "bad byte order '" + token + "'" );
+		}
+		signal.bigEndian = (token == "0");
+		token = Expect( tokens, lineNumber, "sign" );
+		if (token != "+" && token != "-") {
+			Fail( Where( lineNumber ), "bad sign '" + token + "'" );
+		}
+		signal.isSigned = (token == "-");
+
+		ExpectPunct( tokens, lineNumber, "(" );
+		signal.factor = Number( Expect( tokens, lineNumber, "factor" ), lineNumber );
+		ExpectPunct( tokens, lineNumber, "," );
+		signal.offset = Number( Expect( tokens, lineNumber, "offset" ), lineNumber );
+		ExpectPunct( tokens, lineNumber, ")" );
+		ExpectPunct( tokens, lineNumber, "[" );
+		signal.min = Number( Expect( tokens, lineNumber, "min" ), lineNumber );
+		ExpectPunct( tokens, lineNumber, "|" );
+		signal.max = Number( Expect( tokens, lineNumber, "max" ), lineNumber );
+		ExpectPunct( tokens, lineNumber, "]" );
+		signal.unit = Expect( tokens, lineNumber, "unit" );
+		return signal;
+	}
+
+	// VAL_ <id> <signal> <value> "<text>" ... ;
+	void ParseValues( const std::string & statement, int lineNumber )
+	{
+		Tokenizer tokens( statement );
+		Expect( tokens, lineNumber, "VAL_" );
+		std::string const first = Expect( tokens, lineNumber, "message ID" );
+		if (!std::isdigit( (unsigned char) first[0] )) {
+			return;  // Environment variable values.
+		}
+		PendingValues entry;
+		entry.id = (uint32_t) std::strtoul( first.c_str(), nullptr, 10 );
+		entry.signal = Expect( tokens, lineNumber, "signal name" );
+		entry.line = lineNumber;
+		std::string token;
+		while (tokens.Next( token ) && token != ";") {
+			long const value = Integer( token, lineNumber );
+			entry.values.emplace_back( value, Expect( tokens, lineNumber, "value text" ) );
+		}
+		pendingValues_.push_back( std::move( entry ) );
+	}
+
+	// SIG_VALTYPE_ <id> <signal> : <type> ;
+	void ParseValueType( const std::string & statement, int lineNumber )
+	{
+		Tokenizer tokens( statement );
+		Expect( tokens, lineNumber, "SIG_VALTYPE_" );
+		uint32_t const id = (uint32_t) std::strtoul( Expect( tokens, lineNumber, "message ID" ).c_str(), nullptr, 10 );
+		std::string const signal = Expect( tokens, lineNumber, "signal name" );
+		ExpectPunct( tokens, lineNumber, ":" );
+		if (Integer( Expect( tokens, lineNumber, "value type" ), lineNumber ) != 0) {
+			floatSignals_.emplace_back( id, signal );
+		}
+	}
+
+	Signal * Find( uint32_t id, const std::string & name )
+	{
+		for (auto & message : messages_) {
+			if (message.id == id) {
+				for (auto & signal : message.signals) {
+					if (signal.name == name) {
+						return &signal;
+					}
+				}
+			}
+		}
+		return nullptr;
+	}
+
+	std::string fileName_;
+	std::vector<Message> messages_;
+	std::vector<PendingValues> pendingValues_;
+	std::vector<std::pair<uint32_t, std::string>> floatSignals_;
+};
+
+// On-device bit layout, as computed by CANSIG_INTEL and CANSIG_MOTOROLA.
+struct Layout
+{
+	int lsbByte;
+	int byteCount;
+	int shift;
+	uint32_t mask;
+};
+
+Layout GetLayout( const Signal & signal )
+{
+	Layout layout;
+	layout.mask = (signal.length >= 32) ? 0xFFFFFFFFUL : ((1UL << signal.length) - 1);
+	if (!signal.bigEndian) {
+		layout.lsbByte = signal.startBit / 8;
+		layout.shift = signal.startBit % 8;
+		layout.byteCount = (layout.shift + signal.length + 7) / 8;
+	} else {
+		int const msbBits = signal.startBit % 8 + 1;
+		if (signal.length <= msbBits) {
+			layout.byteCount = 1;
+			layout.shift = msbBits - signal.length;
+		} else {
+			int const remaining = signal.length - msbBits;
+			layout.byteCount = 1 + (remaining + 7) / 8;
+			layout.shift = (8 - remaining % 8) % 8;
+		}
+		layout.lsbByte = signal.startBit / 8 + layout.byteCount - 1;
+	}
+	return layout;
+}
+
+// Integer scaling: value = ((raw * multiplier) >> shift) + offset.
+struct Scaling
+{
+	long multiplier;
+	int shift;
+	long offset;
+	long min;
+	long max;
+};
+
+long ClampInt16( double value )
+{
+	return std::lround( std::max( -32768.0, std::min( 32767.0, value ) ) );
+}
+
+bool GetScaling( const Signal & signal, const Layout & layout, Scaling & scaling, std::string & error )
+{
+	double const factor = signal.factor * signal.scale;
+	double const maxRaw = signal.isSigned ? (double) (layout.mask / 2 + 1) : (double) layout.mask;
+	if (std::fabs( factor ) > 32767.0) {
+		error = "scaled factor does not fit in 16 bits";
+		return false;
+	}
+
+	// Smallest shift giving an exact multiplier, otherwise the most precise
+	// one that keeps the multiplier in 16 bits and raw times multiplier in
+	// 32 bits.
+	scaling.multiplier = std::lround( factor );
+	scaling.shift = 0;
+	for (int shift = 1; shift <= 24 && std::fabs( std::ldexp( factor, shift - 1 ) - scaling.multiplier ) > 1e-9; ++shift) {
+		// Rounded up, as the decoder truncates the product.
+		long const multiplier = (long) std::ceil( std::ldexp( factor, shift ) - 1e-9 );
+		if (std::labs( multiplier ) > 32767 || maxRaw * std::labs( multiplier ) > 2147483647.0) {
+			break;
+		}
+		scaling.multiplier = multiplier;
+		scaling.shift = shift;
+	}
+	if (scaling.multiplier == 0 && factor != 0.0) {
+		error = "scaled factor is too small";
+		return false;
+	}
+
+	double const offset = signal.offset * signal.scale;
+	if (offset < -32768.0 || offset > 32767.0) {
+		error = "scaled offset does not fit in 16 bits";
+		return false;
+	}
+	scaling.offset = std::lround( offset );
+
+	if (signal.min == 0.0 && signal.max == 0.0) {
+		scaling.min = -32768;
+		scaling.max = 32767;
+	} else {
+		scaling.min = ClampInt16( std::floor( signal.min * signal.scale ) );
+		scaling.max = ClampInt16( std::ceil( signal.max * signal.scale ) );
+	}
+	return true;
+}
+
+std::string Identifier( const std::string & name )
+{
+	std::string result;
+	for (char ch : name) {
+		result += std::isalnum( (unsigned char) ch ) ? (char) std::toupper( (unsigned char) ch ) : '_';
+	}
+	if (result.empty() || std::isdigit( (unsigned char) result[0] )) {
+		result = "_" + result;
+	}
+	return result;
+}
+
+std::string Hex( uint32_t value, int digits )
+{
+	char buffer[16];
+	std::snprintf( buffer, sizeof(buffer), "0x%0*lX", digits, (unsigned long) value );
+	return buffer;
+}
+
+std::string Number( double value )
+{
+	std::ostringstream out;
+	out << value;
+	return out.str();
+}
+
+Selection ParseSelection( const std::string & spec )
+{
+	Selection selection;
+	std::string name = spec;
+	size_t const at = name.find( '@' );
+	if (at != std::string::npos) {
+		char * end;
+		selection.scale = std::strtod( name.c_str() + at + 1, &end );
+		if (*end != '\0' || selection.scale == 0.0) {
+			Fail( "-s " + spec, "bad scale" );
+		}
+		name.erase( at );
+	}
+	size_t const equals = name.find( '=' );
+	if (equals != std::string::npos) {
+		selection.target = name.substr( equals + 1 );
+		name.erase( equals );
+	}
+	size_t const dot = name.find( '.' );
+	if (dot != std::string::npos) {
+		selection.message = name.substr( 0, dot );
+		name.erase( 0, dot + 1 );
+	}
+	selection.signal = name;
+	return selection;
+}
+
+void Usage()
+{
+	std::fprintf( stderr, "usage: dbc2c [-a] [-s [Message.]Signal[=TARGET][@SCALE]]... [-p prefix] [-k sink] [-i header]... [-v] [-o name] file.dbc\n" );
+	std::exit( 2 );
+}
+
+} // namespace
+
+int main( int argc, char ** argv )
+{
+	auto const startTime = std::chrono::steady_clock::now();
+
+	std::vector<Selection> selections;
+	std::vector<std::string> includes;
+	bool selectAll = false;
+	bool valueDefines = false;
+	std::string prefix;
+	std::string sink;
+	std::string output;
+	std::string input;
+
+	for (int arg = 1; arg < argc; ++arg) {
+		std::string const option = argv[arg];
+		auto value = [&]() -> std::string {
+			if (arg + 1 >= argc) {
+				Usage();
+			}
+			return argv[++arg];
+		};
+		if (option == "-s") {
+			selections.push_back( ParseSelection( value() ) );
+		} else if (option == "-a") {
+			selectAll = true;
+		} else if (option == "-p") {
+			prefix = value();
+		} else if (option == "-k") {
+			sink = value();
+		} else if (option == "-i") {
+			includes.push_back( value() );
+		} else if (option == "-v") {
+			valueDefines = true;
+		} else if (option == "-o") {
+			output = value();
+		} else if (option[0] == '-' || !input.empty()) {
+			Usage();
+		} else {
+			input = option;
+		}
+	}
+	if (input.empty() || (selections.empty() && !selectAll)) {
+		Usage();
+	}
+
+	std::string baseName = input.substr( input.find_last_of( "/\\" ) == std::string::npos ? 0 : input.find_last_of( "/\\" ) + 1 );
+	baseName = baseName.substr( 0, baseName.rfind( '.' ) );
+	if (output.empty()) {
+		output = baseName;
+	}
+	if (prefix.empty()) {
+		prefix = "DBC_" + Identifier( baseName );
+	}
+	std::string const guard = Identifier( output.substr( output.find_last_of( "/\\" ) == std::string::npos ? 0 : output.find_last_of( "/\\" ) + 1 ) ) + "_H";
+	std::string const headerName = output.substr( output.find_last_of( "/\\" ) == std::string::npos ? 0 : output.find_last_of( "/\\" ) + 1 ) + ".h";
+
+	std::vector<Message> messages = Parser( input ).Parse();
+	size_t totalSignals = 0;
+	for (const auto & message : messages) {
+		totalSignals += message.signals.size();
+	}
+
+	// Index signals by name and by message.name for selection.
+	std::unordered_multimap<std::string, Signal *> byName;
+	for (auto & message : messages) {
+		for (auto & signal : message.signals) {
+			byName.emplace( signal.name, &signal );
+			byName.emplace( message.name + "." + signal.name, &signal );
+		}
+	}
+
+	for (auto & selection : selections) {
+		std::string const key = selection.message.empty() ? selection.signal : selection.message + "." + selection.signal;
+		auto const range = byName.equal_range( key );
+		if (range.first == range.second) {
+			Fail( "-s " + key, "no such signal" );
+		}
+		if (std::next( range.first ) != range.second) {
+			Fail( "-s " + key, "signal name is ambiguous, give Message.Signal" );
+		}
+		Signal & signal = *range.first->second;
+		signal.selected = true;
+		signal.target = selection.target;
+		signal.scale = selection.scale;
+	}
+	if (selectAll) {
+		for (auto & message : messages) {
+			for (auto & signal : message.signals) {
+				signal.selected = true;
+			}
+		}
+	}
+
+	// Collect messages with selected signals, multiplexor first, sorted by
+	// dispatch key. Unselected multiplexors are kept with no target.
+	struct Output
+	{
+		const Message * message;
+		std::vector<Signal> signals;
+		uint32_t key;
+	};
+	std::vector<Output> outputs;
+	std::vector<std::string> autoTargets;
+	int skipped = 0;
+	for (const auto & message : messages) {
+		Output out;
+		out.message = &message;
+		uint32_t const id = message.id & ~DBC_EXTENDED;
+		out.key = ((message.id & DBC_EXTENDED) != 0) ? (id | DBC_EXTENDED) : id;
+		std::string const where = input + ":" + std::to_string( message.line );
+		if (((message.id & DBC_EXTENDED) != 0 && id > 0x1FFFFFFFUL) || ((message.id & DBC_EXTENDED) == 0 && id > 0x7FFUL)) {
+			Warn( where, "message " + message.name + " has an invalid ID, skipped" );
+			continue;
+		}
+
+		const Signal * mux = nullptr;
+		bool anyMuxed = false;
+		for (const auto & signal : message.signals) {
+			if (signal.isMux) {
+				mux = &signal;
+			}
+			if (signal.selected && signal.isMuxed) {
+				anyMuxed = true;
+			}
+		}
+
+		for (const auto & signal : message.signals) {
+			bool const neededMux = signal.isMux && anyMuxed;
+			if (!signal.selected && !neededMux) {
+				continue;
+			}
+			std::string const signalWhere = input + ":" + std::to_string( signal.line );
+			if (signal.length < 1 || signal.length > 32 || signal.isFloat) {
+				Warn( signalWhere, "signal " + signal.name + " is longer than 32 bits or float, skipped" );
+				++skipped;
+				continue;
+			}
+			Layout const layout = GetLayout( signal );
+			if (layout.lsbByte < 0 || layout.lsbByte > 7 || (signal.bigEndian ? layout.lsbByte - layout.byteCount + 1 < 0 : layout.lsbByte + layout.byteCount > 8)) {
+				Warn( signalWhere, "signal " + signal.name + " does not fit in 8 data bytes, skipped" );
+				++skipped;
+				continue;
+			}
+			if (signal.isMuxed && (mux == nullptr || signal.muxValue < 0 || signal.muxValue > 255)) {
+				Warn( signalWhere, "signal " + signal.name + " has no multiplexor or a value above 255, skipped" );
+				++skipped;
+				continue;
+			}
+			Signal copy = signal;
+			if (!signal.selected) {
+				copy.target = "CANSIG_NO_TARGET";
+			} else if (copy.target.empty()) {
+				copy.target = prefix + "_SIG_" + Identifier( message.name ) + "_" + Identifier( signal.name );
+				autoTargets.push_back( copy.target );
+			}
+			if (signal.isMux) {
+				out.signals.insert( out.signals.begin(), copy );
+			} else {
+				out.signals.push_back( copy );
+			}
+		}
+		if (out.signals.empty()) {
+			continue;
+		}
+		if (out.signals.size() > 255) {
+			Fail( where, "message " + message.name + " has more than 255 selected signals" );
+		}
+		outputs.push_back( std::move( out ) );
+	}
+	std::sort( outputs.begin(), outputs.end(), []( const Output & a, const Output & b ) { return a.key < b.key; } );
+
+	if (autoTargets.size() > MAX_TARGETS) {
+		Fail( input, std::to_string( autoTargets.size() ) + " numbered targets, at most " + std::to_string( MAX_TARGETS ) + ", select signals with -s" );
+	}
+	if (!sink.empty() && outputs.size() > MAX_ROUTES) {
+		Fail( input, std::to_string( outputs.size() ) + " messages, a dispatch table holds at most " + std::to_string( MAX_ROUTES ) );
+	}
+
+	// Header.
+	std::ostringstream header;
+	header << "// Generated by utils/can/dbc2c from " << input.substr( input.find_last_of( "/\\" ) == std::string::npos ? 0 : input.find_last_of( "/\\" ) + 1 ) << ", do not edit.\n";
+	header << "#ifndef " << guard << "\n#define " << guard << "\n\n";
+	header << "#include <cansig_lib.h>\n\n";
+	for (size_t index = 0; index < autoTargets.size(); ++index) {
+		header << "#define " << autoTargets[index] << " " << index << "\n";
+	}
+	if (!autoTargets.empty()) {
+		header << "#define " << prefix << "_SIG_COUNT " << autoTargets.size() << "\n\n";
+	}
+	for (const auto & out : outputs) {
+		bool const extended = (out.key & DBC_EXTENDED) != 0;
+		header << "#define " << prefix << "_ID_" << Identifier( out.message->name ) << " "
+		       << Hex( out.key & ~DBC_EXTENDED, extended ? 8 : 3 ) << (extended ? "UL  // 29-bit" : "") << "\n";
+	}
+	if (valueDefines) {
+		bool first = true;
+		for (const auto & out : outputs) {
+			for (const auto & signal : out.signals) {
+				for (const auto & value : signal.values) {
+					if (first) {
+						header << "\n";
+						first = false;
+					}
+					header << "#define " << prefix << "_VAL_" << Identifier( out.message->name ) << "_" << Identifier( signal.name ) << "_" << Identifier( value.second ) << " " << value.first << "\n";
+				}
+			}
+		}
+	}
+	header << "\n";
+	for (const auto & out : outputs) {
+		header << "extern CANSIG_message_t const CAL_PGM(" << prefix << "_" << out.message->name << ");\n";
+	}
+	if (!sink.empty()) {
+		header << "\n#include <can_lib.h>\n\n";
+		header << "extern CAN_dispatch_t const CAL_PGM(" << prefix << "_dispatch);\n";
+	}
+	header << "\n#endif\n";
+
+	// Source.
+	std::ostringstream source;
+	int flashBytes = 0;
+	int signalCount = 0;
+	source << "// Generated by utils/can/dbc2c from " << input.substr( input.find_last_of( "/\\" ) == std::string::npos ? 0 : input.find_last_of( "/\\" ) + 1 ) << ", do not edit.\n";
+	if (!sink.empty()) {
+		source << "#include <stddef.h>\n";
+	}
+	source << "#include \"" << headerName << "\"\n";
+	for (const auto & include : includes) {
+		source << "#include <" << include << ">\n";
+	}
+	for (const auto & out : outputs) {
+		std::string const name = prefix + "_" + out.message->name;
+		source << "\n// " << out.message->name << ", ID " << Hex( out.key & ~DBC_EXTENDED, 3 ) << ", DLC " << out.message->dlc << "\n";
+		source << "static CANSIG_signal_t const CAL_PGM_DEF(" << name << "_signals[]) = {\n";
+		int minDlc = 0;
+		for (size_t index = 0; index < out.signals.size(); ++index) {
+			const Signal & signal = out.signals[index];
+			Layout const layout = GetLayout( signal );
+			Scaling scaling;
+			std::string error;
+			if (!GetScaling( signal, layout, scaling, error )) {
+				Fail( input + ":" + std::to_string( signal.line ), signal.name + ": " + error );
+			}
+			int const lastByte = signal.bigEndian ? layout.lsbByte : layout.lsbByte + layout.byteCount - 1;
+			minDlc = std::max( minDlc, lastByte + 1 );
+
+			std::string flags = signal.bigEndian ? "CANSIG_BIG_ENDIAN" : "";
+			auto addFlag = [&]( const char * flag ) { flags += (flags.empty() ? "" : " | ") + std::string( flag ); };
+			if (signal.isSigned) {
+				addFlag( "CANSIG_SIGNED" );
+			}
+			if (signal.isMux) {
+				addFlag( "CANSIG_MUX" );
+			}
+			if (signal.isMuxed) {
+				addFlag( "CANSIG_MUXED" );
+			}
+			if (flags.empty()) {
+				flags = "0";
+			}
+
+			source << "\t{ " << layout.lsbByte << ", " << layout.byteCount << ", " << layout.shift << ", " << flags << ", "
+			       << Hex( layout.mask, 8 ) << "UL, " << scaling.multiplier << ", " << scaling.shift << ", " << scaling.offset << ", "
+			       << scaling.min << ", " << scaling.max << ", " << signal.target << ", " << (signal.isMuxed ? signal.muxValue : 0) << " }"
+			       << (index + 1 < out.signals.size() ? "," : " ") << "  // " << signal.name << " " << signal.startBit << "|" << signal.length
+			       << "@" << (signal.bigEndian ? "0" : "1") << (signal.isSigned ? "-" : "+") << " (" << Number( signal.factor ) << ","
+			       << Number( signal.offset ) << ")" << (signal.scale != 1.0 ? " x" + Number( signal.scale ) : "")
+			       << (signal.unit.empty() ? "" : " " + signal.unit) << "\n";
+			flashBytes += SIGNAL_BYTES;
+			++signalCount;
+		}
+		source << "};\n\n";
+		source << "CANSIG_message_t const CAL_PGM_DEF(" << name << ") = {\n";
+		source << "\t" << name << "_signals, " << out.signals.size() << ", " << minDlc << "\n};\n";
+		flashBytes += MESSAGE_BYTES;
+	}
+
+	if (!sink.empty()) {
+		source << "\n";
+		for (const auto & out : outputs) {
+			std::string const name = prefix + "_" + out.message->name;
+			source << "static void " << name << "_Handler( CAN_frame_t const * frame )\n{\n";
+			source << "\tCANSIG_Decode( &" << name << ", frame, " << sink << " );\n}\n\n";
+			flashBytes += HANDLER_BYTES;
+		}
+		source << "// Sorted by dispatch key.\n";
+		source << "static CAN_route_t const CAL_PGM_DEF(" << prefix << "_routes[]) = {\n";
+		for (size_t index = 0; index < outputs.size(); ++index) {
+			const Output & out = outputs[index];
+			bool const extended = (out.key & DBC_EXTENDED) != 0;
+			source << "\t{ " << (extended ? "CAN_EXT( " : "CAN_STD( ") << Hex( out.key & ~DBC_EXTENDED, extended ? 8 : 3 ) << " ), "
+			       << prefix << "_" << out.message->name << "_Handler }" << (index + 1 < outputs.size() ? "," : "") << "\n";
+			flashBytes += ROUTE_BYTES;
+		}
+		source << "};\n\n";
+		source << "CAN_dispatch_t const CAL_PGM_DEF(" << prefix << "_dispatch) = {\n";
+		source << "\t" << prefix << "_routes, " << outputs.size() << ",\n\tNULL, 0\n};\n";
+		flashBytes += DISPATCH_BYTES;
+	}
+
+	for (const auto & file : { std::make_pair( output + ".h", header.str() ), std::make_pair( output + ".c", source.str() ) }) {
+		std::ofstream out( file.first, std::ios::binary );
+		out << file.second;
+		if (!out) {
+			Fail( file.first, "cannot write file" );
+		}
+	}
+
+	double const milliseconds = std::chrono::duration<double, std::milli>( std::chrono::steady_clock::now() - startTime ).count();
+	std::fprintf( stderr, "%s: %zu messages, %zu signals read in %.1f ms\n", input.c_str(), messages.size(), totalSignals, milliseconds );
+	std::fprintf( stderr, "%s.c: %zu messages, %d signals, %d skipped\n", output.c_str(), outputs.size(), signalCount, skipped );
+	std::fprintf( stderr, "estimated flash %d bytes, SRAM 0 bytes\n", flashBytes );
+	return 0;
+}
@@ -0,0 +1,202 @@
+#!/usr/bin/ruby
+
+#
+# Bridges an SLCAN (Lawicell) adapter to the display, converting received
+# frames to binary CAN records when the display asks for them.
+#
+# Licenced under LGPL
+#
+# The display starts in SLCAN and sends "B1\r". The bridge answers "\r\r"
+# and a zero byte, so the display starts on a record boundary, and from
+# then on sends each frame as a COBS encoded record terminated by a zero
+# byte, see can_lib/canbin_lib.h for the record layout. "B0\r" goes back to
+# SLCAN, also answered with "\r\r" so the first CR ends whatever the
+# display made of the last record. "Un\r" changes the speed of the display
+# port as a Lawicell CAN232 would, after answering at the old speed; the
+# adapter port keeps its speed. All other commands from the display are
+# passed on to the adapter unchanged. Adapter responses other than frames
+# are only passed on in SLCAN mode.
+#
+# The adapter port runs at 57600 baud unless another rate is given after
+# the port names. It must match the rate the adapter was set to. At 57600
+# baud SLCAN lines limit the adapter to about 200 frames/s whatever the
+# display link does, so set the adapter faster, e.g. "U1" for 115200 on a
+# CAN232, to get more frames through with binary records.
+#
+# Normal startup should be something like this;
+#
+# ./slcan-bin-bridge.rb /dev/tty.ADAPTER_PORT /dev/tty.DISPLAY_PORT 115200
+#
+# An SLCAN log can also be converted offline, which prints the size of
+# both encodings;
+#
+# ./slcan-bin-bridge.rb -e < frames.log > frames.bin
+#
+
+HEADER_EXTENDED = 0x10
+HEADER_RTR = 0x20
+HEADER_TIMESTAMP = 0x40
+
+# Adapter port speed when none is given.
+DEFAULT_ADAPTER_BAUD = 57600
+
+# Lawicell "Un" baud rate codes.
+BAUD_RATES = [230400, 115200, 57600, 38400, 19200, 9600, 2400]
+
+def crc8(bytes)
+	crc = 0
+	bytes.each do |b|
+		crc ^= b
+		8.times { crc = (crc & 0x80) != 0 ? ((crc << 1) ^ 0x07) & 0xFF : (crc << 1) & 0xFF }
+	end
+	return crc
+end
+
+def cobs_encode(bytes)
+	out = []
+	block = []
+	bytes.each do |b|
+		if b == 0
+			out << block.size + 1
+			out.concat(block)
+			block = []
+		else
+			block << b
+			if block.size == 254
+				out << 255
+				out.concat(block)
+				block = []
+			end
+		end
+	end
+	out << block.size + 1
+	out.concat(block)
+	return out
+end
+
+# Returns the record for one SLCAN frame line, or nil if it is not a frame.
+def frame_to_record(line)
+	m = /\A([tTrR])(\h+)\z/.match(line)
+	return nil if m.nil?
+
+	type = m[1]
+	digits = m[2]
+	extended = (type == "T" || type == "R")
+	rtr = (type == "r" || type == "R")
+	idDigits = extended ? 8 : 3
+	return nil if digits.size < idDigits + 1
+
+	id = digits[0, idDigits].hex
+	dlc = digits[idDigits, 1].hex
+	return nil if dlc > 8
+	rest = digits[(idDigits + 1)..-1]
+	dataDigits = rtr ? 0 : 2 * dlc
+	return nil if rest.size != dataDigits && rest.size != dataDigits + 4
+
+	header = dlc
+	header |= HEADER_EXTENDED if extended
+	header |= HEADER_RTR if rtr
+	record = [header]
+	if extended
+		record.concat([id >> 24, id >> 16, id >> 8, id].map { |b| b & 0xFF })
+	else
+		record.concat([id >> 8, id & 0xFF])
+	end
+	record.concat([rest[0, dataDigits]].pack("H*").bytes)
+	if rest.size > dataDigits
+		stamp = rest[dataDigits, 4].hex
+		record[0] |= HEADER_TIMESTAMP
+		record.concat([stamp >> 8, stamp & 0xFF])
+	end
+	record << crc8(record)
+	return record
+end
+
+def encode_record(record)
+	return (cobs_encode(record) << 0).pack("C*")
+end
+
+if ARGV[0] == "-e"
+	STDOUT.binmode
+	asciiSize = 0
+	binarySize = 0
+	frames = 0
+	STDIN.each_line("\r") do |chunk|
+		chunk.split(/[\r\n]/).each do |line|
+			record = frame_to_record(line)
+			next if record.nil?
+			bytes = encode_record(record)
+			STDOUT.write(bytes)
+			frames += 1
+			asciiSize += line.size + 1
+			binarySize += bytes.size
+		end
+	end
+	if frames > 0
+		STDERR.printf("%d frames, SLCAN %d bytes, binary %d bytes, %.2fx\n",
+		              frames, asciiSize, binarySize, asciiSize.to_f / binarySize)
+	end
+	exit(0)
+end
+
+adapterBaud = (ARGV.size > 2) ? ARGV[2].to_i : DEFAULT_ADAPTER_BAUD
+if ARGV.size < 2 || adapterBaud <= 0
+  STDERR.print <<EOF
+  Usage: ruby #{$0} adapter_port display_port [adapter_baud]
+         ruby #{$0} -e < slcan_log > binary_log
+EOF
+  exit(1)
+end
+
+require "rubygems"
+require "serialport"
+
+puts "Opening serial ports..."
+adapter = SerialPort.new(ARGV[0].to_s, adapterBaud, 8, 1, SerialPort::NONE)
+display = SerialPort.new(ARGV[1].to_s, 57600, 8, 1, SerialPort::NONE)
+puts "OK"
+
+binary = false
+lock = Mutex.new
+
+# Display to adapter, intercepting the record mode commands.
+Thread.new do
+	loop do
+		line = display.gets("\r")
+		next if line.nil?
+		case line.chomp("\r")
+		when "B1"
+			lock.synchronize { display.write("\r\r\0"); binary = true }
+			puts "Binary records ON"
+		when "B0"
+			lock.synchronize { display.write("\r\r"); binary = false }
+			puts "Binary records OFF"
+		when /\AU([0-6])\z/
+			rate = BAUD_RATES[$1.to_i]
+			lock.synchronize do
+				display.write("\r")
+				display.flush
+				sleep(0.01)
+				display.baud = rate
+			end
+			puts "Display port at #{rate} baud"
+		else
+			adapter.write(line)
+		end
+	end
+end
+
+# Adapter to display, one line at a time so records are never split.
+loop do
+	line = adapter.gets("\r")
+	next if line.nil?
+	lock.synchronize do
+		if binary
+			# BELL responses have no CR, so one may lead the next line.
+			record = frame_to_record(line.delete("\a\n").chomp("\r"))
+			display.write(encode_record(record)) unless record.nil?
+		else
+			display.write(line)
+		end
+	end
+end
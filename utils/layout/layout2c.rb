@@ -0,0 +1,361 @@
+#!/usr/bin/ruby
+#
+# Screen layout compiler for layout_lib.
+#
+# Reads a text layout description and writes a C source and header file
+# with the layout tables in flash, ready to be used with LAYOUT_Init,
+# LAYOUT_Draw and LAYOUT_Update.
+#
+# usage: layout2c.rb <file.layout> [output directory]
+#
+# Output for "layout drive" is layout_drive.c and layout_drive.h.
+#
+# Description format, one statement per line, '#' starts a comment:
+#
+#   layout <name>
+#   signal <name> <id>
+#   include "<file>"
+#   <type> key=value key=value ...
+#
+# Included files are read relative to the including file, e.g. to share
+# signal definitions between the layouts of a multi-page screen.
+#
+# Types and keys (x is a column, page a LCD page, y a pixel row):
+#
+#   label     x page text="..."
+#   number    x page width [decimals] [mul] [shift] [align=left|right]
+#             [zeropad] [units="..."] signal
+#   bar       x y length thickness max [style=vertical,frame]
+#             [segment] [peakhold] signal
+#   bignumber x page signal                      (96 x 32 pixels)
+#   battery   x page signal                      (32 x 64 pixels)
+#   gauge     x page width pages cx cy radius max [ticks]
+#             [style=arc,pivot] signal
+#   chart     x page width pages [samples] signal
+#
+# The compiler checks that all items are inside the LCD and that no two
+# items overlap, sorts the items by page and column for drawing, and
+# builds the signal map so LAYOUT_Update only visits bound items.
+
+LCD_WIDTH = 128
+LCD_HEIGHT = 64
+PAGE_HEIGHT = 8
+CHAR_WIDTH = 6
+CHART_COLUMN_SIZE = 4
+
+TYPES = {
+	"label"     => { :required => %w(x page text),                      :optional => %w() },
+	"number"    => { :required => %w(x page width signal),              :optional => %w(decimals mul shift align zeropad units) },
+	"bar"       => { :required => %w(x y length thickness max signal),  :optional => %w(style segment peakhold) },
+	"bignumber" => { :required => %w(x page signal),                    :optional => %w() },
+	"battery"   => { :required => %w(x page signal),                    :optional => %w() },
+	"gauge"     => { :required => %w(x page width pages cx cy radius max signal), :optional => %w(ticks style) },
+	"chart"     => { :required => %w(x page width pages signal),        :optional => %w(samples) },
+}
+
+STYLE_FLAGS = {
+	"bar"   => { "vertical" => "BAR_STYLE_VERTICAL", "frame" => "BAR_STYLE_FRAME" },
+	"gauge" => { "arc" => "GAUGE_STYLE_ARC", "pivot" => "GAUGE_STYLE_PIVOT" },
+}
+
+# Locations are "file:line" strings.
+def fail_at(location, message)
+	$stderr.puts "#{location}: #{message}"
+	exit 1
+end
+
+# Split a statement into words, keeping quoted strings together.
+def tokenize(line, location)
+	tokens = line.scan(/\w+="(?:[^"\\]|\\.)*"|"(?:[^"\\]|\\.)*"|[^\s]+/)
+	fail_at(location, "unterminated string") if tokens.join.count('"').odd?
+	tokens
+end
+
+def integer(item, key, default = nil)
+	value = item[:keys][key]
+	return default if value.nil?
+	fail_at(item[:line], "#{key} must be a number") unless value =~ /\A(0x[0-9a-fA-F]+|\d+)\z/
+	Integer(value)
+end
+
+def string(item, key)
+	value = item[:keys][key]
+	return nil if value.nil?
+	fail_at(item[:line], "#{key} must be a quoted string") unless value =~ /\A"(.*)"\z/
+	$1.gsub(/\\(.)/, '\1')
+end
+
+def c_string(text)
+	'"' + text.gsub(/["\\]/) { |c| "\\" + c } + '"'
+end
+
+# Pixel rectangle covered by an item, as [left, top, right, bottom] inclusive.
+def region(item)
+	x = integer(item, "x")
+	case item[:type]
+	when "label"
+		top = integer(item, "page") * PAGE_HEIGHT
+		[x, top, x + string(item, "text").length * CHAR_WIDTH - 1, top + PAGE_HEIGHT - 1]
+	when "number"
+		top = integer(item, "page") * PAGE_HEIGHT
+		chars = integer(item, "width") + (string(item, "units") || "").length
+		[x, top, x + chars * CHAR_WIDTH - 1, top + PAGE_HEIGHT - 1]
+	when "bar"
+		y = integer(item, "y")
+		length = integer(item, "length")
+		thickness = integer(item, "thickness")
+		length, thickness = thickness, length if styles(item).include?("vertical")
+		[x, y, x + length - 1, y + thickness - 1]
+	when "bignumber"
+		top = integer(item, "page") * PAGE_HEIGHT
+		[x, top, x + 95, top + 31]
+	when "battery"
+		top = integer(item, "page") * PAGE_HEIGHT
+		[x, top, x + 31, top + 63]
+	when "gauge", "chart"
+		top = integer(item, "page") * PAGE_HEIGHT
+		[x, top, x + integer(item, "width") - 1, top + integer(item, "pages") * PAGE_HEIGHT - 1]
+	end
+end
+
+def styles(item)
+	(item[:keys]["style"] || "").split(",")
+end
+
+def style_expression(item)
+	case item[:type]
+	when "number"
+		flags = []
+		align = item[:keys]["align"] || "right"
+		fail_at(item[:line], "align must be left or right") unless %w(left right).include?(align)
+		flags << (align == "left" ? "NUMFIELD_ALIGN_LEFT" : "NUMFIELD_ALIGN_RIGHT")
+		flags << "NUMFIELD_ZERO_PAD" if item[:keys].has_key?("zeropad")
+		flags.join(" | ")
+	when "bar", "gauge"
+		flags = styles(item).map do |style|
+			STYLE_FLAGS[item[:type]][style] or fail_at(item[:line], "unknown #{item[:type]} style '#{style}'")
+		end
+		flags.empty? ? "0" : flags.join(" | ")
+	else
+		"0"
+	end
+end
+
+
+# ---- Parse ----
+
+$source = ARGV[0] or abort "usage: layout2c.rb <file.layout> [output directory]"
+output_dir = ARGV[1] || "."
+
+name = nil
+signals = {}
+items = []
+included = []
+
+parse = lambda do |path|
+	fail_at(path, "included more than once") if included.include?(File.expand_path(path))
+	included << File.expand_path(path)
+
+	File.readlines(path).each_with_index do |raw, index|
+		location = "#{path}:#{index + 1}"
+		line = raw.sub(/#.*/, "").strip
+		next if line.empty?
+		words = tokenize(line, location)
+
+		case words[0]
+		when "layout"
+			fail_at(location, "layout needs one name") unless words.length == 2 && words[1] =~ /\A[a-z]\w*\z/
+			name = words[1]
+		when "signal"
+			fail_at(location, "signal needs a name and an id") unless words.length == 3 && words[2] =~ /\A\d+\z/
+			id = words[2].to_i
+			fail_at(location, "signal id must be below 255") if id >= 255
+			fail_at(location, "signal '#{words[1]}' defined twice") if signals.has_key?(words[1])
+			signals[words[1]] = id
+		when "include"
+			fail_at(location, "include needs one quoted file name") unless words.length == 2 && words[1] =~ /\A"(.+)"\z/
+			file = File.expand_path($1, File.dirname(path))
+			fail_at(location, "cannot read '#{$1}'") unless File.readable?(file)
+			parse.call(file)
+		else
+			type = TYPES[words[0]] or fail_at(location, "unknown statement '#{words[0]}'")
+			keys = {}
+			words[1..-1].each do |word|
+				key, value = word.split("=", 2)
+				fail_at(location, "unknown key '#{key}' for #{words[0]}") unless (type[:required] + type[:optional]).include?(key)
+				keys[key] = value || ""
+			end
+			missing = type[:required] - keys.keys
+			fail_at(location, "missing #{missing.join(', ')} for #{words[0]}") unless missing.empty?
+			items << { :type => words[0], :keys => keys, :line => location }
+		end
+	end
+end
+
+parse.call($source)
+
+abort "#{$source}: no layout statement" if name.nil?
+abort "#{$source}: no items" if items.empty?
+abort "#{$source}: more than 255 items" if items.length > 255
+
+
+# ---- Check regions ----
+
+items.each do |item|
+	item[:region] = region(item)
+	left, top, right, bottom = item[:region]
+	if right >= LCD_WIDTH || bottom >= LCD_HEIGHT
+		fail_at(item[:line], "#{item[:type]} does not fit on the LCD (#{left},#{top})-(#{right},#{bottom})")
+	end
+	if item[:keys].has_key?("signal") && !signals.has_key?(item[:keys]["signal"])
+		fail_at(item[:line], "unknown signal '#{item[:keys]['signal']}'")
+	end
+end
+
+items.combination(2) do |a, b|
+	al, at, ar, ab = a[:region]
+	bl, bt, br, bb = b[:region]
+	if al <= br && bl <= ar && at <= bb && bt <= ab
+		fail_at(b[:line], "#{b[:type]} overlaps #{a[:type]} at #{a[:line]}")
+	end
+end
+
+# Draw page by page, left to right, keeping source order for ties.
+items = items.each_with_index.sort_by { |item, index| [item[:region][1] / PAGE_HEIGHT, item[:region][0], index] }.map(&:first)
+
+
+# ---- Generate ----
+
+prefix = "layout_#{name}"
+guard = "LAYOUT_#{name.upcase}_H"
+table = "LAYOUT_#{name}"
+declarations = []
+rows = []
+
+items.each_with_index do |item, index|
+	keys = item[:keys]
+	signal = keys.has_key?("signal") ? "LAYOUT_#{name.upcase}_SIGNAL_#{keys['signal'].upcase}" : "LAYOUT_NO_SIGNAL"
+	text = "NULL"
+	state = "NULL"
+	buffer = "NULL"
+	x = integer(item, "x")
+	y = 0
+	width = 0
+	height = 0
+	arg = [0, 0, 0, 0]
+	range = 0
+
+	label = string(item, item[:type] == "label" ? "text" : "units")
+	unless label.nil?
+		text = "#{prefix}_text#{index}"
+		declarations << "static char const CAL_PGM_DEF(#{text}[]) = #{c_string(label)};"
+	end
+
+	case item[:type]
+	when "label"
+		y = integer(item, "page")
+	when "number"
+		y = integer(item, "page")
+		width = integer(item, "width")
+		arg = [integer(item, "decimals", 0), integer(item, "shift", 0), 0, 0]
+		range = integer(item, "mul", 1)
+		state = "&#{prefix}_state#{index}"
+		declarations << "static NUMFIELD_field_t #{prefix}_state#{index};"
+	when "bar"
+		y = integer(item, "y")
+		width = integer(item, "length")
+		height = integer(item, "thickness")
+		arg = [integer(item, "segment", 0), integer(item, "peakhold", 0), 0, 0]
+		range = integer(item, "max")
+		state = "&#{prefix}_state#{index}"
+		declarations << "static BAR_bar_t #{prefix}_state#{index};"
+	when "bignumber", "battery"
+		y = integer(item, "page")
+		state = "&#{prefix}_state#{index}"
+		declarations << "static uint8_t #{prefix}_state#{index};"
+	when "gauge"
+		y = integer(item, "page")
+		width = integer(item, "width")
+		height = integer(item, "pages")
+		arg = [integer(item, "cx"), integer(item, "cy"), integer(item, "radius"), integer(item, "ticks", 0)]
+		fail_at(item[:line], "gauge radius must be 127 or less") if arg[2] > 127
+		range = integer(item, "max")
+		state = "&#{prefix}_state#{index}"
+		buffer = "#{prefix}_buffer#{index}"
+		declarations << "static GAUGE_gauge_t #{prefix}_state#{index};"
+		declarations << "static uint8_t #{buffer}[GAUGE_PAGEBUFFER_SIZE( #{width}, #{height} )];"
+	when "chart"
+		y = integer(item, "page")
+		width = integer(item, "width")
+		height = integer(item, "pages")
+		fail_at(item[:line], "chart can be at most 4 pages high") if height > 4
+		arg = [integer(item, "samples", 1), 0, 0, 0]
+		state = "&#{prefix}_state#{index}"
+		buffer = "#{prefix}_buffer#{index}"
+		# Column ring followed by page buffer, rounded up to whole columns.
+		columns = width + (width * height + CHART_COLUMN_SIZE - 1) / CHART_COLUMN_SIZE
+		declarations << "static CHART_chart_t #{prefix}_state#{index};"
+		declarations << "static CHART_column_t #{buffer}[#{columns}];"
+	end
+
+	[x, y, width, height].each { |v| fail_at(item[:line], "value #{v} out of range") if v > 255 }
+	fail_at(item[:line], "value #{range} out of range") if range > 65535
+
+	rows << "\t{ LAYOUT_TYPE_#{item[:type].upcase}, #{signal}, #{x}, #{y}, #{width}, #{height}, " +
+	        "#{style_expression(item)}, { #{arg.join(', ')} }, #{range}, #{text}, #{state}, #{buffer} },  // #{File.basename(item[:line])}"
+end
+
+# Signal map: item indexes grouped by signal ID.
+signal_count = signals.empty? ? 0 : signals.values.max + 1
+signal_start = []
+signal_items = []
+(0...signal_count).each do |id|
+	signal_start << signal_items.length
+	items.each_with_index do |item, index|
+		signal_items << index if signals[item[:keys]["signal"]] == id
+	end
+end
+signal_start << signal_items.length
+signal_items << 0 if signal_items.empty?
+
+header = []
+header << "// Generated by utils/layout/layout2c.rb from #{File.basename($source)}, do not edit."
+header << "#ifndef #{guard}"
+header << "#define #{guard}"
+header << ""
+header << "#include <layout_lib.h>"
+header << ""
+signals.sort_by { |signal, id| id }.each do |signal, id|
+	header << "#define LAYOUT_#{name.upcase}_SIGNAL_#{signal.upcase} #{id}"
+end
+header << ""
+header << "extern LAYOUT_layout_t const CAL_PGM(#{table});"
+header << ""
+header << "#endif"
+
+source = []
+source << "// Generated by utils/layout/layout2c.rb from #{File.basename($source)}, do not edit."
+source << ""
+source << "#include \"#{prefix}.h\""
+source << "#include <stddef.h>"
+source << "#include <numfield_lib.h>"
+source << "#include <bar_lib.h>"
+source << "#include <gauge_lib.h>"
+source << "#include <chart_lib.h>"
+source << ""
+source.concat(declarations)
+source << ""
+source << "static LAYOUT_item_t const CAL_PGM_DEF(#{prefix}_items[#{items.length}]) = {"
+source.concat(rows)
+source << "};"
+source << ""
+source << "static uint8_t const CAL_PGM_DEF(#{prefix}_signalStart[#{signal_start.length}]) = { #{signal_start.join(', ')} };"
+source << "static uint8_t const CAL_PGM_DEF(#{prefix}_signalItems[#{signal_items.length}]) = { #{signal_items.join(', ')} };"
+source << ""
+source << "LAYOUT_layout_t const CAL_PGM_DEF(#{table}) = {"
+source << "\t#{prefix}_items, #{items.length}, #{signal_count}, #{prefix}_signalStart, #{prefix}_signalItems"
+source << "};"
+
+File.open(File.join(output_dir, "#{prefix}.h"), "w") { |f| f.puts header }
+File.open(File.join(output_dir, "#{prefix}.c"), "w") { |f| f.puts source }
+puts "#{items.length} items, #{signal_count} signals -> #{File.join(output_dir, prefix)}.[ch]"